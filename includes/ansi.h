@@ -22,7 +22,11 @@
  */
 #pragma once
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
 
 namespace ac
 {
@@ -51,9 +55,184 @@ namespace ac
         BRIGHT_WHITE = 97,   ///< Bright white color
     };
 
+    /**
+     * @enum ansi_color_type
+     * @brief Enumeration of the palettes of an ansi_extended_color.
+     */
+    enum class ansi_color_type : std::uint8_t
+    {
+        BASIC,   ///< One of the 16 basic colors.
+        INDEXED, ///< One of the 256 colors of the extended palette.
+        RGB      ///< A 24-bit color.
+    };
+
+    /**
+     * @class ansi_extended_color
+     * @brief A terminal color from the basic, 256 color or 24-bit palettes.
+     *
+     * Implicitly constructible from ansi_color, so that basic colors can be used anywhere.
+     */
+    class ansi_extended_color
+    {
+    public:
+        /**
+         * @brief Constructs a basic color.
+         * @param nColor The basic color.
+         */
+        constexpr ansi_extended_color(ansi_color nColor = ansi_color::WHITE)
+            : m_nType(ansi_color_type::BASIC), m_nBasic(nColor), m_nIndex(0), m_nRed(0), m_nGreen(0), m_nBlue(0) {}
+
+        /**
+         * @brief Constructs a color of the 256 color palette.
+         * @param nIndex The index of the color: 0-15 basic colors, 16-231 6x6x6 cube, 232-255 grays.
+         * @return The color.
+         */
+        static constexpr ansi_extended_color indexed(std::uint8_t nIndex);
+
+        /**
+         * @brief Constructs a 24-bit color.
+         * @param nRed The red component.
+         * @param nGreen The green component.
+         * @param nBlue The blue component.
+         * @return The color.
+         */
+        static constexpr ansi_extended_color rgb(std::uint8_t nRed, std::uint8_t nGreen, std::uint8_t nBlue);
+
+    public:
+        /**
+         * @brief Gets the palette of the color.
+         * @return The type of the color.
+         */
+        constexpr ansi_color_type get_type() const;
+
+        /**
+         * @brief Gets the basic color. Only meaningful for basic colors.
+         * @return The basic color.
+         */
+        constexpr ansi_color get_basic() const;
+
+        /**
+         * @brief Gets the palette index. Only meaningful for indexed colors.
+         * @return The index in the 256 color palette.
+         */
+        constexpr std::uint8_t get_index() const;
+
+        /**
+         * @brief Gets the red component. Only meaningful for 24-bit colors.
+         * @return The red component.
+         */
+        constexpr std::uint8_t get_red() const;
+
+        /**
+         * @brief Gets the green component. Only meaningful for 24-bit colors.
+         * @return The green component.
+         */
+        constexpr std::uint8_t get_green() const;
+
+        /**
+         * @brief Gets the blue component. Only meaningful for 24-bit colors.
+         * @return The blue component.
+         */
+        constexpr std::uint8_t get_blue() const;
+
+        /**
+         * @brief Gets the closest basic color, for terminals without extended palettes.
+         * @return The basic color closest to this color.
+         */
+        ansi_color get_closest_basic() const;
+
+        /**
+         * @brief Compares two colors.
+         * @param oColor The other color.
+         * @return true if both colors are the same, false otherwise.
+         */
+        constexpr bool operator==(const ansi_extended_color &oColor) const = default;
+
+    private:
+        ansi_color_type m_nType; ///< The palette of the color.
+        ansi_color m_nBasic;     ///< The basic color.
+        std::uint8_t m_nIndex;   ///< The index in the 256 color palette.
+        std::uint8_t m_nRed;     ///< The red component.
+        std::uint8_t m_nGreen;   ///< The green component.
+        std::uint8_t m_nBlue;    ///< The blue component.
+    };
+
+    /**
+     * @class ansi_sgr
+     * @brief A precomputed SGR escape sequence setting the foreground or background color.
+     *
+     * Encoding a color formats numbers; renderers encode their colors once and write the
+     * stored bytes on every color switch.
+     */
+    class ansi_sgr
+    {
+    public:
+        /// Maximum length of a sequence, "\033[48;2;255;255;255m".
+        static constexpr std::size_t MAX_SIZE = 19;
+
+    public:
+        /**
+         * @brief Constructs an empty sequence.
+         */
+        ansi_sgr();
+
+        /**
+         * @brief Encodes a foreground color.
+         * @param oColor The color.
+         * @return The sequence.
+         */
+        static ansi_sgr foreground(const ansi_extended_color &oColor);
+
+        /**
+         * @brief Encodes a background color.
+         * @param oColor The color.
+         * @return The sequence.
+         */
+        static ansi_sgr background(const ansi_extended_color &oColor);
+
+    public:
+        /**
+         * @brief Gets the bytes of the sequence.
+         * @return The escape sequence.
+         */
+        std::string_view get_sequence() const noexcept;
+
+        /**
+         * @brief Gets the encoded color.
+         * @return The color.
+         */
+        const ansi_extended_color &get_color() const noexcept;
+
+        /**
+         * @brief Checks if the sequence sets the background color.
+         * @return true for background colors, false for foreground colors.
+         */
+        bool is_background() const noexcept;
+
+    private:
+        std::array<char, MAX_SIZE> m_aData; ///< The bytes of the sequence.
+        std::uint8_t m_nSize;               ///< The length of the sequence.
+        bool m_bBackground;                 ///< Whether it sets the background.
+        ansi_extended_color m_oColor;       ///< The encoded color.
+
+    private:
+        /**
+         * @brief Encodes a color.
+         * @param oColor The color.
+         * @param bBackground true to set the background, false to set the foreground.
+         */
+        ansi_sgr(const ansi_extended_color &oColor, bool bBackground);
+    };
+
     namespace ansi
     {
 
+        /// Default number of bytes that may wait in the non-blocking output before frames are dropped.
+        inline constexpr std::size_t DEFAULT_OUTPUT_CAPACITY = 64 * 1024;
+
+        /// Default time between the keyframes of a recording, in seconds.
+        inline constexpr double DEFAULT_KEYFRAME_INTERVAL = 5.0;
+
         /**
          * @brief Sets the foreground color of the terminal output.
          * @param nColor The color to set as the foreground color, specified as an ansi_color enum.
@@ -72,13 +251,73 @@ namespace ac
          */
         void reset_ansi_colors();
 
+        /**
+         * @brief Sets the foreground or background color with a precomputed sequence.
+         *
+         * On Windows consoles the closest basic color is set instead.
+         * @param oSgr The sequence, as encoded by ansi_sgr.
+         */
+        void set_ansi_color(const ansi_sgr &oSgr);
+
         /**
          * @brief Moves the cursor to a specified position in the terminal.  Origin: (0,0).
+         *
+         * When the position of the cursor is known, the shortest motion is written: nothing,
+         * carriage return and line feeds, relative motions (CUU, CUD, CUF, CUB), a column
+         * (CHA) or an absolute position (CUP). Otherwise the position is absolute.
          * @param x The x-coordinate (column) to move the cursor to. Origin: 0.
          * @param y The y-coordinate (row) to move the cursor to. Origin: 0.
          */
         void move_ansi_cursor(std::size_t x, std::size_t y);
 
+        /**
+         * @brief Records that text was written after moving the cursor, so that it moved right.
+         *
+         * Writers tracking the cursor call it after every glyph, so that the next
+         * move_ansi_cursor can be relative. The position is forgotten when the cursor may
+         * have wrapped past the right edge of the terminal.
+         * @param nColumns The number of cells written.
+         */
+        void advance_ansi_cursor(std::size_t nColumns);
+
+        /**
+         * @brief Forgets the position of the cursor, so that the next move is absolute.
+         *
+         * Must be called after writing anything not recorded with advance_ansi_cursor.
+         * Clearing the screen, resizing it and switching screens forget it already.
+         */
+        void forget_ansi_cursor();
+
+        /**
+         * @brief Checks if the terminal repeats the last character written (REP).
+         *
+         * Terminals can not be asked for it, so it is decided once from the TERM variable.
+         * Terminals reusing the TERM of another one may still ignore the sequence.
+         * @return True if the standard output may be a terminal supporting the sequence.
+         */
+        bool supports_repeat_characters();
+
+        /**
+         * @brief Checks if the terminal erases characters (ECH) with the background color.
+         *
+         * Terminals can not be asked for it, so it is decided once from the TERM variable.
+         * Terminals reusing the TERM of another one may still ignore the sequence.
+         * @return True if the standard output may be a terminal supporting the sequence.
+         */
+        bool supports_erase_characters();
+
+        /**
+         * @brief Writes a glyph several times, as a short sequence when the terminal supports it.
+         *
+         * Long runs are written with the glyph followed by a repeat (REP) or, for blanks,
+         * erased (ECH) and skipped, whichever is shorter among the sequences the terminal
+         * supports. Short runs and other terminals get the literal glyphs. The tracked
+         * cursor is advanced.
+         * @param sGlyph The glyph, taking one cell.
+         * @param nCount The number of times it is written.
+         */
+        void write_ansi_repeated(std::string_view sGlyph, std::size_t nCount);
+
         /**
          * @brief Reserves an ANSI terminal with the specified width and height.
          *
@@ -105,6 +344,228 @@ namespace ac
          */
         void clear_screen();
 
+        /**
+         * @brief Queries the size of the terminal attached to the standard output.
+         * @param nWidth Receives the width of the terminal in characters.
+         * @param nHeight Receives the height of the terminal in characters.
+         * @return True if the size is known, false if the output is not a terminal.
+         */
+        bool get_terminal_size(std::size_t &nWidth, std::size_t &nHeight);
+
+        /**
+         * @brief Starts counting the resizes of the terminal.
+         *
+         * On Unix-like systems a SIGWINCH handler is installed, calling any handler installed
+         * before it. Calling it again has no effect. Windows consoles are not watched.
+         */
+        void watch_terminal_resize();
+
+        /**
+         * @brief Gets the number of times the terminal was resized since it is watched.
+         *
+         * A burst of resizes only needs to be handled once: compare the count with the
+         * one seen on the last redraw.
+         * @return The number of resize signals received.
+         */
+        std::size_t get_terminal_resize_count();
+
+        /**
+         * @brief Checks if the terminal supports synchronized output (DEC private mode 2026).
+         *
+         * The terminal is asked once with a mode report request (DECRQM), followed by a
+         * device attributes request that every terminal answers, so that terminals ignoring
+         * the first request are detected without waiting for the timeout. The answer is cached.
+         * Pending keyboard input may be discarded while the answer is read, so call it before
+         * anything else reads the standard input. The renderers never call it: terminals
+         * without the mode ignore its sequences.
+         * @return True if the standard input and output are a terminal supporting the mode.
+         */
+        bool supports_synchronized_output();
+
+        /**
+         * @brief Starts a synchronized update: the terminal holds the output until it ends.
+         *
+         * Terminals without synchronized output ignore it. Does nothing on Windows.
+         */
+        void begin_synchronized_update();
+
+        /**
+         * @brief Ends a synchronized update, letting the terminal present the whole frame.
+         */
+        void end_synchronized_update();
+
+        /**
+         * @brief Switches to the alternate screen buffer.
+         *
+         * Has no effect if already on it. The main screen is restored at exit.
+         */
+        void enter_alternate_screen();
+
+        /**
+         * @brief Switches back to the main screen buffer.
+         *
+         * Has no effect if not on the alternate screen.
+         */
+        void leave_alternate_screen();
+
+        /**
+         * @brief Hides the cursor.
+         */
+        void hide_cursor();
+
+        /**
+         * @brief Shows the cursor.
+         */
+        void show_cursor();
+
+        /**
+         * @brief Sends the standard output to the terminal from a writer thread, so that writing never blocks.
+         *
+         * Everything written to std::cout is queued in memory and written by a background
+         * thread to its own non-blocking descriptor of the terminal, so a stalled terminal
+         * or network link does not stall the application. The output between
+         * begin_output_frame and end_output_frame is queued as one frame. Once the queue
+         * holds more than nCapacity bytes, frames are dropped until a complete frame
+         * replaces the whole queue, and take_dropped_output reports it so that the screen
+         * is redrawn with the latest state.
+         * The queue is drained and std::cout restored by disable_nonblocking_output, or at exit.
+         * @param nCapacity Number of bytes that may wait in the queue before frames are dropped.
+         * @return True if enabled. Not supported on Windows.
+         */
+        bool enable_nonblocking_output(std::size_t nCapacity = DEFAULT_OUTPUT_CAPACITY);
+
+        /**
+         * @brief Writes the queued output, waiting for the terminal, and writes std::cout directly again.
+         */
+        void disable_nonblocking_output();
+
+        /**
+         * @brief Checks if the standard output goes through the writer thread.
+         * @return True if enable_nonblocking_output is in effect.
+         */
+        bool is_nonblocking_output();
+
+        /**
+         * @brief Starts a frame: the output is queued when the frame ends, not when flushed.
+         *
+         * Frames can be nested; the outermost one is queued. Does nothing without
+         * enable_nonblocking_output.
+         */
+        void begin_output_frame();
+
+        /**
+         * @brief Ends a frame, queueing or dropping its output as a whole.
+         * @param bComplete True if the frame redraws the whole screen, so that it can replace
+         *                  the frames still waiting in the queue.
+         */
+        void end_output_frame(bool bComplete);
+
+        /**
+         * @brief Checks if frames were dropped since the last call.
+         * @return True if frames were dropped since the last call.
+         */
+        bool take_dropped_output();
+
+        /**
+         * @brief Shares the standard output with spectators connecting to a Unix socket.
+         *
+         * Enables the non-blocking output if needed: the frames are encoded once and the
+         * same bytes are queued for the terminal and every spectator, written by the same
+         * thread. A spectator receives the output from the next complete frame on; joining
+         * or falling behind makes take_dropped_output report it, so that the screen is
+         * redrawn. Spectators lagging by more than the capacity of the queue drop frames
+         * on their own, and are disconnected when their socket fails. A socket left at the
+         * path by a previous run is replaced. Broadcasting again replaces the socket.
+         * @param sPath The path of the socket.
+         * @return True if listening. Not supported on Windows.
+         * @throws std::invalid_argument if the path does not fit in a socket address.
+         * @throws std::runtime_error if the socket can not be listened on.
+         */
+        bool broadcast_output(const std::string &sPath);
+
+        /**
+         * @brief Stops listening for spectators, disconnects them and removes the socket.
+         */
+        void stop_broadcast();
+
+        /**
+         * @brief Gets the number of spectators connected to the socket of broadcast_output.
+         * @return The number of spectators.
+         */
+        std::size_t get_spectator_count();
+
+        /**
+         * @brief Records the standard output to an asciicast v2 file.
+         *
+         * Enables the non-blocking output if needed. Every frame is appended to the file with
+         * its time by the writer thread, through a large buffer, so the renderer only queues a
+         * shared reference to it. Complete frames are keyframes, preceded by a "keyframe" marker
+         * event, so that a replay can seek without playing from the start. When the last keyframe
+         * is older than dKeyframeInterval, take_dropped_output asks for a complete frame. The
+         * recording starts with the first keyframe. Recording again replaces the recording.
+         * @param sPath The path of the file, overwritten.
+         * @param nWidth The width of the recorded screen, for the header.
+         * @param nHeight The height of the recorded screen, for the header.
+         * @param dKeyframeInterval The time between keyframes, in seconds.
+         * @return True if recording. Not supported on Windows.
+         * @throws std::invalid_argument if the keyframe interval is not positive.
+         * @throws std::runtime_error if the file can not be written.
+         */
+        bool record_output(const std::string &sPath, std::size_t nWidth, std::size_t nHeight, double dKeyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+
+        /**
+         * @brief Writes the output waiting for the recording and closes it.
+         */
+        void stop_recording();
+
     } // namespace ansi
 
+    constexpr ansi_extended_color ansi_extended_color::indexed(std::uint8_t nIndex)
+    {
+        ansi_extended_color oColor;
+        oColor.m_nType = ansi_color_type::INDEXED;
+        oColor.m_nIndex = nIndex;
+        return oColor;
+    }
+
+    constexpr ansi_extended_color ansi_extended_color::rgb(std::uint8_t nRed, std::uint8_t nGreen, std::uint8_t nBlue)
+    {
+        ansi_extended_color oColor;
+        oColor.m_nType = ansi_color_type::RGB;
+        oColor.m_nRed = nRed;
+        oColor.m_nGreen = nGreen;
+        oColor.m_nBlue = nBlue;
+        return oColor;
+    }
+
+    constexpr ansi_color_type ansi_extended_color::get_type() const
+    {
+        return this->m_nType;
+    }
+
+    constexpr ansi_color ansi_extended_color::get_basic() const
+    {
+        return this->m_nBasic;
+    }
+
+    constexpr std::uint8_t ansi_extended_color::get_index() const
+    {
+        return this->m_nIndex;
+    }
+
+    constexpr std::uint8_t ansi_extended_color::get_red() const
+    {
+        return this->m_nRed;
+    }
+
+    constexpr std::uint8_t ansi_extended_color::get_green() const
+    {
+        return this->m_nGreen;
+    }
+
+    constexpr std::uint8_t ansi_extended_color::get_blue() const
+    {
+        return this->m_nBlue;
+    }
+
 } // namespace ac
@@ -26,6 +26,13 @@
 #include "card_renderer.h"
 #include "ansi.h"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace ac
 {
 
@@ -35,6 +42,8 @@ namespace ac
      *
      * This class provides methods to render cards with different nColors for
      * suits and a background nColor. It inherits from the card_renderer class.
+     * Colors may be basic, from the 256 color palette or 24-bit; they are encoded
+     * once when set.
      */
     class ansi_card_renderer : public card_renderer
     {
@@ -67,7 +76,8 @@ namespace ac
         /**
          * @brief Default constructor.
          *
-         * Initializes the card renderer with default ANSI colors.
+         * Initializes the card renderer with the default colors of the built-in decks
+         * (see deck_definition.h).
          */
         ansi_card_renderer();
 
@@ -95,17 +105,17 @@ namespace ac
             std::size_t nCardHeight,
             std::size_t nTableWidth,
             std::size_t nTableHeight,
-            ansi_color nClubsColor,
-            ansi_color nHeartsColor,
-            ansi_color nDiamondsColor,
-            ansi_color nSpadesColor,
-            ansi_color nGoldsColor,
-            ansi_color nCupsColor,
-            ansi_color nSwordsColor,
-            ansi_color nJokersColor,
-            ansi_color nFrameColor,
-            ansi_color nBackgroundColor,
-            ansi_color nCardPaperColor);
+            ansi_extended_color nClubsColor,
+            ansi_extended_color nHeartsColor,
+            ansi_extended_color nDiamondsColor,
+            ansi_extended_color nSpadesColor,
+            ansi_extended_color nGoldsColor,
+            ansi_extended_color nCupsColor,
+            ansi_extended_color nSwordsColor,
+            ansi_extended_color nJokersColor,
+            ansi_extended_color nFrameColor,
+            ansi_extended_color nBackgroundColor,
+            ansi_extended_color nCardPaperColor);
 
     public:
         /**
@@ -119,105 +129,211 @@ namespace ac
          */
         virtual void render_card(const number *pCard, point oPos) const override;
 
+        /**
+         * @brief Renders the exposed part of a card.
+         *
+         * Only the cells inside the exposed rectangles are written to the terminal.
+         *
+         * @param pCard Pointer to the card to be rendered.
+         * @param oPos The position where the card should be rendered.
+         * @param vExposed The exposed parts of the card, in table cells.
+         */
+        virtual void render_card(const number *pCard, point oPos, std::span<const rect> vExposed) const override;
+
         /**
          * @brief Renders the card table.
          *
          * This method outputs the card representation to the terminal using
-         * ANSI colors.
+         * ANSI colors. The screen is cleared, unless the table is drawn in a viewport:
+         * then only the cells of the viewport are painted.
          *
          */
         virtual void render_table() const override;
 
+        /**
+         * @brief Renders regions of the card table.
+         *
+         * Cells inside the table are painted with the table color, cells outside
+         * of it are cleared with the default colors.
+         *
+         * @param vRegions The regions to render, in table cells.
+         */
+        virtual void render_table(std::span<const rect> vRegions) const override;
+
+        /**
+         * @brief Checks if the renderer draws regions of the table and clips cards.
+         * @return Always true.
+         */
+        virtual bool can_render_regions() const override;
+
+        /**
+         * @brief Gets the glyphs of a card taking more than one cell.
+         *
+         * Suits and numbers are laid out by their display width, so wide and emoji glyphs
+         * take two cells. The card is laid out once per call.
+         * @param pCard Pointer to the card number.
+         * @param vGlyphs Receives the cells of every wide glyph, relative to the card.
+         */
+        virtual void get_wide_glyphs(const number *pCard, std::vector<rect> &vGlyphs) const override;
+
+        /**
+         * @brief Fits the table to the terminal after it was resized.
+         *
+         * Only when fitting the terminal (see set_fit_terminal). The terminal is queried
+         * once per burst of resizes. Also asks for a full redraw when frames were dropped by
+         * a congested terminal (see ansi::enable_nonblocking_output), except in a viewport,
+         * where the whole terminal is redrawn by ansi_compositor::refresh.
+         * @return True if the visible size of the table changed or frames were dropped.
+         */
+        virtual bool update_size() const override;
+
+        /**
+         * @brief Starts a frame.
+         *
+         * Starts an output frame (see ansi::begin_output_frame), switches to the alternate
+         * screen if requested, hides the cursor and starts a synchronized update, which
+         * terminals without it ignore.
+         */
+        virtual void begin_frame() const override;
+
+        /**
+         * @brief Ends a frame, presenting it at once on terminals supporting synchronized output.
+         *
+         * Frames rendering the whole table are complete output frames, that replace the
+         * frames still queued for a congested terminal.
+         */
+        virtual void end_frame() const override;
+
     public:
         /**
          * @brief Gets the card width.
          * @return The ANSI card width.
          */
-        std::size_t get_card_width() const;
+        virtual std::size_t get_card_width() const override;
 
         /**
          * @brief Gets the card height.
          * @return The ANSI card width.
          */
-        std::size_t get_card_height() const;
+        virtual std::size_t get_card_height() const override;
 
         /**
          * @brief Gets the table width.
+         *
+         * When fitting the terminal, it is at most the width of the terminal.
          * @return The ANSI table width.
          */
         std::size_t get_table_width() const;
 
         /**
          * @brief Gets the table height.
+         *
+         * When fitting the terminal, it is at most the height of the terminal.
          * @return The ANSI table width.
          */
         std::size_t get_table_height() const;
 
         /**
          * @brief Gets the color for hearts.
-         * @return The ANSI color for hearts.
+         * @return The color for hearts.
          */
-        ansi_color get_hearts_color() const;
+        ansi_extended_color get_hearts_color() const;
 
         /**
          * @brief Gets the color for clubs.
-         * @return The ANSI color for clubs.
+         * @return The color for clubs.
          */
-        ansi_color get_clubs_color() const;
+        ansi_extended_color get_clubs_color() const;
 
         /**
          * @brief Gets the color for diamonds.
-         * @return The ANSI color for diamonds.
+         * @return The color for diamonds.
          */
-        ansi_color get_diamonds_color() const;
+        ansi_extended_color get_diamonds_color() const;
 
         /**
          * @brief Gets the color for spades.
-         * @return The ANSI color for spades.
+         * @return The color for spades.
          */
-        ansi_color get_spades_color() const;
+        ansi_extended_color get_spades_color() const;
 
         /**
          * @brief Gets the color for golds.
-         * @return The ANSI color for golds.
+         * @return The color for golds.
          */
-        ansi_color get_golds_color() const;
+        ansi_extended_color get_golds_color() const;
 
         /**
          * @brief Gets the color for cups.
-         * @return The ANSI color for cups.
+         * @return The color for cups.
          */
-        ansi_color get_cups_color() const;
+        ansi_extended_color get_cups_color() const;
 
         /**
          * @brief Gets the color for swords.
-         * @return The ANSI color for swords.
+         * @return The color for swords.
          */
-        ansi_color get_swords_color() const;
+        ansi_extended_color get_swords_color() const;
 
         /**
          * @brief Gets the color for jokers.
-         * @return The ANSI color for jokers.
+         * @return The color for jokers.
          */
-        ansi_color get_jokers_color() const;
+        ansi_extended_color get_jokers_color() const;
 
         /**
          * @brief Gets the card frame color.
-         * @return The ANSI card frame color.
+         * @return The card frame color.
          */
-        ansi_color get_frame_color() const;
+        ansi_extended_color get_frame_color() const;
 
         /**
          * @brief Gets the card paper color.
-         * @return The ANSI card paper color.
+         * @return The card paper color.
          */
-        ansi_color get_card_paper_color() const;
+        ansi_extended_color get_card_paper_color() const;
 
         /**
          * @brief Gets the table color.
-         * @return The ANSI table color.
+         * @return The table color.
+         */
+        ansi_extended_color get_table_color() const;
+
+        /**
+         * @brief Checks if the table is fitted to the terminal.
+         * @return True if the table and the cards are clipped to the terminal.
+         */
+        bool get_fit_terminal() const;
+
+        /**
+         * @brief Checks if frames are wrapped in synchronized updates.
+         * @return True if synchronized output is used when the terminal supports it.
+         */
+        bool get_synchronized_output() const;
+
+        /**
+         * @brief Checks if the table is drawn on the alternate screen.
+         * @return True if the alternate screen is used.
+         */
+        bool get_alternate_screen() const;
+
+        /**
+         * @brief Checks if runs of identical cells are written as repeat or erase sequences.
+         * @return True if run-length encoding is used when the terminal supports it.
+         */
+        bool get_run_length_encoding() const;
+
+        /**
+         * @brief Checks if the table is drawn in a viewport of the terminal.
+         * @return True if a viewport is set.
          */
-        ansi_color get_table_color() const;
+        bool has_viewport() const;
+
+        /**
+         * @brief Gets the viewport of the terminal the table is drawn in.
+         * @return The viewport, spanning the whole terminal when none is set.
+         */
+        rect get_viewport() const;
 
     public:
         /**
@@ -254,86 +370,231 @@ namespace ac
 
         /**
          * @brief Sets the color for clubs.
-         * @param nColor The ANSI color to set for clubs.
+         * @param nColor The color to set for clubs.
          */
-        void set_clubs_color(ansi_color nColor);
+        void set_clubs_color(ansi_extended_color nColor);
 
         /**
          * @brief Sets the color for hearts.
-         * @param nColor The ANSI color to set for hearts.
+         * @param nColor The color to set for hearts.
          */
-        void set_hearts_color(ansi_color nColor);
+        void set_hearts_color(ansi_extended_color nColor);
 
         /**
          * @brief Sets the color for diamonds.
-         * @param nColor The ANSI color to set for diamonds.
+         * @param nColor The color to set for diamonds.
          */
-        void set_diamonds_color(ansi_color nColor);
+        void set_diamonds_color(ansi_extended_color nColor);
 
         /**
          * @brief Sets the color for spades.
-         * @param nColor The ANSI color to set for spades.
+         * @param nColor The color to set for spades.
          */
-        void set_spades_color(ansi_color nColor);
+        void set_spades_color(ansi_extended_color nColor);
 
         /**
          * @brief Sets the color for golds.
-         * @param nColor The ANSI color to set for golds.
+         * @param nColor The color to set for golds.
          */
-        void set_golds_color(ansi_color nColor);
+        void set_golds_color(ansi_extended_color nColor);
 
         /**
          * @brief Sets the color for cups.
-         * @param nColor The ANSI color to set for cups.
+         * @param nColor The color to set for cups.
          */
-        void set_cups_color(ansi_color nColor);
+        void set_cups_color(ansi_extended_color nColor);
 
         /**
          * @brief Sets the color for swords.
-         * @param nColor The ANSI color to set for swords.
+         * @param nColor The color to set for swords.
          */
-        void set_swords_color(ansi_color nColor);
+        void set_swords_color(ansi_extended_color nColor);
 
         /**
          * @brief Sets the color for jokers.
-         * @param nColor The ANSI color to set for jokers.
+         * @param nColor The color to set for jokers.
          */
-        void set_jokers_color(ansi_color nColor);
+        void set_jokers_color(ansi_extended_color nColor);
 
         /**
          * @brief Sets the card frame color.
-         * @param nColor The ANSI color to set for the card frame.
+         * @param nColor The color to set for the card frame.
          */
-        void set_frame_color(ansi_color nColor);
+        void set_frame_color(ansi_extended_color nColor);
 
         /**
          * @brief Sets the card pape color.
-         * @param nColor The ANSI color to set for the card paper.
+         * @param nColor The color to set for the card paper.
          */
-        void set_card_paper_color(ansi_color nColor);
+        void set_card_paper_color(ansi_extended_color nColor);
 
         /**
          * @brief Sets the table color.
-         * @param nColor The ANSI color to set for the table.
+         * @param nColor The color to set for the table.
+         */
+        void set_table_color(ansi_extended_color nColor);
+
+        /**
+         * @brief Sets whether the table is fitted to the terminal.
+         *
+         * When fitting, the table is shrunk to the size of the terminal and the cells of the
+         * cards outside of it are not drawn, so that nothing wraps. Resizes of the terminal
+         * are watched (ansi::watch_terminal_resize) and picked by update_size.
+         * @param bFitTerminal True to fit the table to the terminal.
+         */
+        void set_fit_terminal(bool bFitTerminal);
+
+        /**
+         * @brief Sets whether frames are wrapped in synchronized updates (DEC mode 2026).
+         *
+         * Enabled by default. The terminal is not probed, as that would read the standard
+         * input while rendering: terminals not supporting the mode ignore the sequences and
+         * draw every frame as it is written.
+         * @param bSynchronizedOutput True to use synchronized output when supported.
+         */
+        void set_synchronized_output(bool bSynchronizedOutput);
+
+        /**
+         * @brief Sets whether the table is drawn on the alternate screen.
+         *
+         * The terminal switches to the alternate screen on the next frame, and back to
+         * the main screen when disabled or at exit. Disabled by default.
+         * @param bAlternateScreen True to use the alternate screen.
+         */
+        void set_alternate_screen(bool bAlternateScreen);
+
+        /**
+         * @brief Sets whether runs of identical cells are written as repeat (REP) or erase (ECH) sequences.
+         *
+         * Disabled by default: many terminals announce themselves as xterm without implementing
+         * the sequences, and would silently lose the repeated cells. Enable it only for terminals
+         * known to support them; those excluded by TERM (ansi::supports_repeat_characters,
+         * ansi::supports_erase_characters) still get the literal cells.
+         * @param bRunLengthEncoding True to use run-length encoding when supported.
+         */
+        void set_run_length_encoding(bool bRunLengthEncoding);
+
+        /**
+         * @brief Draws the table in a viewport of the terminal.
+         *
+         * The table is moved by the origin of the viewport and clipped to its size, and
+         * rendering the whole table no longer clears the screen. Usually set through
+         * ansi_compositor::add_viewport.
+         * @param oViewport The viewport, in terminal cells.
+         */
+        void set_viewport(const rect &oViewport);
+
+        /**
+         * @brief Draws the table on the whole terminal again.
          */
-        void set_table_color(ansi_color nColor);
+        void reset_viewport();
+
+    private:
+        /**
+         * @enum sgr_index
+         * @brief Indices of the encoded colors: foreground of the suits and the frame, background of the paper and the table.
+         */
+        enum sgr_index : std::size_t
+        {
+            CLUBS_SGR,      ///< Clubs.
+            HEARTS_SGR,     ///< Hearts.
+            DIAMONDS_SGR,   ///< Diamonds.
+            SPADES_SGR,     ///< Spades.
+            GOLDS_SGR,      ///< Golds.
+            CUPS_SGR,       ///< Cups.
+            SWORDS_SGR,     ///< Swords.
+            JOKERS_SGR,     ///< Jokers.
+            FRAME_SGR,      ///< Card frame.
+            CARD_PAPER_SGR, ///< Card paper.
+            TABLE_SGR,      ///< Table.
+            SGR_COUNT       ///< Number of encoded colors.
+        };
+
+        /**
+         * @struct card_face
+         * @brief The glyphs of a card, one per cell.
+         */
+        struct card_face
+        {
+            std::string m_sSuit;                     ///< The first glyph of the suit display name.
+            std::string m_sNumber;                   ///< The first glyph of the number display name.
+            std::vector<std::string_view> m_vGlyphs; ///< The glyph of every cell, empty on the second cell of wide glyphs.
+            std::vector<std::uint8_t> m_vWidths;     ///< The width of the glyph starting on every cell, 0 on the second cell of wide glyphs.
+            std::vector<bool> m_vSuitColored;        ///< Whether every cell is drawn with the suit color.
+        };
 
     private:
-        std::size_t m_nCardWidth;     ///< The card width
-        std::size_t m_nCardHeight;    ///< The card hight
-        std::size_t m_nTableWidth;    ///< The table width
-        std::size_t m_nTableHeight;   ///< The table hight
-        ansi_color m_nClubsColor;     ///< The ANSI color for clubs.
-        ansi_color m_nHeartsColor;    ///< The ANSI color for hearts.
-        ansi_color m_nDiamondsColor;  ///< The ANSI color for diamonds.
-        ansi_color m_nSpadesColor;    ///< The ANSI color for spades.
-        ansi_color m_nGoldsColor;     ///< The ANSI color for golds.
-        ansi_color m_nCupsColor;      ///< The ANSI color for cups.
-        ansi_color m_nSwordsColor;    ///< The ANSI color for swords.
-        ansi_color m_nJokersColor;    ///< The ANSI color for jokers.
-        ansi_color m_nFrameColor;     ///< The ANSI color for the card frame.
-        ansi_color m_nCardPaperColor; ///< The ANSI color for the card paper.
-        ansi_color m_nTableColor;     ///< The ANSI color for the table.
+        std::size_t m_nCardWidth;                           ///< The card width
+        std::size_t m_nCardHeight;                          ///< The card hight
+        std::size_t m_nTableWidth;                          ///< The table width
+        std::size_t m_nTableHeight;                         ///< The table hight
+        ansi_extended_color m_nClubsColor;                  ///< The ANSI color for clubs.
+        ansi_extended_color m_nHeartsColor;                 ///< The ANSI color for hearts.
+        ansi_extended_color m_nDiamondsColor;               ///< The ANSI color for diamonds.
+        ansi_extended_color m_nSpadesColor;                 ///< The ANSI color for spades.
+        ansi_extended_color m_nGoldsColor;                  ///< The ANSI color for golds.
+        ansi_extended_color m_nCupsColor;                   ///< The ANSI color for cups.
+        ansi_extended_color m_nSwordsColor;                 ///< The ANSI color for swords.
+        ansi_extended_color m_nJokersColor;                 ///< The ANSI color for jokers.
+        ansi_extended_color m_nFrameColor;                  ///< The ANSI color for the card frame.
+        ansi_extended_color m_nCardPaperColor;              ///< The ANSI color for the card paper.
+        ansi_extended_color m_nTableColor;                  ///< The ANSI color for the table.
+        bool m_bFitTerminal;                                ///< Whether the table is fitted to the terminal.
+        bool m_bSynchronizedOutput;                         ///< Whether frames are synchronized updates when supported.
+        bool m_bAlternateScreen;                            ///< Whether the alternate screen is used.
+        bool m_bRunLengthEncoding;                          ///< Whether runs of cells are encoded when supported.
+        mutable std::atomic<std::size_t> m_nTerminalWidth;  ///< The width of the terminal, when fitting.
+        mutable std::atomic<std::size_t> m_nTerminalHeight; ///< The height of the terminal, when fitting.
+        mutable std::atomic<std::size_t> m_nResizeCount;    ///< The resize count when the terminal was last queried.
+        mutable bool m_bCompleteFrame;                      ///< Whether the frame being drawn redraws the whole table.
+        rect m_oViewport;                                   ///< The viewport of the terminal the table is drawn in.
+        bool m_bViewport;                                   ///< Whether the table is drawn in a viewport.
+        std::array<ansi_sgr, SGR_COUNT> m_aSgr;             ///< The encoded colors, by sgr_index.
+
+    private:
+        /**
+         * @brief Gets the encoded color of the displays of a suit.
+         * @param sStdSuit The name of the suit.
+         * @return The index of the color of the suit, or of the frame color for unknown suits.
+         */
+        sgr_index get_suit_sgr(const std::string &sStdSuit) const;
+
+        /**
+         * @brief Lays out the frame and the displays of a card.
+         *
+         * The suit and the number are placed by their display width, and dropped when they
+         * do not fit in the card.
+         * @param pCard Pointer to the card number.
+         * @param oFace Receives the glyphs of the card.
+         */
+        void layout_card(const number *pCard, card_face &oFace) const;
+
+        /**
+         * @brief Encodes all the colors, so that rendering only copies the sequences.
+         */
+        void encode_colors();
+
+        /**
+         * @brief Writes a run of identical cells, encoded when enabled.
+         * @param sGlyph The glyph of the cells, taking one cell.
+         * @param nCount The number of cells.
+         */
+        void write_run(std::string_view sGlyph, std::size_t nCount) const;
+
+        /**
+         * @brief Gets the cells of the table that may be drawn.
+         *
+         * Those inside the viewport and, when fitting it, inside the terminal.
+         * @return The visible cells, in table cells.
+         */
+        rect get_screen() const;
+
+        /**
+         * @brief Moves the cursor to a cell of the table, inside the viewport.
+         * @param nX The column, in table cells.
+         * @param nY The row, in table cells.
+         */
+        void move_cursor(std::size_t nX, std::size_t nY) const;
     };
 
 } // namespace ac
@@ -0,0 +1,120 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+/**
+ * @file ansi_compositor.h
+ * @brief Declaration of the ansi_compositor class.
+ */
+
+#pragma once
+
+#include "ansi_card_table.h"
+#include "ansi_card_renderer.h"
+#include "rect.h"
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace ac
+{
+
+    /**
+     * @class ansi_compositor
+     * @brief Shares one terminal between several ANSI card tables, each drawn in its viewport.
+     *
+     * Every table gets its own renderer, moved to the origin of the viewport and clipped to
+     * its size. Changes to a table only repaint its damaged cells, inside its viewport, so
+     * the other tables are left untouched. The whole terminal is cleared and redrawn, as one
+     * complete output frame, by render and by refresh. Viewports should not overlap.
+     */
+    class ansi_compositor
+    {
+    public:
+        /**
+         * @brief Constructs an empty compositor.
+         */
+        ansi_compositor();
+
+        ansi_compositor(const ansi_compositor &) = delete;
+        ansi_compositor &operator=(const ansi_compositor &) = delete;
+
+    public:
+        /**
+         * @brief Adds a table, drawn in a viewport of the terminal.
+         *
+         * The viewport is set on the renderer (ansi_card_renderer::set_viewport), which is set
+         * on the table. The renderer must not be shared with other tables, and both must outlive
+         * the compositor or be removed before.
+         * @param pTable The table.
+         * @param pRenderer The renderer of the table.
+         * @param oViewport The viewport, in terminal cells.
+         * @throws std::invalid_argument If the table or the renderer is null, or the table was already added.
+         */
+        void add_viewport(ansi_card_table *pTable, ansi_card_renderer *pRenderer, const rect &oViewport);
+
+        /**
+         * @brief Removes a table, whose renderer draws on the whole terminal again.
+         *
+         * Its viewport is left on the terminal until the next render.
+         * @param pTable The table.
+         * @return True if the table was removed, false if it was not added.
+         */
+        bool remove_viewport(const ansi_card_table *pTable);
+
+        /**
+         * @brief Gets the number of viewports.
+         * @return The number of tables added.
+         */
+        std::size_t get_viewport_count() const;
+
+        /**
+         * @brief Clears the terminal and renders every table in its viewport, as one complete frame.
+         */
+        void render() const;
+
+        /**
+         * @brief Redraws the whole terminal if it was resized or output was lost.
+         *
+         * Meant to be called from the main loop of the application, instead of
+         * card_table::refresh on the tables of the viewports: frames dropped by a congested
+         * terminal, spectators joining a broadcast and recording keyframes all need the
+         * whole terminal.
+         * @return True if the terminal was redrawn, so that the cards can be laid out again.
+         */
+        bool refresh() const;
+
+    private:
+        /**
+         * @struct viewport
+         * @brief A table and the viewport it is drawn in.
+         */
+        struct viewport
+        {
+            ansi_card_table *m_pTable;       ///< The table.
+            ansi_card_renderer *m_pRenderer; ///< The renderer of the table.
+            rect m_oArea;                    ///< The viewport, in terminal cells.
+        };
+
+    private:
+        std::vector<viewport> m_vViewports; ///< The viewports, in the order they are drawn.
+        mutable std::mutex m_oMutex;        ///< Mutex of the viewports.
+        mutable std::size_t m_nResizeCount; ///< The resize count when the terminal was last redrawn.
+    };
+
+} // namespace ac
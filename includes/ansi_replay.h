@@ -0,0 +1,146 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+
+/**
+ * @file ansi_replay.h
+ * @brief Declaration of the ansi_replay class.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace ac
+{
+
+    class ansi_replay_handler; ///< Forward declaration of the ansi_replay_handler class.
+
+    /**
+     * @class ansi_replay
+     * @brief Replays a session recorded by ansi::record_output.
+     *
+     * The asciicast v2 file is loaded once: the output of all the events is kept in one
+     * buffer and the "keyframe" markers are indexed, so that seeking writes the last
+     * keyframe before the time and the events after it, instead of the whole session.
+     * Input, resize and other marker events are ignored.
+     */
+    class ansi_replay
+    {
+        friend class ansi_replay_handler; ///< Allows the parser to fill the events.
+
+    public:
+        /**
+         * @brief Loads a recording.
+         * @param sPath The path of the asciicast file.
+         * @throws std::runtime_error if the file can not be read, is not valid JSON or is not asciicast v2.
+         */
+        ansi_replay(const std::string &sPath);
+
+    public:
+        /**
+         * @brief Gets the width of the recorded screen.
+         * @return The width, in characters.
+         */
+        std::size_t get_width() const;
+
+        /**
+         * @brief Gets the height of the recorded screen.
+         * @return The height, in characters.
+         */
+        std::size_t get_height() const;
+
+        /**
+         * @brief Gets the time of the last event.
+         * @return The duration of the recording, in seconds.
+         */
+        double get_duration() const;
+
+        /**
+         * @brief Gets the number of output events.
+         * @return The number of events.
+         */
+        std::size_t get_event_count() const;
+
+        /**
+         * @brief Gets the number of keyframes.
+         * @return The number of keyframes.
+         */
+        std::size_t get_keyframe_count() const;
+
+        /**
+         * @brief Writes the screen as it was at a time to the standard output.
+         *
+         * Only the last keyframe up to the time and the events after it are written.
+         * Without keyframe before it, the screen is cleared and the recording written
+         * from the start.
+         * @param dTime The time, in seconds.
+         */
+        void seek(double dTime) const;
+
+        /**
+         * @brief Plays the recording on the standard output.
+         *
+         * Seeks to dFrom, then writes every event until dTo when it is due.
+         * @param dSpeed The speed: 2 plays twice as fast, 0.5 at half the speed.
+         * @param dFrom The time to start at, in seconds.
+         * @param dTo The time to stop at, in seconds.
+         * @throws std::invalid_argument if the speed is not positive.
+         */
+        void play(double dSpeed = 1.0, double dFrom = 0.0, double dTo = std::numeric_limits<double>::infinity()) const;
+
+    private:
+        /**
+         * @struct replay_event
+         * @brief An output event.
+         */
+        struct replay_event
+        {
+            double m_dTime;        ///< Time of the event, in seconds.
+            std::size_t m_nOffset; ///< Offset of the output in m_sOutput.
+            std::size_t m_nSize;   ///< Size of the output.
+        };
+
+    private:
+        std::size_t m_nWidth;                  ///< Width of the recorded screen.
+        std::size_t m_nHeight;                 ///< Height of the recorded screen.
+        std::string m_sOutput;                 ///< Output of all the events.
+        std::vector<replay_event> m_vEvents;   ///< The events, by time.
+        std::vector<std::size_t> m_vKeyframes; ///< Index of the keyframe events, in order.
+
+    private:
+        /**
+         * @brief Finds the end of the events up to a time.
+         * @param dTime The time, in seconds.
+         * @return The index of the first event after the time.
+         */
+        std::size_t find_event(double dTime) const;
+
+        /**
+         * @brief Writes the output of consecutive events to the standard output.
+         * @param nFirst Index of the first event.
+         * @param nEnd Index past the last event.
+         */
+        void write_events(std::size_t nFirst, std::size_t nEnd) const;
+    };
+
+} // namespace ac
@@ -0,0 +1,311 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file arena_json.h
+ * @brief A lightweight implementation of the json tools for card decks, without external dependencies.
+ */
+
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+
+namespace ac
+{
+
+    class arena_json_document; ///< Forward declaration of the arena_json_document class.
+
+    /**
+     * @class arena_json_item
+     * @brief Implementation of json_item as a non-owning view over an arena_json_document.
+     *
+     * Items are stored contiguously in depth-first order inside the document arena:
+     * the first child of an item is the next item in the arena, and the next sibling
+     * is found by skipping the item subtree. Strings are views over the document buffer.
+     * Items are valid as long as their document is alive, and are only used by reference:
+     * they can not be copied, as they find their children next to them in the arena.
+     */
+    class arena_json_item : public json_item
+    {
+        friend class arena_json_document; ///< Allows the document to build the items.
+
+    public:
+        arena_json_item(const arena_json_item &) = delete;
+        arena_json_item &operator=(const arena_json_item &) = delete;
+
+    public:
+        /**
+         * @class const_iterator
+         * @brief Forward iterator over the children of an item.
+         */
+        class const_iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag; ///< Iterator category.
+            using value_type = arena_json_item;                  ///< Value type.
+            using difference_type = std::ptrdiff_t;              ///< Difference type.
+            using pointer = const arena_json_item *;             ///< Pointer type.
+            using reference = const arena_json_item &;           ///< Reference type.
+
+        public:
+            /**
+             * @brief Constructs an iterator pointing to an item.
+             * @param pItem The item pointed by the iterator.
+             */
+            explicit const_iterator(const arena_json_item *pItem = nullptr) : m_pItem(pItem) {}
+
+        public:
+            /**
+             * @brief Dereferences the iterator.
+             * @return The pointed item.
+             */
+            reference operator*() const { return *this->m_pItem; }
+
+            /**
+             * @brief Dereferences the iterator.
+             * @return A pointer to the pointed item.
+             */
+            pointer operator->() const { return this->m_pItem; }
+
+            /**
+             * @brief Advances to the next sibling.
+             * @return A reference to this iterator.
+             */
+            const_iterator &operator++()
+            {
+                this->m_pItem += this->m_pItem->m_nSkip;
+                return *this;
+            }
+
+            /**
+             * @brief Advances to the next sibling.
+             * @return A copy of the iterator before advancing.
+             */
+            const_iterator operator++(int)
+            {
+                const_iterator oCopy = *this;
+                ++*this;
+                return oCopy;
+            }
+
+            /**
+             * @brief Compares two iterators for equality.
+             * @param oOther The iterator to compare with.
+             * @return True if both point to the same item.
+             */
+            bool operator==(const const_iterator &oOther) const { return this->m_pItem == oOther.m_pItem; }
+
+        private:
+            const arena_json_item *m_pItem; ///< The pointed item.
+        };
+
+    public:
+        /**
+         * @brief Retrieves a JSON object associated with the specified key.
+         *
+         * @param sKey The key for which to retrieve the JSON item.
+         * @return A pointer to the JSON item associated with the key.
+         * @throws std::runtime_error If the key is not found or is not an object.
+         */
+        virtual const json_item *get_item(const std::string &sKey) const override;
+
+        /**
+         * @brief Retrieves a string value associated with the specified key.
+         *
+         * @param sKey The key for which to retrieve the string value.
+         * @return The string value associated with the key.
+         * @throws std::runtime_error If the key is not found or is not a string.
+         */
+        virtual std::string get_string(const std::string &sKey) const override;
+
+        /**
+         * @brief Retrieves an array of JSON items associated with the specified key.
+         *
+         * @param sKey The key for which to retrieve the array of JSON items.
+         * @return A vector of pointers to the JSON items associated with the key.
+         * @throws std::runtime_error If the key is not found or is not an array.
+         */
+        virtual std::vector<const json_item *> get_array(const std::string &sKey) const override;
+
+    public:
+        /**
+         * @brief Looks for a member of an object.
+         * @param sKey The key of the member.
+         * @return A pointer to the member, or nullptr if not found or if this is not an object.
+         */
+        const arena_json_item *find(std::string_view sKey) const;
+
+        /**
+         * @brief Retrieves a string value associated with the specified key, without copying it.
+         *
+         * @param sKey The key for which to retrieve the string value.
+         * @return A view over the string value, valid as long as the document is alive.
+         * @throws std::runtime_error If the key is not found or is not a string.
+         */
+        std::string_view get_string_view(std::string_view sKey) const;
+
+    public:
+        /**
+         * @brief Gets the type of the item.
+         * @return The JSON type of the item.
+         */
+        json_type get_type() const noexcept { return this->m_nType; }
+
+        /**
+         * @brief Gets the key of the item inside its parent object.
+         * @return The key, or an empty view if the parent is not an object.
+         */
+        std::string_view get_key() const noexcept { return this->m_sKey; }
+
+        /**
+         * @brief Gets the value of a scalar item.
+         *
+         * Strings are unescaped; numbers and literals are returned as written.
+         * @return The value, or an empty view for arrays and objects.
+         */
+        std::string_view get_value() const noexcept { return this->m_sValue; }
+
+        /**
+         * @brief Gets the number of children of an array or object.
+         * @return The number of children.
+         */
+        std::size_t get_size() const noexcept { return this->m_nChildren; }
+
+        /**
+         * @brief Gets an iterator to the first child.
+         * @return An iterator to the first child.
+         */
+        const_iterator begin() const noexcept { return const_iterator(this + 1); }
+
+        /**
+         * @brief Gets an iterator past the last child.
+         * @return An iterator past the last child.
+         */
+        const_iterator end() const noexcept { return const_iterator(this + this->m_nSkip); }
+
+    private:
+        json_type m_nType;         ///< The type of the item.
+        std::uint32_t m_nChildren; ///< The number of direct children.
+        std::uint32_t m_nSkip;     ///< The number of items in the subtree, including this one.
+        std::string_view m_sKey;   ///< The key inside the parent object.
+        std::string_view m_sValue; ///< The value of scalar items.
+
+    private:
+        /**
+         * @brief Constructs an empty null item, filled by the document.
+         */
+        arena_json_item();
+    };
+
+    /**
+     * @class arena_json_document
+     * @brief Owner of a JSON document parsed in situ.
+     *
+     * The document keeps the source text and unescapes strings inside it, so that
+     * items only hold views. All the items live in a single arena allocated once,
+     * sized from an upper bound computed before parsing.
+     * Documents can not be copied nor moved, as items point into them.
+     */
+    class arena_json_document
+    {
+    public:
+        /**
+         * @brief Parses a JSON document.
+         * @param sText The JSON text. It is moved into the document.
+         * @throws std::runtime_error If the text is not valid JSON.
+         */
+        explicit arena_json_document(std::string sText);
+
+        /**
+         * @brief Parses a JSON document from an input stream.
+         * @param oIstream The input stream from which to read the JSON data.
+         * @throws std::runtime_error If the text is not valid JSON.
+         */
+        explicit arena_json_document(std::istream &oIstream);
+
+        arena_json_document(const arena_json_document &) = delete;
+        arena_json_document &operator=(const arena_json_document &) = delete;
+
+    public:
+        /**
+         * @brief Gets the root item of the document.
+         * @return A pointer to the root item.
+         */
+        const arena_json_item *get_root() const noexcept;
+
+        /**
+         * @brief Gets the number of items in the document.
+         * @return The number of items.
+         */
+        std::size_t get_item_count() const noexcept;
+
+    private:
+        std::string m_sBuffer;                       ///< The source text, with strings unescaped in situ.
+        std::unique_ptr<arena_json_item[]> m_pItems; ///< The item arena.
+        std::size_t m_nItems;                        ///< The number of items filled in the arena.
+
+    private:
+        /**
+         * @brief Parses the buffer into the arena.
+         */
+        void parse();
+
+        /**
+         * @brief Fills the next item of the arena.
+         * @param nType The type of the item.
+         * @param sKey The key inside the parent object.
+         * @param sValue The value of scalar items.
+         * @return The index of the item.
+         */
+        std::size_t add_item(json_type nType, std::string_view sKey, std::string_view sValue);
+
+        /**
+         * @brief Parses a value and its subtree.
+         * @param pCursor The parsing position. Updated past the value.
+         * @param sKey The key of the value inside its parent object.
+         * @param nDepth The nesting depth.
+         */
+        void parse_value(char *&pCursor, std::string_view sKey, std::size_t nDepth);
+
+        /**
+         * @brief Parses and unescapes a string in situ.
+         * @param pCursor The parsing position, after the opening quote. Updated past the closing quote.
+         * @return A view over the unescaped string.
+         */
+        std::string_view parse_string(char *&pCursor);
+
+        /**
+         * @brief Skips whitespace.
+         * @param pCursor The parsing position.
+         */
+        void skip_whitespace(char *&pCursor) const noexcept;
+
+        /**
+         * @brief Throws a parse error.
+         * @param pCursor The parsing position.
+         * @param sMessage The error message.
+         */
+        [[noreturn]] void fail(const char *pCursor, const char *sMessage) const;
+    };
+
+} // namespace ac
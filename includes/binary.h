@@ -0,0 +1,103 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file binary.h
+ * @brief Declaration of some binary encoding tools for the snapshot formats.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ac
+{
+
+    /**
+     * @brief Appends an unsigned integer to a buffer as a LEB128 varint.
+     *
+     * Values below 128 take a single byte; the maximum 64 bit value takes 10 bytes.
+     *
+     * @param sBuffer The buffer to which the varint will be appended.
+     * @param nValue The value to write.
+     */
+    void write_varint(std::string &sBuffer, std::uint64_t nValue);
+
+    /**
+     * @brief Reads a LEB128 varint.
+     *
+     * @param pData The reading position. Updated past the varint on success.
+     * @param pEnd The end of the data.
+     * @param nValue Receives the read value.
+     * @return False if the data ends before the varint or the varint overflows 64 bits.
+     */
+    bool read_varint(const char *&pData, const char *pEnd, std::uint64_t &nValue);
+
+    /**
+     * @brief Appends an unsigned 32 bit integer to a buffer, little endian.
+     *
+     * @param sBuffer The buffer to which the integer will be appended.
+     * @param nValue The value to write.
+     */
+    void write_fixed32(std::string &sBuffer, std::uint32_t nValue);
+
+    /**
+     * @brief Appends an unsigned 64 bit integer to a buffer, little endian.
+     *
+     * @param sBuffer The buffer to which the integer will be appended.
+     * @param nValue The value to write.
+     */
+    void write_fixed64(std::string &sBuffer, std::uint64_t nValue);
+
+    /**
+     * @brief Reads an unsigned 32 bit integer, little endian.
+     *
+     * @param pData The data. The caller ensures that 4 bytes are available.
+     * @return The read value.
+     */
+    std::uint32_t read_fixed32(const char *pData) noexcept;
+
+    /**
+     * @brief Reads an unsigned 64 bit integer, little endian.
+     *
+     * @param pData The data. The caller ensures that 8 bytes are available.
+     * @return The read value.
+     */
+    std::uint64_t read_fixed64(const char *pData) noexcept;
+
+    /**
+     * @brief Computes the 64 bit FNV-1a hash of some bytes.
+     *
+     * @param sData The bytes to hash.
+     * @param nHash The hash to continue from. Use the default value to start a new hash.
+     * @return The hash.
+     */
+    constexpr std::uint64_t fnv1a_hash(std::string_view sData, std::uint64_t nHash = 0xCBF29CE484222325ull)
+    {
+        for (char c : sData)
+        {
+            nHash ^= static_cast<unsigned char>(c);
+            nHash *= 0x100000001B3ull;
+        }
+        return nHash;
+    }
+
+} // namespace ac
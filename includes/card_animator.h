@@ -0,0 +1,193 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file card_animator.h
+ * @brief Declaration of the card_animator class moving cards over time.
+ */
+
+#pragma once
+
+#include "number.h"
+#include "point.h"
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace ac
+{
+
+    class card_table; ///< Forward declaration of the card_table class.
+
+    /**
+     * @enum easing
+     * @brief Enumeration of the speed curves of an animation.
+     */
+    enum class easing
+    {
+        LINEAR,     ///< Constant speed.
+        EASE_IN,    ///< Starts slow and speeds up.
+        EASE_OUT,   ///< Starts fast and slows down.
+        EASE_IN_OUT ///< Starts and ends slow.
+    };
+
+    /**
+     * @class card_animator
+     * @brief Slides cards across a table over time, at a fixed frame rate.
+     *
+     * Every animated card is interpolated from the position it has when the animation is
+     * requested to its target. On every frame the positions that changed are applied to
+     * the table in one update with card_table::move_cards, so a table rendering on change
+     * repaints only the damaged regions once per frame. Positions are computed from the
+     * time elapsed, so frames that can not be drawn in time are dropped rather than queued
+     * and animations last the same on slow terminals.
+     * This class is apt for multithread programming.
+     */
+    class card_animator
+    {
+    public:
+        /// The clock timing the animations.
+        using clock = std::chrono::steady_clock;
+
+        /// Default number of frames per second.
+        static constexpr std::size_t DEFAULT_FRAME_RATE = 30;
+
+    public:
+        /**
+         * @brief Constructs an animator for a table.
+         * @param pTable The table whose cards are animated. It must outlive the animator.
+         * @param nFrameRate Number of frames per second. If invalid, DEFAULT_FRAME_RATE is set.
+         * @throws std::invalid_argument If pTable is nullptr.
+         */
+        card_animator(card_table *pTable, std::size_t nFrameRate = DEFAULT_FRAME_RATE);
+
+    public:
+        /**
+         * @brief Gets the number of frames per second.
+         * @return The frame rate.
+         */
+        std::size_t get_frame_rate() const;
+
+        /**
+         * @brief Sets the number of frames per second.
+         *
+         * If invalid, DEFAULT_FRAME_RATE is set.
+         * @param nFrameRate The frame rate.
+         */
+        void set_frame_rate(std::size_t nFrameRate);
+
+        /**
+         * @brief Checks if any card is still being animated.
+         * @return True if there are pending animations.
+         */
+        bool is_running() const;
+
+    public:
+        /**
+         * @brief Slides a card to a position.
+         *
+         * An animation already running for the card is replaced, starting from where the
+         * card is. Cards not on the table are ignored.
+         * @param pCard Pointer to the card.
+         * @param oTarget The position where the card ends.
+         * @param oDuration The duration of the animation.
+         * @param nEasing The speed curve of the animation.
+         * @param oDelay The time to wait before the card starts moving.
+         */
+        void animate(const number *pCard, point oTarget, clock::duration oDuration, easing nEasing = easing::EASE_OUT, clock::duration oDelay = {});
+
+        /**
+         * @brief Slides a group of cards to their positions, as when dealing or collecting.
+         *
+         * The table is scanned once for the starting positions. Cards not on the table and
+         * nullptr entries are ignored.
+         * @param vCards Pointers to the cards.
+         * @param vTargets The positions where the cards end. Usually computed with card_layout.
+         * @param oDuration The duration of the animation of every card.
+         * @param oStagger The delay between the start of two consecutive cards.
+         * @param nEasing The speed curve of the animations.
+         * @throws std::invalid_argument If the spans have different sizes.
+         */
+        void animate(std::span<const number *const> vCards, std::span<const point> vTargets, clock::duration oDuration, clock::duration oStagger = {}, easing nEasing = easing::EASE_OUT);
+
+        /**
+         * @brief Stops the animation of a card, leaving it where it is.
+         * @param pCard Pointer to the card.
+         */
+        void cancel(const number *pCard);
+
+        /**
+         * @brief Stops all the animations, leaving the cards where they are.
+         */
+        void cancel_all();
+
+        /**
+         * @brief Moves all the animated cards to their targets in one update and stops the animations.
+         */
+        void finish();
+
+    public:
+        /**
+         * @brief Computes and applies one frame.
+         * @param oNow The time of the frame.
+         * @return True if there are animations left.
+         */
+        bool tick(clock::time_point oNow = clock::now());
+
+        /**
+         * @brief Plays the animations until all of them end, pacing the frames to the frame rate.
+         *
+         * Blocks the calling thread. Animations added meanwhile from other threads are played too.
+         */
+        void run();
+
+    private:
+        /**
+         * @struct tween
+         * @brief The animation of one card.
+         */
+        struct tween
+        {
+            const number *m_pCard;       ///< The animated card.
+            point m_oFrom;               ///< The starting position.
+            point m_oTo;                 ///< The target position.
+            point m_oLast;               ///< The last position applied to the table.
+            clock::time_point m_oStart;  ///< The time when the card starts moving.
+            clock::duration m_oDuration; ///< The duration of the animation.
+            easing m_nEasing;            ///< The speed curve.
+        };
+
+    private:
+        card_table *m_pTable;         ///< The animated table.
+        std::size_t m_nFrameRate;     ///< Number of frames per second.
+        std::vector<tween> m_vTweens; ///< The running animations.
+        mutable std::mutex m_oMutex;  ///< Mutex for multithread applications
+
+    private:
+        /**
+         * @brief Adds an animation, replacing the one running for the same card.
+         * @param oTween The animation.
+         */
+        void add_unlocked(const tween &oTween);
+    };
+
+} // namespace ac
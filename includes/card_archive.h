@@ -0,0 +1,244 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file card_archive.h
+ * @brief Declaration of the archive files holding many decks and table states.
+ *
+ * Layout of an archive (version 1, integers little endian):
+ * - header: magic `ACAR`, version (4 bytes), entry count (4 bytes), index offset (8 bytes);
+ * - payloads: decks as written by deck::to_json, tables as written by card_table::save_snapshot;
+ * - entry names;
+ * - index: one fixed size record per entry, with its kind, deck entry (for tables),
+ *   name offset and size, and payload offset and size.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ac
+{
+
+    class deck;       ///< Forward declaration of the deck class.
+    class card_table; ///< Forward declaration of the card_table class.
+    class card_index; ///< Forward declaration of the card_index class.
+
+    /**
+     * @enum archive_entry
+     * @brief Enum class representing the kind of an archive entry.
+     */
+    enum class archive_entry : std::uint32_t
+    {
+        DECK = 1,  ///< A deck, stored as JSON.
+        TABLE = 2, ///< A table state, stored as a binary snapshot.
+    };
+
+    /**
+     * @class card_archive_writer
+     * @brief Builds archive files.
+     *
+     * Entries are accumulated in memory and written at once.
+     */
+    class card_archive_writer
+    {
+    public:
+        /**
+         * @brief Adds a deck to the archive.
+         * @param sName The name of the entry.
+         * @param pDeck The deck.
+         * @return The entry number of the deck.
+         * @throws std::invalid_argument If pDeck is nullptr.
+         */
+        std::uint32_t add_deck(const std::string &sName, const deck *pDeck);
+
+        /**
+         * @brief Adds a table state to the archive.
+         * @param sName The name of the entry.
+         * @param nDeckEntry The entry number of the deck containing the cards of the table.
+         * @param pTable The table.
+         * @param oIndex The index of the deck containing the cards of the table.
+         * @return The entry number of the table.
+         * @throws std::invalid_argument If pTable is nullptr, nDeckEntry is not a deck entry,
+         *         or a card on the table is not part of the indexed deck.
+         */
+        std::uint32_t add_table(const std::string &sName, std::uint32_t nDeckEntry, const card_table *pTable, const card_index &oIndex);
+
+        /**
+         * @brief Writes the archive to a file.
+         * @param sPath The path of the file.
+         * @throws std::runtime_error If the file can not be written.
+         */
+        void write(const std::string &sPath) const;
+
+        /**
+         * @brief Writes the archive to a buffer.
+         * @param sBuffer The buffer to which the archive will be appended.
+         */
+        void write(std::string &sBuffer) const;
+
+    private:
+        /**
+         * @struct entry
+         * @brief An entry being written.
+         */
+        struct entry
+        {
+            archive_entry m_nKind; ///< The kind of the entry.
+            std::uint32_t m_nDeck; ///< The deck entry of a table.
+            std::string m_sName;   ///< The name of the entry.
+            std::size_t m_nOffset; ///< Offset of the payload inside m_sPayloads.
+            std::size_t m_nSize;   ///< Size of the payload.
+        };
+
+    private:
+        std::vector<entry> m_vEntries; ///< The entries.
+        std::string m_sPayloads;       ///< The payloads of all the entries.
+    };
+
+    /**
+     * @class card_archive
+     * @brief Read-only, memory-mapped access to an archive file.
+     *
+     * Opening an archive maps the file and validates its index, without reading
+     * the payloads. Any entry is then reached in constant time, and only that
+     * entry is parsed when loaded. The archive may be shared between threads.
+     * On platforms without mmap, the file is read into memory instead.
+     */
+    class card_archive
+    {
+    public:
+        /// Entry number returned when an entry is not found.
+        static constexpr std::uint32_t NOT_FOUND = UINT32_MAX;
+
+    public:
+        /**
+         * @brief Opens an archive file.
+         * @param sPath The path of the file.
+         * @throws std::runtime_error If the file can not be opened or is not a valid archive.
+         */
+        explicit card_archive(const std::string &sPath);
+
+        /**
+         * @brief Closes the archive.
+         */
+        ~card_archive();
+
+        card_archive(const card_archive &) = delete;
+        card_archive &operator=(const card_archive &) = delete;
+
+    public:
+        /**
+         * @brief Gets the number of entries.
+         * @return The number of entries.
+         */
+        std::uint32_t get_entry_count() const noexcept;
+
+        /**
+         * @brief Looks for an entry by its name.
+         * @param sName The name of the entry.
+         * @return The entry number, or NOT_FOUND.
+         */
+        std::uint32_t find(std::string_view sName) const;
+
+        /**
+         * @brief Gets the kind of an entry.
+         * @param nEntry The entry number.
+         * @return The kind of the entry.
+         * @throws std::out_of_range If the entry does not exist.
+         */
+        archive_entry get_kind(std::uint32_t nEntry) const;
+
+        /**
+         * @brief Gets the name of an entry.
+         * @param nEntry The entry number.
+         * @return A view over the name, valid as long as the archive is open.
+         * @throws std::out_of_range If the entry does not exist.
+         */
+        std::string_view get_name(std::uint32_t nEntry) const;
+
+        /**
+         * @brief Gets the raw payload of an entry.
+         * @param nEntry The entry number.
+         * @return A view over the payload, valid as long as the archive is open.
+         * @throws std::out_of_range If the entry does not exist.
+         */
+        std::string_view get_data(std::uint32_t nEntry) const;
+
+        /**
+         * @brief Gets the deck entry of a table entry.
+         * @param nEntry The entry number of the table.
+         * @return The entry number of its deck.
+         * @throws std::out_of_range If the entry does not exist.
+         * @throws std::invalid_argument If the entry is not a table.
+         */
+        std::uint32_t get_table_deck(std::uint32_t nEntry) const;
+
+    public:
+        /**
+         * @brief Loads a deck entry.
+         * @param nEntry The entry number of the deck.
+         * @return A pointer to a dynamically allocated deck containing the cards.
+         *         The caller is responsible for freeing the allocated memory.
+         * @throws std::out_of_range If the entry does not exist.
+         * @throws std::invalid_argument If the entry is not a deck.
+         * @throws std::runtime_error If the payload is not a valid deck.
+         */
+        deck *load_deck(std::uint32_t nEntry) const;
+
+        /**
+         * @brief Loads a table entry into a table, in one update.
+         * @param nEntry The entry number of the table.
+         * @param pTable The table to load into.
+         * @param oIndex The index of the deck loaded from get_table_deck(nEntry).
+         * @throws std::out_of_range If the entry does not exist.
+         * @throws std::invalid_argument If the entry is not a table or pTable is nullptr.
+         * @throws std::runtime_error If the payload is not a valid snapshot for the deck.
+         */
+        void load_table(std::uint32_t nEntry, card_table *pTable, const card_index &oIndex) const;
+
+    private:
+        const char *m_pData;                                          ///< The archive bytes.
+        std::size_t m_nSize;                                          ///< The archive size.
+        std::vector<char> m_vFallback;                                ///< Archive bytes when not mapped.
+        std::uint32_t m_nEntries;                                     ///< The number of entries.
+        const char *m_pIndex;                                         ///< The index records.
+        std::unordered_map<std::string_view, std::uint32_t> m_mNames; ///< Entry numbers by name.
+
+    private:
+        /**
+         * @brief Gets the index record of an entry.
+         * @param nEntry The entry number.
+         * @return A pointer to the record.
+         * @throws std::out_of_range If the entry does not exist.
+         */
+        const char *get_record(std::uint32_t nEntry) const;
+
+        /**
+         * @brief Validates the header and the index.
+         * @throws std::runtime_error If the archive is not valid.
+         */
+        void open_index();
+    };
+
+} // namespace ac
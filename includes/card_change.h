@@ -0,0 +1,167 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file card_change.h
+ * @brief Declaration of the card_change class describing elementary changes of a card table.
+ */
+
+#pragma once
+
+#include "card_holder.h"
+
+#include <cstdint>
+#include <list>
+
+namespace ac
+{
+
+    /**
+     * @enum card_change_type
+     * @brief Enum class representing the kind of a card_change.
+     */
+    enum class card_change_type : std::uint8_t
+    {
+        INSERT = 1,     ///< A card was added at a layer.
+        ERASE = 2,      ///< A card was removed from a layer.
+        MOVE = 3,       ///< A card changed its horizontal position.
+        RESTACK = 4,    ///< A card changed its layer.
+        REPLACE = 5,    ///< The card of a layer was replaced by another card.
+        VISIBILITY = 6, ///< A card was shown or hidden.
+        RESET = 7,      ///< All the cards were replaced at once.
+    };
+
+    /**
+     * @class card_change
+     * @brief An elementary change of a card table.
+     *
+     * Every mutator of card_table is described as a short sequence of changes.
+     * Layers are positions in the stacking order (0 is the bottom card), taken at the
+     * time the change is applied. Every change except RESET holds both the state before
+     * and after it, so that it can be inverted and applied in constant memory.
+     *
+     * Fields used by every type:
+     * - INSERT, ERASE: card, layer, position and visibility of the inserted or erased card;
+     * - MOVE: card, layer, previous and new position;
+     * - RESTACK: card, previous and new layer;
+     * - REPLACE: previous and new card, layer;
+     * - VISIBILITY: card, layer, new visibility (the previous one is its opposite);
+     * - RESET: none, the new state is the whole table.
+     */
+    class card_change
+    {
+    public:
+        card_change_type m_nType;      ///< The kind of change.
+        const number *m_pCard;         ///< The changed card (the new card for REPLACE).
+        const number *m_pPreviousCard; ///< The previous card (REPLACE only).
+        std::size_t m_nLayer;          ///< The layer of the card (the new layer for RESTACK).
+        std::size_t m_nPreviousLayer;  ///< The previous layer (RESTACK only).
+        point m_oPos;                  ///< The position of the card (the new position for MOVE).
+        point m_oPreviousPos;          ///< The previous position (MOVE only).
+        bool m_bVisible;               ///< The visibility of the card (the new visibility for VISIBILITY).
+
+    public:
+        /**
+         * @brief Describes the insertion of a card.
+         * @param pCard The card.
+         * @param nLayer The layer where the card is inserted.
+         * @param oPos The position of the card.
+         * @param bVisible The visibility of the card.
+         * @return The change.
+         */
+        static card_change insert(const number *pCard, std::size_t nLayer, point oPos, bool bVisible);
+
+        /**
+         * @brief Describes the removal of a card.
+         * @param pCard The card.
+         * @param nLayer The layer from which the card is removed.
+         * @param oPos The position the card had.
+         * @param bVisible The visibility the card had.
+         * @return The change.
+         */
+        static card_change erase(const number *pCard, std::size_t nLayer, point oPos, bool bVisible);
+
+        /**
+         * @brief Describes a change of horizontal position.
+         * @param pCard The card.
+         * @param nLayer The layer of the card.
+         * @param oPreviousPos The previous position.
+         * @param oPos The new position.
+         * @return The change.
+         */
+        static card_change move(const number *pCard, std::size_t nLayer, point oPreviousPos, point oPos);
+
+        /**
+         * @brief Describes a change of layer.
+         * @param pCard The card.
+         * @param nPreviousLayer The previous layer.
+         * @param nLayer The new layer, once the card has been taken out of the previous one.
+         * @return The change.
+         */
+        static card_change restack(const number *pCard, std::size_t nPreviousLayer, std::size_t nLayer);
+
+        /**
+         * @brief Describes the replacement of the card of a layer.
+         * @param nLayer The layer.
+         * @param pPreviousCard The previous card.
+         * @param pCard The new card.
+         * @return The change.
+         */
+        static card_change replace(std::size_t nLayer, const number *pPreviousCard, const number *pCard);
+
+        /**
+         * @brief Describes a change of visibility.
+         * @param pCard The card.
+         * @param nLayer The layer of the card.
+         * @param bVisible The new visibility.
+         * @return The change.
+         */
+        static card_change visibility(const number *pCard, std::size_t nLayer, bool bVisible);
+
+        /**
+         * @brief Describes the replacement of all the cards.
+         * @return The change.
+         */
+        static card_change reset();
+
+    public:
+        /**
+         * @brief Gets the change undoing this one.
+         * @return The inverse change.
+         * @throws std::logic_error If the change is a RESET, which is not invertible on its own.
+         */
+        card_change get_inverse() const;
+
+        /**
+         * @brief Applies the change to a list of card holders.
+         * @param lHolders The list of card holders, in stacking order.
+         * @throws std::invalid_argument If the list does not match the state before the change,
+         *         or the change is a RESET. The list is left unchanged.
+         */
+        void apply(std::list<card_holder> &lHolders) const;
+
+    private:
+        /**
+         * @brief Constructs an empty change.
+         * @param nType The kind of change.
+         */
+        card_change(card_change_type nType);
+    };
+
+} // namespace ac
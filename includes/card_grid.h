@@ -0,0 +1,151 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file card_grid.h
+ * @brief Declaration of the card_grid class used for locating the cards of a table by cell.
+ */
+
+#pragma once
+
+#include "card_change.h"
+#include "rect.h"
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace ac
+{
+
+    /**
+     * @class card_grid
+     * @brief Uniform grid spatial index of the cards of a table.
+     *
+     * The table is divided in buckets of the size of a card, so every card is listed in
+     * at most four buckets and a cell is looked up in a single one. Every card keeps an
+     * ordering key following the stacking order, so that the topmost card can be told
+     * without walking the table.
+     * The grid is kept up to date from the card_change(s) of the table. Changes that can
+     * not be followed incrementally (replacements, resets, insertions in the middle of the
+     * stack) are reported, and the grid must then be rebuilt.
+     * Cards are expected to be placed once on the table; while a card appears more than once
+     * the grid can not be updated incrementally.
+     * This class is not apt for multithread programming; card_table guards it with its mutex.
+     */
+    class card_grid
+    {
+    public:
+        /**
+         * @brief Constructs an empty grid.
+         * @param nCardWidth The width of the cards, in table cells. 0 is taken as 1.
+         * @param nCardHeight The height of the cards, in table cells. 0 is taken as 1.
+         */
+        card_grid(std::size_t nCardWidth, std::size_t nCardHeight);
+
+    public:
+        /**
+         * @brief Gets the width of the cards.
+         * @return The card width, in table cells.
+         */
+        std::size_t get_card_width() const noexcept;
+
+        /**
+         * @brief Gets the height of the cards.
+         * @return The card height, in table cells.
+         */
+        std::size_t get_card_height() const noexcept;
+
+    public:
+        /**
+         * @brief Indexes the cards of a table from scratch.
+         * @param lHolders The card holders, in stacking order.
+         */
+        void rebuild(const std::list<card_holder> &lHolders);
+
+        /**
+         * @brief Follows a change of the table.
+         * @param oChange The change, already applied to the table.
+         * @return true if the grid was updated, false if it must be rebuilt.
+         */
+        bool update(const card_change &oChange);
+
+    public:
+        /**
+         * @brief Gets the topmost visible card covering a cell.
+         * @param oPoint The cell.
+         * @return The card, or nullptr if no visible card covers the cell.
+         */
+        const number *get_card_at(const point &oPoint) const;
+
+        /**
+         * @brief Gets the visible cards overlapping a rectangle.
+         * @param oRect The rectangle.
+         * @param vCards Receives the cards, in stacking order (bottom to top). It is cleared first.
+         */
+        void get_cards_in(const rect &oRect, std::vector<const number *> &vCards) const;
+
+    private:
+        /**
+         * @struct entry
+         * @brief The indexed state of a card.
+         */
+        struct entry
+        {
+            point m_oPos;          ///< The position of the card.
+            std::int64_t m_nOrder; ///< Ordering key, greater for upper cards.
+            bool m_bVisible;       ///< The visibility of the card.
+        };
+
+    private:
+        std::size_t m_nCardWidth;                                                  ///< The width of the cards.
+        std::size_t m_nCardHeight;                                                 ///< The height of the cards.
+        std::unordered_map<const number *, entry> m_mCards;                        ///< Indexed cards.
+        std::unordered_map<std::uint64_t, std::vector<const number *>> m_mBuckets; ///< Cards by bucket.
+        std::int64_t m_nTop;                                                       ///< Ordering key of the topmost card.
+        std::int64_t m_nBottom;                                                    ///< Ordering key of the lowest card.
+        bool m_bExact;                                                             ///< false while a card appears more than once.
+
+    private:
+        /**
+         * @brief Gets the rectangle covered by a card.
+         * @param oPos The position of the card.
+         * @return The rectangle.
+         */
+        rect get_card_rect(const point &oPos) const noexcept;
+
+        /**
+         * @brief Gets the key of the bucket holding a cell.
+         * @param nColumn The column of the bucket.
+         * @param nRow The row of the bucket.
+         * @return The key.
+         */
+        static std::uint64_t get_bucket_key(std::size_t nColumn, std::size_t nRow) noexcept;
+
+        /**
+         * @brief Adds or removes a card from the buckets it covers.
+         * @param pCard The card.
+         * @param oPos The position of the card.
+         * @param bAdd true to add, false to remove.
+         */
+        void link(const number *pCard, const point &oPos, bool bAdd);
+    };
+
+} // namespace ac
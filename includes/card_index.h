@@ -0,0 +1,101 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file card_index.h
+ * @brief Declaration of the card_index class used for identifying the cards of a deck by number.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ac
+{
+
+    class deck;   ///< Forward declaration of the deck class.
+    class number; ///< Forward declaration of the number class.
+
+    /**
+     * @class card_index
+     * @brief Dense numeric identifiers for the cards of a deck.
+     *
+     * Identifiers are the position of each card in deck::get_numbers(), which lists
+     * suits and numbers by name, so they are stable for decks with the same contents.
+     * The index also keeps a fingerprint of the deck contents, used by the binary
+     * formats to reject data written against a different deck.
+     * The index is immutable once built and may be shared between threads.
+     */
+    class card_index
+    {
+    public:
+        /// Identifier returned for cards that are not part of the deck.
+        static constexpr std::uint32_t INVALID_ID = UINT32_MAX;
+
+    public:
+        /**
+         * @brief Builds the index of a deck.
+         * @param pDeck The deck to index. It must outlive the index and not change while indexed.
+         * @throws std::invalid_argument If pDeck is nullptr.
+         */
+        explicit card_index(const deck *pDeck);
+
+    public:
+        /**
+         * @brief Gets the indexed deck.
+         * @return A pointer to the deck.
+         */
+        const deck *get_deck() const noexcept;
+
+        /**
+         * @brief Gets the fingerprint of the deck contents.
+         * @return A hash of the names of the suits and numbers, in identifier order.
+         */
+        std::uint64_t get_fingerprint() const noexcept;
+
+        /**
+         * @brief Gets the number of indexed cards.
+         * @return The number of cards.
+         */
+        std::size_t get_card_count() const noexcept;
+
+        /**
+         * @brief Gets the identifier of a card.
+         * @param pCard The card.
+         * @return The identifier, or INVALID_ID if the card is not part of the deck.
+         */
+        std::uint32_t get_id(const number *pCard) const;
+
+        /**
+         * @brief Gets the card with an identifier.
+         * @param nId The identifier.
+         * @return The card, or nullptr if the identifier is out of range.
+         */
+        const number *get_card(std::uint32_t nId) const noexcept;
+
+    private:
+        const deck *m_pDeck;                                      ///< The indexed deck.
+        std::uint64_t m_nFingerprint;                             ///< Fingerprint of the deck contents.
+        std::vector<const number *> m_vCards;                     ///< Cards by identifier.
+        std::unordered_map<const number *, std::uint32_t> m_mIds; ///< Identifiers by card.
+    };
+
+} // namespace ac
@@ -0,0 +1,216 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file card_journal.h
+ * @brief Declaration of the append-only operation journal of card tables and its player.
+ *
+ * Layout of a journal (version 1): magic `ACJL`, version as a varint, fingerprint of
+ * the deck (8 bytes little endian), followed by records. Every record starts with a tag:
+ * - a card_change_type, followed by the varint fields of the change (cards as card_index
+ *   identifiers, visibility as 0 or 1); RESET is followed by a snapshot;
+ * - END_FRAME, closing the changes of a mutator call;
+ * - KEYFRAME, followed by the size of a snapshot of the whole table and the snapshot.
+ */
+
+#pragma once
+
+#include "card_change.h"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ac
+{
+
+    class card_index; ///< Forward declaration of the card_index class.
+    class card_table; ///< Forward declaration of the card_table class.
+
+    /**
+     * @class card_journal
+     * @brief Append-only binary log of the changes of a card table.
+     *
+     * A journal is attached to a table with card_table::set_journal. Every mutator call
+     * is appended as one frame holding its card_change sequence, and a keyframe (a full
+     * snapshot) is appended every few frames, so that a card_journal_player can seek
+     * without replaying the whole log.
+     * This class is apt for multithread programming.
+     */
+    class card_journal
+    {
+        friend class card_table; ///< Allows the card_table class to record changes.
+
+    public:
+        /// Default number of frames between keyframes.
+        static constexpr std::size_t DEFAULT_KEYFRAME_INTERVAL = 256;
+
+    public:
+        /**
+         * @brief Constructs an empty journal.
+         * @param oIndex The index of the deck containing the cards. It must outlive the journal.
+         * @param nKeyframeInterval Number of frames between keyframes. 0 disables periodic keyframes.
+         */
+        card_journal(const card_index &oIndex, std::size_t nKeyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+
+    public:
+        /**
+         * @brief Gets the number of recorded frames.
+         * @return The number of frames.
+         */
+        std::size_t get_frame_count() const;
+
+        /**
+         * @brief Gets the size of the journal.
+         * @return The size in bytes.
+         */
+        std::size_t get_size() const;
+
+        /**
+         * @brief Appends the journal data to a buffer.
+         * @param sBuffer The buffer to which the journal will be appended.
+         */
+        void get_data(std::string &sBuffer) const;
+
+        /**
+         * @brief Gets a copy of the journal data.
+         * @return The journal data.
+         */
+        std::string get_data() const;
+
+    private:
+        const card_index *m_pIndex;         ///< The index of the deck.
+        std::size_t m_nKeyframeInterval;    ///< Number of frames between keyframes.
+        std::string m_sData;                ///< The journal data.
+        std::size_t m_nFrames;              ///< Number of recorded frames.
+        std::size_t m_nFramesSinceKeyframe; ///< Number of frames since the last keyframe.
+        mutable std::mutex m_oMutex;        ///< Mutex for multithread applications
+
+    private:
+        /**
+         * @brief Appends the changes of a mutator call as a frame.
+         * @param vChanges The changes.
+         * @param lHolders The state of the table after the changes.
+         * @throws std::invalid_argument If a card is not part of the indexed deck.
+         */
+        void record(const std::vector<card_change> &vChanges, const std::list<card_holder> &lHolders);
+
+        /**
+         * @brief Appends a keyframe.
+         * @param lHolders The state of the table.
+         * @throws std::invalid_argument If a card is not part of the indexed deck.
+         */
+        void record_keyframe(const std::list<card_holder> &lHolders);
+
+        /**
+         * @brief Appends a keyframe without locking the journal.
+         * @param lHolders The state of the table.
+         */
+        void record_keyframe_unlocked(const std::list<card_holder> &lHolders);
+    };
+
+    /**
+     * @class card_journal_player
+     * @brief Replays a journal into a card table.
+     *
+     * Opening a journal scans its records once to locate the frames and keyframes;
+     * the data is read in place and must outlive the player. Seeking to a frame loads
+     * the closest keyframe before it and applies the remaining changes in memory,
+     * updating the table once.
+     */
+    class card_journal_player
+    {
+    public:
+        /**
+         * @brief Opens journal data.
+         * @param sData The journal data, as written by card_journal.
+         * @param oIndex The index of the deck containing the cards. It must outlive the player.
+         * @throws std::runtime_error If the data is not a valid journal, or was written against a different deck.
+         */
+        card_journal_player(std::string_view sData, const card_index &oIndex);
+
+    public:
+        /**
+         * @brief Gets the number of frames in the journal.
+         * @return The number of frames.
+         */
+        std::size_t get_frame_count() const noexcept;
+
+        /**
+         * @brief Loads the state of the table after a number of frames, in one update.
+         * @param nFrame The number of frames to replay. Clamped to the frame count.
+         * @param pTable The table to load into.
+         * @throws std::invalid_argument If pTable is nullptr.
+         * @throws std::runtime_error If the journal does not match its own changes.
+         */
+        void seek(std::size_t nFrame, card_table *pTable) const;
+
+        /**
+         * @brief Replays a range of frames, updating the table once per frame.
+         * @param nFrom The frame to start from; the table is first loaded with seek.
+         * @param nTo The frame to stop at. Clamped to the frame count.
+         * @param pTable The table to play into.
+         * @param fnOnFrame Optional callback called after every frame with the number of replayed frames.
+         * @throws std::invalid_argument If pTable is nullptr.
+         * @throws std::runtime_error If the journal does not match its own changes.
+         */
+        void play(std::size_t nFrom, std::size_t nTo, card_table *pTable, const std::function<void(std::size_t)> &fnOnFrame = nullptr) const;
+
+    private:
+        /**
+         * @struct keyframe
+         * @brief Location of a keyframe.
+         */
+        struct keyframe
+        {
+            std::size_t m_nFrame;  ///< Number of frames before the keyframe.
+            std::size_t m_nOffset; ///< Offset of the keyframe record.
+        };
+
+    private:
+        std::string_view m_sData;           ///< The journal data.
+        const card_index *m_pIndex;         ///< The index of the deck.
+        std::size_t m_nStart;               ///< Offset of the first record.
+        std::size_t m_nFrames;              ///< Number of frames.
+        std::vector<keyframe> m_vKeyframes; ///< Keyframes, by frame.
+
+    private:
+        /**
+         * @brief Reads the next record.
+         * @param pData The reading position. Updated past the record.
+         * @param nTag Receives the tag of the record.
+         * @param oChange Receives the change, for change records.
+         * @param sSnapshot Receives the snapshot, for RESET and KEYFRAME records.
+         * @throws std::runtime_error If the record is not valid.
+         */
+        void read_record(const char *&pData, std::uint8_t &nTag, card_change &oChange, std::string_view &sSnapshot) const;
+
+        /**
+         * @brief Rebuilds the state after a number of frames, from the closest keyframe before it.
+         * @param nFrame The number of frames to replay. At most the frame count.
+         * @param lHolders Receives the state.
+         * @return The reading position after the frame.
+         * @throws std::runtime_error If the journal does not match its own changes.
+         */
+        const char *replay(std::size_t nFrame, std::list<card_holder> &lHolders) const;
+    };
+
+} // namespace ac
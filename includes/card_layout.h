@@ -0,0 +1,133 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file card_layout.h
+ * @brief Declaration of the card_layout class computing the positions of groups of cards.
+ */
+
+#pragma once
+
+#include "point.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace ac
+{
+
+    class card_renderer; ///< Forward declaration of the card_renderer class.
+
+    /**
+     * @class card_layout
+     * @brief Computes the positions of whole groups of cards.
+     *
+     * Every primitive appends the positions of a group to a vector, so that several
+     * groups (a tableau, a stock, a foundation...) can be laid out and then applied to a
+     * table in one update with card_table::stack_cards or card_table::move_cards.
+     * Positions are computed from the size of the rendered cards.
+     */
+    class card_layout
+    {
+    public:
+        /**
+         * @brief Constructs a layout for cards of a given size.
+         * @param nCardWidth The width of the cards, in table cells.
+         * @param nCardHeight The height of the cards, in table cells.
+         */
+        card_layout(std::size_t nCardWidth, std::size_t nCardHeight);
+
+        /**
+         * @brief Constructs a layout for the cards drawn by a renderer.
+         * @param pRenderer The renderer. Cards are taken as a single cell if it is nullptr.
+         */
+        explicit card_layout(const card_renderer *pRenderer);
+
+    public:
+        /**
+         * @brief Gets the width of the cards.
+         * @return The card width, in table cells.
+         */
+        std::size_t get_card_width() const noexcept;
+
+        /**
+         * @brief Gets the height of the cards.
+         * @return The card height, in table cells.
+         */
+        std::size_t get_card_height() const noexcept;
+
+    public:
+        /**
+         * @brief Lays out cards side by side, from left to right.
+         * @param vPositions The vector to which the positions are appended.
+         * @param oOrigin The position of the first card.
+         * @param nCount The number of cards.
+         * @param nGap The number of cells between two cards.
+         */
+        void row(std::vector<point> &vPositions, point oOrigin, std::size_t nCount, std::size_t nGap = 1) const;
+
+        /**
+         * @brief Lays out cards in rows of a fixed number of columns, from left to right and top to bottom.
+         * @param vPositions The vector to which the positions are appended.
+         * @param oOrigin The position of the first card.
+         * @param nCount The number of cards.
+         * @param nColumns The number of cards per row. 0 is taken as 1.
+         * @param nGapX The number of cells between two columns.
+         * @param nGapY The number of cells between two rows.
+         */
+        void grid(std::vector<point> &vPositions, point oOrigin, std::size_t nCount, std::size_t nColumns, std::size_t nGapX = 1, std::size_t nGapY = 1) const;
+
+        /**
+         * @brief Spreads overlapping cards over a width, from left to right.
+         *
+         * The cards are spaced evenly so that the group fits the width, overlapping as much as
+         * needed but never less than one column apart, nor further apart than a row with no gap.
+         * @param vPositions The vector to which the positions are appended.
+         * @param oOrigin The position of the first card.
+         * @param nCount The number of cards.
+         * @param nWidth The width of the group, in table cells.
+         */
+        void fan(std::vector<point> &vPositions, point oOrigin, std::size_t nCount, std::size_t nWidth) const;
+
+        /**
+         * @brief Lays out overlapping cards downwards, as the columns of a solitaire tableau.
+         * @param vPositions The vector to which the positions are appended.
+         * @param oOrigin The position of the first card.
+         * @param nCount The number of cards.
+         * @param nStep The number of rows of every card left uncovered. 0 is taken as 1.
+         */
+        void cascade(std::vector<point> &vPositions, point oOrigin, std::size_t nCount, std::size_t nStep = 1) const;
+
+        /**
+         * @brief Lays out a pile, shifting the cards every few cards to show its thickness.
+         * @param vPositions The vector to which the positions are appended.
+         * @param oOrigin The position of the bottom card.
+         * @param nCount The number of cards.
+         * @param nEvery The number of cards sharing a position. 0 keeps all the cards in place.
+         * @param nOffsetX The horizontal shift every nEvery cards.
+         * @param nOffsetY The vertical shift every nEvery cards.
+         */
+        void pile(std::vector<point> &vPositions, point oOrigin, std::size_t nCount, std::size_t nEvery = 0, std::size_t nOffsetX = 1, std::size_t nOffsetY = 0) const;
+
+    private:
+        std::size_t m_nCardWidth;  ///< The width of the cards.
+        std::size_t m_nCardHeight; ///< The height of the cards.
+    };
+
+} // namespace ac
@@ -24,8 +24,12 @@
 #pragma once
 
 #include "point.h"
+#include "rect.h"
 #include "number.h"
 
+#include <span>
+#include <vector>
+
 namespace ac
 {
     /**
@@ -53,6 +57,19 @@ namespace ac
          */
         virtual void render_card(const number *pCard, point nPos) const = 0;
 
+        /**
+         * @brief Renders the exposed part of a card partially covered by other cards.
+         *
+         * card_table calls this method, from the bottom card to the top one, for the cards
+         * that are not fully covered by the cards above them. Renderers able to clip only
+         * need to draw the exposed rectangles. The default implementation draws the whole card.
+         *
+         * @param pCard Pointer to the card number to be rendered.
+         * @param nPos The position where the card should be rendered.
+         * @param vExposed The exposed parts of the card, in table cells. Never empty.
+         */
+        virtual void render_card(const number *pCard, point nPos, std::span<const rect> vExposed) const;
+
         /**
          * @brief Renders the table.
          *
@@ -61,6 +78,95 @@ namespace ac
          * relevant to the game or display context.
          */
         virtual void render_table() const = 0;
+
+        /**
+         * @brief Renders regions of the table, erasing what was drawn on them.
+         *
+         * Only called when can_render_regions returns true, followed by the cards
+         * covering the regions, clipped to them.
+         * The default implementation renders the whole table.
+         *
+         * @param vRegions The regions to render, in table cells.
+         */
+        virtual void render_table(std::span<const rect> vRegions) const;
+
+        /**
+         * @brief Checks if the renderer draws regions of the table and clips cards.
+         *
+         * Renderers returning true must only draw inside the given regions in
+         * render_table(vRegions) and render_card(pCard, nPos, vExposed). card_table then
+         * repaints only the regions affected by every change instead of the whole table.
+         * The default implementation returns false.
+         *
+         * @return true if regions can be rendered on their own, false otherwise.
+         */
+        virtual bool can_render_regions() const;
+
+        /**
+         * @brief Gets the glyphs of a card taking more than one cell.
+         *
+         * Terminals blank both cells of a wide glyph when one of them is overwritten, so
+         * card_table repaints a glyph cut by the edge of a damaged region whole. The glyphs
+         * of a card are asked at most once per composed band of rows, and only for cards cut
+         * by the edge of a region.
+         * It may be called from several threads at once, along with get_card_width and
+         * get_card_height, when card_table composes in parallel.
+         * The default implementation adds nothing.
+         *
+         * @param pCard Pointer to the card number.
+         * @param vGlyphs Receives the cells of every wide glyph, relative to the card.
+         */
+        virtual void get_wide_glyphs(const number *pCard, std::vector<rect> &vGlyphs) const;
+
+        /**
+         * @brief Adapts the renderer to the current size of its output.
+         *
+         * Called by card_table before rendering. Renderers whose output can be resized
+         * (a terminal window) return true once after every resize, so that the table is
+         * fully redrawn once however many resizes happened since the last check. Renderers
+         * dropping output return true too, so that the lost frames are redrawn.
+         * The default implementation returns false.
+         *
+         * @return true if the size of the table changed or output was lost, false otherwise.
+         */
+        virtual bool update_size() const;
+
+        /**
+         * @brief Starts a frame.
+         *
+         * card_table calls it before every render of the table and its cards, and
+         * end_frame after them, so that the renderer can present the frame at once.
+         * The default implementation does nothing.
+         */
+        virtual void begin_frame() const;
+
+        /**
+         * @brief Ends a frame started with begin_frame.
+         *
+         * The default implementation does nothing.
+         */
+        virtual void end_frame() const;
+
+    public:
+        /**
+         * @brief Gets the width of the rendered cards.
+         *
+         * Used by card_table to know which cells a card covers.
+         * The default implementation returns 1.
+         *
+         * @return The card width, in table cells.
+         */
+        virtual std::size_t get_card_width() const;
+
+        /**
+         * @brief Gets the height of the rendered cards.
+         *
+         * Used by card_table to know which cells a card covers.
+         * The default implementation returns 1.
+         *
+         * @return The card height, in table cells.
+         */
+        virtual std::size_t get_card_height() const;
     };
 
 } // namespace ac
@@ -24,13 +24,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <list>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
 #include "card_renderer.h"
 #include "card_holder.h"
+#include "card_change.h"
+#include "card_grid.h"
 
 namespace ac
 {
-    class number; ///< Forward declaration of the card class.
+    class number;       ///< Forward declaration of the card class.
+    class card_index;   ///< Forward declaration of the card_index class.
+    class card_journal; ///< Forward declaration of the card_journal class.
 
     /**
      * @class card_table
@@ -66,6 +77,18 @@ namespace ac
          */
         virtual void render() const;
 
+        /**
+         * @brief Renders regions of the card table.
+         *
+         * Called instead of render after a change, with the regions covered by the changed
+         * cards, when the renderer can render regions (card_renderer::can_render_regions).
+         * Derived classes overriding render should override this method too.
+         * This method isn't protetected by the mutex.
+         *
+         * @param vRegions The regions to render, in table cells.
+         */
+        virtual void render_regions(std::span<const rect> vRegions) const;
+
     public:
         /**
          * @brief Renders the card table.
@@ -75,6 +98,19 @@ namespace ac
          */
         void render_safe() const;
 
+        /**
+         * @brief Redraws the whole table if the output of the renderer was resized or lost.
+         *
+         * Meant to be called from the main loop of the application: however many times the
+         * terminal was resized since the last render, the table is redrawn once. The same
+         * goes for frames dropped by a congested terminal.
+         * This method is protetected by the mutex.
+         *
+         * @return true if the table was redrawn, so that the cards can be laid out again for
+         *         the new size, false otherwise.
+         */
+        bool refresh() const;
+
     public:
         /**
          * @brief Checks if rendering occurs on change.
@@ -90,6 +126,25 @@ namespace ac
          */
         void set_render_on_change(bool bRenderOnChange);
 
+        /**
+         * @brief Checks if large tables are composed in parallel.
+         *
+         * @return true if the composition is split in tiles on the shared thread pool, false otherwise.
+         */
+        bool get_parallel_composition() const;
+
+        /**
+         * @brief Sets whether large tables are composed in parallel.
+         *
+         * Bands of rows of the table are composed on the shared thread pool, each thread
+         * finding the exposed parts of the cards in its band. The cards are then drawn
+         * as in a serial composition, so the output is the same byte for byte.
+         * Enabled by default; small tables are always composed serially, without starting
+         * the shared pool.
+         * @param bParallelComposition A boolean value indicating if large tables are composed in parallel.
+         */
+        void set_parallel_composition(bool bParallelComposition);
+
         /**
          * @brief Gets the current card renderer.
          *
@@ -111,6 +166,132 @@ namespace ac
          */
         std::list<card_holder> get_holders() const;
 
+        /**
+         * @brief Replaces all the card holders in one update.
+         *
+         * The table is locked and rendered once, whatever the number of cards.
+         * The list order is the stacking order, from bottom to top.
+         *
+         * @param lHolders The new list of card holders.
+         */
+        void set_holders(std::list<card_holder> lHolders);
+
+        /**
+         * @brief Gets the journal recording the changes of the table.
+         *
+         * @return A pointer to the journal, or nullptr if none.
+         */
+        card_journal *get_journal() const;
+
+        /**
+         * @brief Sets the journal recording the changes of the table.
+         *
+         * The journal starts with a keyframe of the current state, and then records
+         * the changes of every mutator call as one frame. The table does not own the journal.
+         * A mutator whose changes the journal can not record (a card that is not part of the
+         * indexed deck) throws std::invalid_argument and leaves the table unchanged.
+         *
+         * @param pJournal A pointer to the journal, or nullptr to stop recording.
+         */
+        void set_journal(card_journal *pJournal);
+
+        /**
+         * @brief Applies a sequence of changes in one update.
+         *
+         * The changes are applied all or nothing, and recorded as one frame.
+         *
+         * @param vChanges The changes, in order. RESET changes are not accepted.
+         * @throws std::invalid_argument If a change does not match the table. The table is left unchanged.
+         */
+        void apply_changes(std::span<const card_change> vChanges);
+
+    public:
+        /**
+         * @brief Gets the maximum number of undo steps kept.
+         *
+         * @return The maximum number of steps, 0 if the history is disabled.
+         */
+        std::size_t get_history_limit() const;
+
+        /**
+         * @brief Sets the maximum number of undo steps kept.
+         *
+         * Every mutator call that changes the table is one step. A step stores the changes
+         * of the call, whose size does not depend on the size of the table; the oldest steps
+         * are dropped once the limit is reached. The exception are set_holders and
+         * load_snapshot, whose steps keep copies of the table before and after the call.
+         * The history is cleared.
+         *
+         * @param nLimit The maximum number of steps. 0 disables the history (the default).
+         */
+        void set_history_limit(std::size_t nLimit);
+
+        /**
+         * @brief Checks if there is a step to undo.
+         *
+         * @return true if undo would change the table, false otherwise.
+         */
+        bool can_undo() const;
+
+        /**
+         * @brief Checks if there is a step to redo.
+         *
+         * @return true if redo would change the table, false otherwise.
+         */
+        bool can_redo() const;
+
+        /**
+         * @brief Undoes the last step, in one update.
+         *
+         * The inverse changes are applied in reverse order and rendered once.
+         * The step can be redone until the table is changed by another mutator call.
+         *
+         * @return true if a step was undone, false if there was nothing to undo.
+         */
+        bool undo();
+
+        /**
+         * @brief Redoes the last undone step, in one update.
+         *
+         * @return true if a step was redone, false if there was nothing to redo.
+         */
+        bool redo();
+
+        /**
+         * @brief Forgets all the steps to undo and redo.
+         */
+        void clear_history();
+
+    public:
+        /// Callback receiving the changes of one mutator call.
+        using observer = std::function<void(std::span<const card_change>)>;
+
+        /**
+         * @brief Subscribes to the changes of the table.
+         *
+         * Every mutator call that changes the table is delivered as one batch, holding its
+         * card_change sequence: INSERT for added cards, ERASE for removed cards, MOVE for
+         * horizontal moves, RESTACK for layer changes, REPLACE, VISIBILITY, and RESET for
+         * set_holders and load_snapshot.
+         * Batches are delivered in order, one at a time, after the table is unlocked, so an
+         * observer may query or change the table; the batches it causes are delivered once it returns.
+         * Observers must not throw.
+         *
+         * @param fnObserver The callback.
+         * @return An identifier for unsubscribe.
+         * @throws std::invalid_argument If fnObserver is empty.
+         */
+        std::size_t subscribe(observer fnObserver);
+
+        /**
+         * @brief Cancels a subscription.
+         *
+         * A batch already being delivered may still reach the observer.
+         *
+         * @param nId The identifier returned by subscribe. Unknown identifiers are ignored.
+         */
+        void unsubscribe(std::size_t nId);
+
     protected:
         /**
          * @brief Gets the current card renderer.
@@ -158,6 +339,28 @@ namespace ac
          */
         void remove_all_cards();
 
+        /**
+         * @brief Places a group of cards on top of the table, in one update.
+         *
+         * Same as calling stack_card for every card in order, but the table is scanned and
+         * rendered once. Positions are usually computed with card_layout.
+         * @param vCards Pointers to the cards, from bottom to top. nullptr entries are skipped.
+         * @param vPositions The positions of the cards.
+         * @throws std::invalid_argument If the spans have different sizes.
+         */
+        void stack_cards(std::span<const number *const> vCards, std::span<const point> vPositions);
+
+        /**
+         * @brief Moves a group of cards horizontally, in one update.
+         *
+         * Same as calling shift_horizontal_card for every card, keeping the stacking order,
+         * but the table is scanned and rendered once. Cards not on the table are ignored.
+         * @param vCards Pointers to the cards. nullptr entries are skipped.
+         * @param vPositions The new positions of the cards.
+         * @throws std::invalid_argument If the spans have different sizes.
+         */
+        void move_cards(std::span<const number *const> vCards, std::span<const point> vPositions);
+
     public:
         /**
          * @brief Checks if a specific card is present on the table.
@@ -187,6 +390,29 @@ namespace ac
          */
         std::size_t get_card_count() const;
 
+        /**
+         * @brief Gets the topmost visible card covering a cell.
+         *
+         * Cards cover the size given by the renderer (card_renderer::get_card_width and
+         * card_renderer::get_card_height), or a single cell if there is no renderer.
+         * The spatial index answering the query is built on first use and then kept up to
+         * date by the mutators, so that queries do not walk the table.
+         *
+         * @param oPoint The cell.
+         * @return The card, or nullptr if no visible card covers the cell.
+         */
+        const number *get_card_at(const point &oPoint) const;
+
+        /**
+         * @brief Gets the visible cards overlapping a rectangle.
+         *
+         * See get_card_at for the size of the cards.
+         *
+         * @param oRect The rectangle.
+         * @return The cards, in stacking order (bottom to top).
+         */
+        std::vector<const number *> get_cards_in(const rect &oRect) const;
+
     public:
         /**
          * @brief Shifts a card horizontally to a new position if it is found.
@@ -300,13 +526,239 @@ namespace ac
          */
         void set_card_visible(const number *pCard, bool bVisible);
 
+    public:
+        /**
+         * @brief Serializes the table to JSON format and writes it to the output stream.
+         *
+         * Cards are identified by the names of their suit and number, and listed in
+         * stacking order, from bottom to top. The output has the following schema:
+         * `{"cards": [{"suit": string, "number": string, "x": number, "y": number, "visible": bool}, ...]}`.
+         *
+         * @param oOstream The output stream to which the JSON representation will be written.
+         */
+        void to_json(std::ostream &oOstream) const;
+
+        /**
+         * @brief Serializes the table to JSON format and appends it to a buffer.
+         *
+         * The buffer is not cleared, so it may be reused across calls to avoid reallocations.
+         *
+         * @param sBuffer The buffer to which the JSON representation will be appended.
+         */
+        void to_json(std::string &sBuffer) const;
+
+        /**
+         * @brief Serializes the table to JSON format and returns the output string.
+         *
+         * @return Output as string
+         */
+        std::string to_json() const;
+
+    public:
+        /**
+         * @brief Appends a binary snapshot of the table to a buffer.
+         *
+         * The snapshot is a compact, versioned alternative to to_json, meant for frequent
+         * checkpoints. Layout (version 1):
+         * - magic `ACTS` and version, as a varint;
+         * - fingerprint of the deck (card_index::get_fingerprint), 8 bytes little endian;
+         * - card count, as a varint;
+         * - for every card, bottom to top: card identifier, x and y, as varints;
+         * - visibility bitmap, one bit per card, least significant bit first.
+         *
+         * The buffer is not cleared, so it may be reused across calls to avoid reallocations.
+         *
+         * @param sBuffer The buffer to which the snapshot will be appended.
+         * @param oIndex The index of the deck containing the cards.
+         * @throws std::invalid_argument If a card on the table is not part of the indexed deck.
+         *         The buffer is left unchanged.
+         */
+        void save_snapshot(std::string &sBuffer, const card_index &oIndex) const;
+
+        /**
+         * @brief Returns a binary snapshot of the table.
+         *
+         * @param oIndex The index of the deck containing the cards.
+         * @return The snapshot.
+         * @throws std::invalid_argument If a card on the table is not part of the indexed deck.
+         */
+        std::string save_snapshot(const card_index &oIndex) const;
+
+        /**
+         * @brief Replaces the contents of the table with a binary snapshot, in one update.
+         *
+         * The data is read in place, without copying it.
+         *
+         * @param sData The snapshot written by save_snapshot.
+         * @param oIndex The index of the deck containing the cards.
+         * @return The number of bytes read. The snapshot may be followed by other data.
+         * @throws std::runtime_error If the data is not a valid snapshot (including a card
+         *         appearing twice), or was written against a different deck. The table is
+         *         left unchanged.
+         */
+        std::size_t load_snapshot(std::string_view sData, const card_index &oIndex);
+
+        /**
+         * @brief Appends a binary snapshot of a list of card holders to a buffer.
+         *
+         * See save_snapshot for the layout.
+         *
+         * @param sBuffer The buffer to which the snapshot will be appended.
+         * @param lHolders The card holders, in stacking order.
+         * @param oIndex The index of the deck containing the cards.
+         * @throws std::invalid_argument If a card is not part of the indexed deck.
+         *         The buffer is left unchanged.
+         */
+        static void write_snapshot(std::string &sBuffer, const std::list<card_holder> &lHolders, const card_index &oIndex);
+
+        /**
+         * @brief Reads a binary snapshot into a list of card holders.
+         *
+         * @param sData The snapshot.
+         * @param oIndex The index of the deck containing the cards.
+         * @param lHolders Receives the card holders, in stacking order.
+         * @return The number of bytes read.
+         * @throws std::runtime_error If the data is not a valid snapshot, or was written against a different deck.
+         */
+        static std::size_t read_snapshot(std::string_view sData, const card_index &oIndex, std::list<card_holder> &lHolders);
+
     protected:
         mutable std::mutex m_oMutex; ///< Mutex for multithread applications
 
     private:
-        std::list<card_holder> m_lCards;  ///< List of cards on the table.
-        const card_renderer *m_pRenderer; ///< Renderer for the card table
-        bool m_bRenderOnChange;           ///< Render table when it changes
+        std::list<card_holder> m_lCards;     ///< List of cards on the table.
+        const card_renderer *m_pRenderer;    ///< Renderer for the card table
+        bool m_bRenderOnChange;              ///< Render table when it changes
+        bool m_bParallelComposition;         ///< Compose large tables in parallel
+        card_journal *m_pJournal;            ///< Journal recording the changes, if any
+        std::vector<card_change> m_vChanges; ///< Changes of the ongoing mutator call
+
+    private:
+        /**
+         * @struct history_step
+         * @brief The changes of one mutator call, kept to undo and redo it.
+         */
+        struct history_step
+        {
+            std::vector<card_change> m_vChanges; ///< The changes, in order.
+            std::list<card_holder> m_lBefore;    ///< The table before a RESET.
+            std::list<card_holder> m_lAfter;     ///< The table after a RESET.
+        };
+
+    private:
+        std::size_t m_nHistoryLimit;        ///< Maximum number of undo steps, 0 if disabled
+        std::deque<history_step> m_dUndo;   ///< Steps to undo, the last one is the latest
+        std::deque<history_step> m_dRedo;   ///< Steps to redo, the last one is the latest undone
+        std::list<card_holder> m_lPrevious; ///< The table before the RESET of the ongoing mutator call, to undo or roll back
+
+    private:
+        /// Subscribed observers, by identifier.
+        using observer_list = std::vector<std::pair<std::size_t, observer>>;
+
+        /**
+         * @class change_notifier
+         * @brief Delivers the pending batches when it goes out of scope.
+         *
+         * Mutators declare it before locking the mutex, so that delivery happens once it is unlocked.
+         */
+        class change_notifier
+        {
+        public:
+            /**
+             * @brief Constructs a change_notifier object.
+             * @param pTable The notifying table.
+             */
+            change_notifier(card_table *pTable) : m_pTable(pTable) {}
+
+            /**
+             * @brief Delivers the pending batches of the table.
+             */
+            ~change_notifier() { this->m_pTable->notify(); }
+
+        private:
+            card_table *m_pTable; ///< The notifying table.
+        };
+
+    private:
+        std::shared_ptr<const observer_list> m_pObservers; ///< Subscribed observers, replaced on every change of subscription
+        std::size_t m_nNextObserver;                       ///< Identifier of the next subscription
+        std::deque<std::vector<card_change>> m_dPending;   ///< Batches waiting to be delivered
+        std::mutex m_oDeliveryMutex;                       ///< Held while delivering batches
+        std::atomic<std::thread::id> m_oDeliveryThread;    ///< Thread delivering batches, if any
+
+    private:
+        mutable std::unique_ptr<card_grid> m_pGrid; ///< Spatial index, built on first use
+        mutable bool m_bGridDirty;                  ///< The spatial index must be rebuilt
+
+    private:
+        /**
+         * @brief Delivers the pending batches to the observers.
+         *
+         * This version must be called with the mutex unlocked.
+         * If another thread is delivering, it delivers these batches too.
+         */
+        void notify();
+
+        /**
+         * @brief Publishes the changes of the ongoing mutator call, and renders if needed.
+         *
+         * Does nothing if there are no changes.
+         * This version does not lock the mutex.
+         * @param bRecordHistory Whether the changes are a new undo step (false for undo and redo).
+         * @throws std::invalid_argument If the journal can not record the changes. They are rolled back.
+         */
+        void commit_unlocked(bool bRecordHistory = true);
+
+        /**
+         * @brief Reverts the changes of the ongoing mutator call, and forgets them.
+         *
+         * This version does not lock the mutex.
+         */
+        void rollback_unlocked();
+
+        /**
+         * @brief Removes all the occurrences of a card, recording the changes.
+         *
+         * This version does not lock the mutex.
+         * @param pCard Pointer to the card to be removed.
+         */
+        void erase_unlocked(const number *pCard);
+
+        /**
+         * @brief Moves a card to another layer, recording the change.
+         *
+         * This version does not lock the mutex.
+         * @param pCard Pointer to the card to move.
+         * @param fnNewIndex Computes the new layer from the current one. The result is clamped to the top.
+         */
+        void restack_unlocked(const number *pCard, const std::function<std::size_t(std::size_t)> &fnNewIndex);
+
+        /**
+         * @brief Gets the spatial index, building or rebuilding it if needed.
+         *
+         * The index is built anew when the renderer changed the size of the cards.
+         * This version does not lock the mutex.
+         * @return The spatial index.
+         */
+        const card_grid &get_grid_unlocked() const;
+
+        /**
+         * @brief Renders the visible cards, skipping the covered cells.
+         *
+         * This version does not lock the mutex.
+         * @param vRegions The regions to render, when clipping.
+         * @param bClip true to render only the cells inside vRegions, false to render every card.
+         */
+        void render_cards_unlocked(std::span<const rect> vRegions, bool bClip) const;
+
+        /**
+         * @brief Gets the regions damaged by the changes of the ongoing mutator call.
+         *
+         * This version does not lock the mutex.
+         * @param vDamaged Receives the damaged regions.
+         * @return true if the regions were found, false if the whole table must be rendered.
+         */
+        bool get_damage_unlocked(std::vector<rect> &vDamaged) const;
     };
 
 } // namespace ac
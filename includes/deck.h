@@ -25,9 +25,14 @@
 #pragma once
 
 #include "suit.h"
+#include "deck_definition.h"
+
+#include <memory>
 
 namespace ac
 {
+    class json_item; ///< Forward declaration of the json_item class.
+
     /**
      * @class deck
      * @brief Represents a deck of cards in a card game.
@@ -38,6 +43,8 @@ namespace ac
      */
     class deck
     {
+        friend class deck_builder; ///< Allows the builder to fill decks in one shot.
+
     public:
         /**
          * @brief Generates a standard poker deck of cards.
@@ -64,6 +71,35 @@ namespace ac
          */
         static deck *generate_spanish_deck(std::size_t nJokers = 0);
 
+        /**
+         * @brief Generates a deck from a compile-time definition.
+         *
+         * The whole deck is built in one shot, without locking the deck or its suits
+         * for every inserted element, as the deck is not shared until returned.
+         *
+         * @param oDefinition The definition of the deck (see deck_definition.h).
+         * @param nJokers The number of jokers to include in the deck. Default is 0.
+         * @return A pointer to a dynamically allocated deck containing the cards.
+         *         The caller is responsible for freeing the allocated memory.
+         */
+        static deck *generate_deck(const deck_definition &oDefinition, std::size_t nJokers = 0);
+
+        /**
+         * @brief Loads a deck from JSON data.
+         *
+         * This is the counterpart of deck::to_json, and expects the same schema.
+         * The whole deck is built in one pass, without locking the deck or its suits
+         * for every inserted element, as the deck is not shared until returned.
+         *
+         * @param pItem The JSON object describing the deck.
+         * @return A pointer to a dynamically allocated deck containing the cards.
+         *         The caller is responsible for freeing the allocated memory.
+         * @throws std::invalid_argument If pItem is nullptr.
+         * @throws std::runtime_error If the data does not follow the schema (missing keys,
+         *         empty names or duplicated suits or numbers).
+         */
+        static deck *from_json(const json_item *pItem);
+
     public:
         /**
          * @brief Constructor to create a deck with a name.
@@ -194,10 +230,23 @@ namespace ac
         /**
          * @brief Serializes the object to JSON format and writes it to the output stream.
          *
+         * The output has the following schema:
+         * `{"name": string, "display_name": string, "suits": [{"name": string, "display_name": string,
+         * "numbers": [{"name": string, "display_name": string}, ...]}, ...]}`.
+         *
          * @param oOstream The output stream to which the JSON representation will be written.
          */
         void to_json(std::ostream &oOstream) const;
 
+        /**
+         * @brief Serializes the object to JSON format and appends it to a buffer.
+         *
+         * The buffer is not cleared, so it may be reused across calls to avoid reallocations.
+         *
+         * @param sBuffer The buffer to which the JSON representation will be appended.
+         */
+        void to_json(std::string &sBuffer) const;
+
         /**
          * @brief Serializes the object to JSON format and returns the output string.
          *
@@ -210,6 +259,64 @@ namespace ac
         std::string m_sDisplayName;             ///< The display name of the deck.
         std::map<std::string, suit *> m_mSuits; ///< Map of suits associated with the deck.
         mutable std::mutex m_oMutex;            ///< Mutex for multithread applications
+
+    private:
+        /**
+         * @brief Creates a suit without locking the deck.
+         *
+         * Used for bulk construction of decks that are not yet shared.
+         * If a suit with the same name exists, it is replaced.
+         * @param sName The name of the suit to create.
+         * @param sDisplayName The display name of the suit to create.
+         * @return A pointer to the newly created suit.
+         */
+        suit *emplace_suit_unlocked(const std::string &sName, const std::string &sDisplayName);
+    };
+
+    /**
+     * @class deck_builder
+     * @brief Builds a deck read from JSON in one pass, validating every element.
+     *
+     * Shared by deck::from_json and deck_sax_builder, so that both readers accept the
+     * same decks. The deck is not shared until released, so it is filled without locking.
+     */
+    class deck_builder
+    {
+    public:
+        /**
+         * @brief Starts a deck.
+         * @param sName The name of the deck.
+         * @param sDisplayName The display name of the deck.
+         * @throws std::runtime_error If the name is empty.
+         */
+        deck_builder(const std::string &sName, const std::string &sDisplayName);
+
+        /**
+         * @brief Adds a suit to the deck. The numbers added next go to it.
+         * @param sName The name of the suit.
+         * @param sDisplayName The display name of the suit.
+         * @throws std::runtime_error If the name is empty or the deck already has the suit.
+         */
+        void add_suit(const std::string &sName, const std::string &sDisplayName);
+
+        /**
+         * @brief Adds a number to the last suit added.
+         * @param sName The name of the number.
+         * @param sDisplayName The display name of the number.
+         * @throws std::runtime_error If no suit was added, the name is empty or the suit already has the number.
+         */
+        void add_number(const std::string &sName, const std::string &sDisplayName);
+
+        /**
+         * @brief Hands the deck over.
+         * @return A pointer to a dynamically allocated deck, or nullptr if already released.
+         *         The caller is responsible for freeing the allocated memory.
+         */
+        deck *release();
+
+    private:
+        std::unique_ptr<deck> m_pDeck; ///< The deck being built.
+        suit *m_pSuit;                 ///< The last suit added.
     };
 
 } // namespace ac
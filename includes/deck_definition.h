@@ -0,0 +1,284 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file deck_definition.h
+ * @brief Compile-time descriptions of the built-in card decks.
+ *
+ * The definitions in this file are constexpr and can be inspected at compile time
+ * (names, display glyphs, ordinals and default colors). A runtime deck may be built
+ * from any of them in one shot using deck::generate_deck, and ansi_card_renderer
+ * takes its default colors from them.
+ */
+
+#pragma once
+
+#include "ansi.h"
+
+#include <array>
+#include <span>
+#include <string_view>
+
+namespace ac
+{
+
+    /**
+     * @class number_definition
+     * @brief Compile-time description of a card number.
+     */
+    class number_definition
+    {
+    public:
+        /**
+         * @brief Constructs a number definition.
+         * @param sName The name of the number.
+         * @param sDisplayName The display name of the number.
+         */
+        constexpr number_definition(std::string_view sName, std::string_view sDisplayName)
+            : m_sName(sName), m_sDisplayName(sDisplayName) {}
+
+    public:
+        /**
+         * @brief Gets the name of the number.
+         * @return The name of the number.
+         */
+        constexpr std::string_view get_name() const { return this->m_sName; }
+
+        /**
+         * @brief Gets the display name of the number.
+         * @return The display name of the number.
+         */
+        constexpr std::string_view get_display_name() const { return this->m_sDisplayName; }
+
+    private:
+        std::string_view m_sName;        ///< The name of the number.
+        std::string_view m_sDisplayName; ///< The display name of the number.
+    };
+
+    /**
+     * @class suit_definition
+     * @brief Compile-time description of a suit.
+     */
+    class suit_definition
+    {
+    public:
+        /**
+         * @brief Constructs a suit definition.
+         * @param sName The name of the suit.
+         * @param sDisplayName The display name (glyph) of the suit.
+         * @param nColor The default color used to render the suit.
+         * @param vNumbers The numbers of the suit, in ordinal order.
+         */
+        constexpr suit_definition(std::string_view sName, std::string_view sDisplayName, ansi_color nColor, std::span<const number_definition> vNumbers)
+            : m_sName(sName), m_sDisplayName(sDisplayName), m_nColor(nColor), m_vNumbers(vNumbers) {}
+
+    public:
+        /**
+         * @brief Gets the name of the suit.
+         * @return The name of the suit.
+         */
+        constexpr std::string_view get_name() const { return this->m_sName; }
+
+        /**
+         * @brief Gets the display name (glyph) of the suit.
+         * @return The display name of the suit.
+         */
+        constexpr std::string_view get_display_name() const { return this->m_sDisplayName; }
+
+        /**
+         * @brief Gets the default color used to render the suit.
+         * @return The default ANSI color of the suit.
+         */
+        constexpr ansi_color get_color() const { return this->m_nColor; }
+
+        /**
+         * @brief Gets the numbers of the suit.
+         * @return The numbers of the suit, in ordinal order.
+         */
+        constexpr std::span<const number_definition> get_numbers() const { return this->m_vNumbers; }
+
+        /**
+         * @brief Gets the number of numbers in the suit.
+         * @return The number of numbers in the suit.
+         */
+        constexpr std::size_t get_number_count() const { return this->m_vNumbers.size(); }
+
+        /**
+         * @brief Gets the rank of a number inside the suit, from its position.
+         * @param sName The name of the number.
+         * @return The ordinal of the number, or 0 if not found. Origin: 1.
+         */
+        constexpr std::size_t get_ordinal(std::string_view sName) const
+        {
+            for (std::size_t nNumber = 0; nNumber < this->m_vNumbers.size(); ++nNumber)
+                if (this->m_vNumbers[nNumber].get_name() == sName)
+                    return nNumber + 1;
+            return 0;
+        }
+
+    private:
+        std::string_view m_sName;                      ///< The name of the suit.
+        std::string_view m_sDisplayName;               ///< The display name of the suit.
+        ansi_color m_nColor;                           ///< The default color of the suit.
+        std::span<const number_definition> m_vNumbers; ///< The numbers of the suit.
+    };
+
+    /**
+     * @class deck_definition
+     * @brief Compile-time description of a deck.
+     *
+     * The joker suit is described separately, since its numbers are generated
+     * at runtime depending on the requested amount of jokers.
+     */
+    class deck_definition
+    {
+    public:
+        /**
+         * @brief Constructs a deck definition.
+         * @param sName The name of the deck.
+         * @param sDisplayName The display name of the deck.
+         * @param vSuits The suits of the deck.
+         * @param oJokers The description of the joker suit.
+         */
+        constexpr deck_definition(std::string_view sName, std::string_view sDisplayName, std::span<const suit_definition> vSuits, const suit_definition &oJokers)
+            : m_sName(sName), m_sDisplayName(sDisplayName), m_vSuits(vSuits), m_oJokers(oJokers) {}
+
+    public:
+        /**
+         * @brief Gets the name of the deck.
+         * @return The name of the deck.
+         */
+        constexpr std::string_view get_name() const { return this->m_sName; }
+
+        /**
+         * @brief Gets the display name of the deck.
+         * @return The display name of the deck.
+         */
+        constexpr std::string_view get_display_name() const { return this->m_sDisplayName; }
+
+        /**
+         * @brief Gets the suits of the deck (jokers excluded).
+         * @return The suits of the deck.
+         */
+        constexpr std::span<const suit_definition> get_suits() const { return this->m_vSuits; }
+
+        /**
+         * @brief Gets the description of the joker suit.
+         * @return The joker suit definition.
+         */
+        constexpr const suit_definition &get_jokers() const { return this->m_oJokers; }
+
+        /**
+         * @brief Gets the number of suits in the deck (jokers excluded).
+         * @return The number of suits.
+         */
+        constexpr std::size_t get_suit_count() const { return this->m_vSuits.size(); }
+
+        /**
+         * @brief Gets the number of cards in the deck (jokers excluded).
+         * @return The number of cards.
+         */
+        constexpr std::size_t get_number_count() const
+        {
+            std::size_t nCount = 0;
+            for (const suit_definition &oSuit : this->m_vSuits)
+                nCount += oSuit.get_number_count();
+            return nCount;
+        }
+
+        /**
+         * @brief Looks for a suit by its name.
+         * @param sName The name of the suit.
+         * @return A pointer to the suit definition, or nullptr if not found.
+         */
+        constexpr const suit_definition *find_suit(std::string_view sName) const
+        {
+            for (const suit_definition &oSuit : this->m_vSuits)
+                if (oSuit.get_name() == sName)
+                    return &oSuit;
+            if (this->m_oJokers.get_name() == sName)
+                return &this->m_oJokers;
+            return nullptr;
+        }
+
+    private:
+        std::string_view m_sName;                  ///< The name of the deck.
+        std::string_view m_sDisplayName;           ///< The display name of the deck.
+        std::span<const suit_definition> m_vSuits; ///< The suits of the deck.
+        const suit_definition &m_oJokers;          ///< The joker suit.
+    };
+
+    /// Numbers of a poker suit.
+    inline constexpr std::array<number_definition, 13> POKER_NUMBERS = {
+        number_definition("1", "A"),
+        number_definition("2", "2"),
+        number_definition("3", "3"),
+        number_definition("4", "4"),
+        number_definition("5", "5"),
+        number_definition("6", "6"),
+        number_definition("7", "7"),
+        number_definition("8", "8"),
+        number_definition("9", "9"),
+        number_definition("10", "10"),
+        number_definition("11", "J"),
+        number_definition("12", "Q"),
+        number_definition("13", "K")};
+
+    /// Numbers of a spanish suit.
+    inline constexpr std::array<number_definition, 10> SPANISH_NUMBERS = {
+        number_definition("1", "A"),
+        number_definition("2", "2"),
+        number_definition("3", "3"),
+        number_definition("4", "4"),
+        number_definition("5", "5"),
+        number_definition("6", "6"),
+        number_definition("7", "7"),
+        number_definition("8", "S"),
+        number_definition("9", "C"),
+        number_definition("10", "R")};
+
+    /// Joker suit shared by the built-in decks. Its numbers are generated at runtime.
+    inline constexpr suit_definition JOKER_SUIT = suit_definition("joker", "Joker", ansi_color::MAGENTA, {});
+
+    /// Suits of the poker deck.
+    inline constexpr std::array<suit_definition, 4> POKER_SUITS = {
+        suit_definition("heart", "\u2665", ansi_color::RED, POKER_NUMBERS),
+        suit_definition("diamond", "\u2666", ansi_color::CYAN, POKER_NUMBERS),
+        suit_definition("club", "\u2663", ansi_color::GREEN, POKER_NUMBERS),
+        suit_definition("spade", "\u2660", ansi_color::BRIGHT_BLACK, POKER_NUMBERS)};
+
+    /// Suits of the spanish deck.
+    inline constexpr std::array<suit_definition, 4> SPANISH_SUITS = {
+        suit_definition("gold", "\U0001F3C5", ansi_color::YELLOW, SPANISH_NUMBERS),
+        suit_definition("cup", "\U0001F3C6", ansi_color::CYAN, SPANISH_NUMBERS),
+        suit_definition("club", "\U0001F3CF", ansi_color::GREEN, SPANISH_NUMBERS),
+        suit_definition("sword", "\U00002694", ansi_color::BRIGHT_BLACK, SPANISH_NUMBERS)};
+
+    /// The standard 52 card poker deck.
+    inline constexpr deck_definition POKER_DECK = deck_definition("poker_deck", "Poker deck", POKER_SUITS, JOKER_SUIT);
+
+    /// The spanish 40 card deck.
+    inline constexpr deck_definition SPANISH_DECK = deck_definition("spanish_deck", "Spanish Deck", SPANISH_SUITS, JOKER_SUIT);
+
+    static_assert(POKER_DECK.get_number_count() == 52, "The poker deck must have 52 cards.");
+    static_assert(SPANISH_DECK.get_number_count() == 40, "The spanish deck must have 40 cards.");
+    static_assert(POKER_SUITS[0].get_ordinal("13") == 13, "Poker numbers must be in ordinal order.");
+    static_assert(SPANISH_SUITS[0].get_ordinal("10") == 10, "Spanish numbers must be in ordinal order.");
+
+} // namespace ac
@@ -54,6 +54,17 @@ namespace ac
          */
         void display_spanish_deck();
 
+        /**
+         * @brief Checks that parallel composition draws the same as serial composition.
+         *
+         * Renders a large table of overlapping cards, whole and by damaged regions, with
+         * parallel composition enabled and disabled, through a renderer recording every
+         * call, and compares the records.
+         *
+         * @return True if both compositions draw the same.
+         */
+        bool check_parallel_composition();
+
     } // namespace example
 
 } // namespace ac
@@ -26,25 +26,59 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace ac
 {
 
     /**
-     * @brief Writes an escaped version of a string to the output stream.
+     * @brief Appends an escaped version of a string to a buffer.
      *
-     * This function takes a string and writes it to the provided output stream,
-     * escaping special characters and converting non-printable characters to their
-     * hexadecimal representation in the format \xHH, where HH is the hexadecimal
-     * value of the character.
+     * This function takes a string and appends it to the provided buffer as a JSON
+     * string literal, escaping quotes, backslashes and control characters (the latter
+     * in the format \u00HH). Other bytes (including UTF-8 sequences) are copied as-is,
+     * in bulk runs.
      * The final string is enclosed by \".
      *
+     * @param sBuffer The buffer to which the escaped string will be appended.
+     * @param sString The string to be escaped and written.
+     */
+    void write_json_string(std::string &sBuffer, std::string_view sString);
+
+    /**
+     * @brief Writes an escaped version of a string to the output stream.
+     *
+     * See write_json_string(std::string &, std::string_view) for the escaping rules.
+     *
      * @param oOstream The output stream to which the escaped string will be written.
      * @param sString The string to be escaped and written.
      */
     void write_json_string(std::ostream &oOstream, const std::string &sString);
 
+    /**
+     * @brief Gets the value of a hexadecimal digit of a \u escape sequence.
+     *
+     * Shared by the JSON parsers of the library.
+     * @param c The character.
+     * @return The value of the digit, or -1 if it is not a hexadecimal digit.
+     */
+    int get_json_hex_digit(int c);
+
+    /**
+     * @enum json_type
+     * @brief Enum class representing the type of a JSON value.
+     */
+    enum class json_type
+    {
+        NUL,     ///< The null literal.
+        BOOLEAN, ///< The true or false literals.
+        NUMBER,  ///< A number.
+        STRING,  ///< A string.
+        ARRAY,   ///< An array of values.
+        OBJECT,  ///< An object of key-value pairs.
+    };
+
     /**
      * @class json_item
      * @brief Interface for parsing JSON data.
@@ -54,6 +88,12 @@ namespace ac
      */
     class json_item
     {
+    public:
+        /**
+         * @brief Destructor for json_item.
+         */
+        virtual ~json_item() = default;
+
     public:
         /**
          * @brief Retrieves a JSON item associated with the specified key.
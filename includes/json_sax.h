@@ -0,0 +1,328 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file json_sax.h
+ * @brief Streaming (event driven) JSON reader and the deck and card table builders fed by it.
+ */
+
+#pragma once
+
+#include "json.h"
+#include "card_holder.h"
+
+#include <functional>
+#include <list>
+
+namespace ac
+{
+
+    class deck;       ///< Forward declaration of the deck class.
+    class card_table; ///< Forward declaration of the card_table class.
+
+    /**
+     * @class json_sax_handler
+     * @brief Interface receiving the events of a json_sax_reader.
+     *
+     * The views passed to the handler are only valid during the call.
+     */
+    class json_sax_handler
+    {
+    public:
+        /**
+         * @brief Destructor for json_sax_handler.
+         */
+        virtual ~json_sax_handler() = default;
+
+    public:
+        /**
+         * @brief Called when an object starts.
+         */
+        virtual void on_start_object() = 0;
+
+        /**
+         * @brief Called when an object ends.
+         */
+        virtual void on_end_object() = 0;
+
+        /**
+         * @brief Called when an array starts.
+         */
+        virtual void on_start_array() = 0;
+
+        /**
+         * @brief Called when an array ends.
+         */
+        virtual void on_end_array() = 0;
+
+        /**
+         * @brief Called for every key of an object, right before its value.
+         * @param sKey The unescaped key.
+         */
+        virtual void on_key(std::string_view sKey) = 0;
+
+        /**
+         * @brief Called for every scalar value.
+         * @param nType The type of the value (never ARRAY nor OBJECT).
+         * @param sValue The unescaped string, or the number or literal as written.
+         */
+        virtual void on_value(json_type nType, std::string_view sValue) = 0;
+    };
+
+    /**
+     * @class json_sax_reader
+     * @brief Streaming JSON reader.
+     *
+     * The reader consumes an input stream through a fixed size buffer and reports
+     * the document as events to a json_sax_handler. Memory usage does not depend on
+     * the document size, only on the longest string or number and the nesting depth.
+     * The stream may contain several top-level values separated by whitespace
+     * (for instance, one value per line).
+     */
+    class json_sax_reader
+    {
+    public:
+        /**
+         * @brief The default size of the read buffer.
+         */
+        static constexpr std::size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+        /**
+         * @brief The maximum nesting depth accepted by the reader.
+         */
+        static constexpr std::size_t MAX_DEPTH = 512;
+
+    public:
+        /**
+         * @brief Constructs a reader over an input stream.
+         * @param oIstream The input stream from which to read the JSON data.
+         * @param nBufferSize The size of the read buffer.
+         */
+        json_sax_reader(std::istream &oIstream, std::size_t nBufferSize = DEFAULT_BUFFER_SIZE);
+
+    public:
+        /**
+         * @brief Parses the next top-level value.
+         * @param pHandler The handler receiving the events.
+         * @return True if a value was parsed, false if the end of the stream was reached.
+         * @throws std::runtime_error If the data is not valid JSON.
+         */
+        bool parse_next(json_sax_handler *pHandler);
+
+        /**
+         * @brief Parses all the top-level values until the end of the stream.
+         * @param pHandler The handler receiving the events.
+         * @return The number of top-level values parsed.
+         * @throws std::runtime_error If the data is not valid JSON.
+         */
+        std::size_t parse(json_sax_handler *pHandler);
+
+        /**
+         * @brief Gets the number of bytes consumed so far.
+         * @return The offset in the stream.
+         */
+        std::size_t get_offset() const noexcept;
+
+    private:
+        std::istream &m_oIstream;    ///< The input stream.
+        std::vector<char> m_vBuffer; ///< The read buffer.
+        std::size_t m_nPos;          ///< Read position inside the buffer.
+        std::size_t m_nEnd;          ///< End of the valid data inside the buffer.
+        std::size_t m_nConsumed;     ///< Bytes consumed before the current buffer.
+        std::string m_sToken;        ///< Scratch space for strings and numbers.
+
+    private:
+        /**
+         * @brief Peeks the next byte.
+         * @return The next byte, or -1 at the end of the stream.
+         */
+        int peek();
+
+        /**
+         * @brief Consumes the next byte.
+         * @return The consumed byte, or -1 at the end of the stream.
+         */
+        int get();
+
+        /**
+         * @brief Refills the buffer.
+         * @return False at the end of the stream.
+         */
+        bool refill();
+
+        /**
+         * @brief Skips whitespace.
+         */
+        void skip_whitespace();
+
+        /**
+         * @brief Parses a value and reports it.
+         * @param pHandler The handler receiving the events.
+         * @param nDepth The nesting depth.
+         */
+        void parse_value(json_sax_handler *pHandler, std::size_t nDepth);
+
+        /**
+         * @brief Parses a string into the token, after its opening quote.
+         */
+        void parse_string();
+
+        /**
+         * @brief Parses a number into the token.
+         */
+        void parse_number();
+
+        /**
+         * @brief Consumes an expected literal.
+         * @param sLiteral The literal.
+         */
+        void expect(std::string_view sLiteral);
+
+        /**
+         * @brief Throws a parse error.
+         * @param sMessage The error message.
+         */
+        [[noreturn]] void fail(const char *sMessage) const;
+    };
+
+    /**
+     * @class deck_sax_builder
+     * @brief Handler building decks from json_sax_reader events.
+     *
+     * Accepts the schema written by deck::to_json. The input may be a single deck,
+     * an array of decks or a sequence of top-level decks. Every deck is built in one
+     * shot once its object ends, and handed over to a callback, so that catalogs of
+     * any size are loaded in constant memory. Unknown keys are ignored.
+     */
+    class deck_sax_builder : public json_sax_handler
+    {
+    public:
+        /**
+         * @brief Constructs a deck builder.
+         * @param fnOnDeck Callback receiving every loaded deck. The callback owns the deck.
+         */
+        deck_sax_builder(std::function<void(deck *)> fnOnDeck);
+
+    public:
+        virtual void on_start_object() override;
+        virtual void on_end_object() override;
+        virtual void on_start_array() override;
+        virtual void on_end_array() override;
+        virtual void on_key(std::string_view sKey) override;
+        virtual void on_value(json_type nType, std::string_view sValue) override;
+
+    private:
+        /**
+         * @struct number_data
+         * @brief Data of a number being read.
+         */
+        struct number_data
+        {
+            std::string m_sName;        ///< The name of the number.
+            std::string m_sDisplayName; ///< The display name of the number.
+            bool m_bHasName;            ///< Whether the name was read.
+            bool m_bHasDisplayName;     ///< Whether the display name was read.
+        };
+
+        /**
+         * @struct suit_data
+         * @brief Data of a suit being read.
+         */
+        struct suit_data
+        {
+            number_data m_oData;                 ///< Name and display name of the suit.
+            std::vector<number_data> m_vNumbers; ///< Numbers of the suit.
+        };
+
+    private:
+        std::function<void(deck *)> m_fnOnDeck; ///< Callback receiving the decks.
+        std::size_t m_nDepth;                    ///< Current nesting depth.
+        std::size_t m_nRootDepth;                ///< Depth at which decks start.
+        bool m_bInDeck;                          ///< Whether a deck is being read.
+        bool m_bInSuits;                         ///< Whether the suits array is being read.
+        bool m_bInSuit;                          ///< Whether a suit is being read.
+        bool m_bInNumbers;                       ///< Whether the numbers array is being read.
+        bool m_bInNumber;                        ///< Whether a number is being read.
+        std::string m_sKey;                      ///< The last read key.
+        number_data m_oDeck;                     ///< Name and display name of the deck.
+        std::vector<suit_data> m_vSuits;         ///< Suits of the deck. Reused between decks.
+        std::size_t m_nSuits;                    ///< Number of used entries of m_vSuits.
+
+    private:
+        /**
+         * @brief Stores a name or display name read at the given level.
+         * @param oData The data to store into.
+         * @param sValue The read value.
+         */
+        void store(number_data &oData, std::string_view sValue);
+
+        /**
+         * @brief Builds the deck that was read and hands it over.
+         */
+        void finish_deck();
+    };
+
+    /**
+     * @class card_table_sax_builder
+     * @brief Handler loading card tables from json_sax_reader events.
+     *
+     * Accepts the schema written by card_table::to_json. The input may be a single
+     * table, an array of tables or a sequence of top-level tables. Every table is
+     * loaded into the same card_table in one update, resolving the cards against a
+     * deck, and then reported to a callback, so that recorded tables of any size are
+     * replayed in constant memory. Unknown keys are ignored.
+     */
+    class card_table_sax_builder : public json_sax_handler
+    {
+    public:
+        /**
+         * @brief Constructs a card table builder.
+         * @param pDeck The deck containing the cards of the tables.
+         * @param pTable The table into which every table is loaded.
+         * @param fnOnTable Callback called after every table is loaded.
+         */
+        card_table_sax_builder(const deck *pDeck, card_table *pTable, std::function<void(card_table *)> fnOnTable);
+
+    public:
+        virtual void on_start_object() override;
+        virtual void on_end_object() override;
+        virtual void on_start_array() override;
+        virtual void on_end_array() override;
+        virtual void on_key(std::string_view sKey) override;
+        virtual void on_value(json_type nType, std::string_view sValue) override;
+
+    private:
+        const deck *m_pDeck;                           ///< The deck containing the cards.
+        card_table *m_pTable;                          ///< The table to load into.
+        std::function<void(card_table *)> m_fnOnTable; ///< Callback called after every table.
+        std::size_t m_nDepth;                          ///< Current nesting depth.
+        std::size_t m_nRootDepth;                      ///< Depth at which tables start.
+        bool m_bInTable;                               ///< Whether a table is being read.
+        bool m_bInCards;                               ///< Whether the cards array is being read.
+        bool m_bInCard;                                ///< Whether a card is being read.
+        std::string m_sKey;                            ///< The last read key.
+        std::string m_sSuit;                           ///< Suit of the card being read.
+        std::string m_sNumber;                         ///< Number of the card being read.
+        std::size_t m_nX;                              ///< Horizontal position of the card being read.
+        std::size_t m_nY;                              ///< Vertical position of the card being read.
+        bool m_bVisible;                               ///< Visibility of the card being read.
+        std::list<card_holder> m_lHolders;             ///< Cards of the table being read.
+    };
+
+} // namespace ac
@@ -59,6 +59,9 @@ namespace ac
          */
         virtual ~nlohmann_json_item();
 
+        nlohmann_json_item(const nlohmann_json_item &) = delete;
+        nlohmann_json_item &operator=(const nlohmann_json_item &) = delete;
+
         /**
          * @brief Retrieves a JSON item associated with the specified key.
          *
@@ -93,9 +96,10 @@ namespace ac
         virtual std::vector<const json_item *> get_array(const std::string &sKey) const override;
 
     private:
-        const void *m_pJsonData;                                               ///< Pointer to the JSON data managed by this item.
-        mutable std::map<std::string, json_item *> m_mReadItems;               ///< Map of read JSON items by key.
-        mutable std::map<std::string, std::vector<json_item *>> m_mArrayItems; ///< Map of array items by key.
+        const void *m_pJsonData;                                                     ///< Pointer to the JSON data managed by this item.
+        bool m_bOwnsData;                                                            ///< Whether the JSON data is owned by this item (root items).
+        mutable std::map<std::string, json_item *> m_mReadItems;                     ///< Map of read JSON items by key.
+        mutable std::map<std::string, std::vector<const json_item *>> m_mArrayItems; ///< Map of array items by key.
 
         /**
          * @brief Private constructor for creating a nlohmann_json_item from raw JSON data.
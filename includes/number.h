@@ -103,6 +103,15 @@ namespace ac
          */
         void to_json(std::ostream &oOstream) const;
 
+        /**
+         * @brief Serializes the object to JSON format and appends it to a buffer.
+         *
+         * The buffer is not cleared, so it may be reused across calls to avoid reallocations.
+         *
+         * @param sBuffer The buffer to which the JSON representation will be appended.
+         */
+        void to_json(std::string &sBuffer) const;
+
         /**
          * @brief Serializes the object to JSON format and returns the output string.
          *
@@ -0,0 +1,191 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+/**
+ * @file rect.h
+ * @brief Declaration of the rect class used for representing a rectangle in a 2D space.
+ */
+
+#pragma once
+
+#include "point.h"
+
+namespace ac
+{
+
+    /**
+     * @class rect
+     * @brief Represents an axis aligned rectangle of table cells.
+     *
+     * The rectangle covers the cells from its origin (included) to its origin plus
+     * its size (excluded). Rectangles with no width or height are empty.
+     */
+    class rect
+    {
+    public:
+        /**
+         * @brief Constructs a rectangle.
+         * @param nX The x coordinate of the origin.
+         * @param nY The y coordinate of the origin.
+         * @param nWidth The width.
+         * @param nHeight The height.
+         */
+        constexpr rect(std::size_t nX, std::size_t nY, std::size_t nWidth, std::size_t nHeight)
+            : m_nX(nX), m_nY(nY), m_nWidth(nWidth), m_nHeight(nHeight) {}
+
+        /**
+         * @brief Constructs a rectangle.
+         * @param oOrigin The origin.
+         * @param nWidth The width.
+         * @param nHeight The height.
+         */
+        constexpr rect(const point &oOrigin, std::size_t nWidth, std::size_t nHeight)
+            : m_nX(oOrigin.get_x()), m_nY(oOrigin.get_y()), m_nWidth(nWidth), m_nHeight(nHeight) {}
+
+    public:
+        /**
+         * @brief Compares this rectangle with another rectangle for equality.
+         * @param oRect The rectangle to compare with.
+         * @return True if the rectangles are equal, false otherwise.
+         */
+        constexpr bool operator==(const rect &oRect) const = default;
+
+    public:
+        /**
+         * @brief Gets the x coordinate of the origin.
+         * @return The x coordinate as a size_t.
+         */
+        constexpr std::size_t get_x() const;
+
+        /**
+         * @brief Gets the y coordinate of the origin.
+         * @return The y coordinate as a size_t.
+         */
+        constexpr std::size_t get_y() const;
+
+        /**
+         * @brief Gets the width.
+         * @return The width as a size_t.
+         */
+        constexpr std::size_t get_width() const;
+
+        /**
+         * @brief Gets the height.
+         * @return The height as a size_t.
+         */
+        constexpr std::size_t get_height() const;
+
+        /**
+         * @brief Checks if the rectangle covers no cell.
+         * @return True if the width or the height is 0, false otherwise.
+         */
+        constexpr bool is_empty() const;
+
+    public:
+        /**
+         * @brief Checks if a cell is inside the rectangle.
+         * @param oPoint The cell.
+         * @return True if the cell is inside, false otherwise.
+         */
+        constexpr bool contains(const point &oPoint) const;
+
+        /**
+         * @brief Checks if two rectangles share a cell.
+         * @param oRect The rectangle to check.
+         * @return True if the rectangles overlap, false otherwise.
+         */
+        constexpr bool intersects(const rect &oRect) const;
+
+        /**
+         * @brief Checks if a rectangle is inside this one.
+         * @param oRect The rectangle to check. Empty rectangles are never inside.
+         * @return True if every cell of oRect is inside this rectangle, false otherwise.
+         */
+        constexpr bool contains(const rect &oRect) const;
+
+    private:
+        std::size_t m_nX;      ///< The x coordinate of the origin.
+        std::size_t m_nY;      ///< The y coordinate of the origin.
+        std::size_t m_nWidth;  ///< The width.
+        std::size_t m_nHeight; ///< The height.
+
+    private:
+        /**
+         * @brief Checks if two ranges share a value, without overflowing.
+         * @param nStart1 Start of the first range.
+         * @param nSize1 Size of the first range.
+         * @param nStart2 Start of the second range.
+         * @param nSize2 Size of the second range.
+         * @return True if the ranges overlap, false otherwise.
+         */
+        static constexpr bool overlaps(std::size_t nStart1, std::size_t nSize1, std::size_t nStart2, std::size_t nSize2);
+    };
+
+    constexpr std::size_t rect::get_x() const
+    {
+        return this->m_nX;
+    }
+
+    constexpr std::size_t rect::get_y() const
+    {
+        return this->m_nY;
+    }
+
+    constexpr std::size_t rect::get_width() const
+    {
+        return this->m_nWidth;
+    }
+
+    constexpr std::size_t rect::get_height() const
+    {
+        return this->m_nHeight;
+    }
+
+    constexpr bool rect::is_empty() const
+    {
+        return this->m_nWidth == 0 || this->m_nHeight == 0;
+    }
+
+    constexpr bool rect::contains(const point &oPoint) const
+    {
+        return oPoint.get_x() >= this->m_nX && oPoint.get_x() - this->m_nX < this->m_nWidth &&
+               oPoint.get_y() >= this->m_nY && oPoint.get_y() - this->m_nY < this->m_nHeight;
+    }
+
+    constexpr bool rect::intersects(const rect &oRect) const
+    {
+        return overlaps(this->m_nX, this->m_nWidth, oRect.m_nX, oRect.m_nWidth) &&
+               overlaps(this->m_nY, this->m_nHeight, oRect.m_nY, oRect.m_nHeight);
+    }
+
+    constexpr bool rect::contains(const rect &oRect) const
+    {
+        return !oRect.is_empty() &&
+               oRect.m_nX >= this->m_nX && oRect.m_nX - this->m_nX <= this->m_nWidth && oRect.m_nWidth <= this->m_nWidth - (oRect.m_nX - this->m_nX) &&
+               oRect.m_nY >= this->m_nY && oRect.m_nY - this->m_nY <= this->m_nHeight && oRect.m_nHeight <= this->m_nHeight - (oRect.m_nY - this->m_nY);
+    }
+
+    constexpr bool rect::overlaps(std::size_t nStart1, std::size_t nSize1, std::size_t nStart2, std::size_t nSize2)
+    {
+        if (nSize1 == 0 || nSize2 == 0)
+            return false;
+        return nStart1 <= nStart2 ? nStart2 - nStart1 < nSize1 : nStart1 - nStart2 < nSize2;
+    }
+
+} // namespace ac
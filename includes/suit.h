@@ -42,7 +42,8 @@ namespace ac
      */
     class suit
     {
-        friend class deck; ///< Allows the deck class to access private members of suit.
+        friend class deck;         ///< Allows the deck class to access private members of suit.
+        friend class deck_builder; ///< Allows the deck builder to fill suits in one shot.
 
     public:
         /**
@@ -141,6 +142,15 @@ namespace ac
          */
         void to_json(std::ostream &oOstream) const;
 
+        /**
+         * @brief Serializes the object to JSON format and appends it to a buffer.
+         *
+         * The buffer is not cleared, so it may be reused across calls to avoid reallocations.
+         *
+         * @param sBuffer The buffer to which the JSON representation will be appended.
+         */
+        void to_json(std::string &sBuffer) const;
+
         /**
          * @brief Serializes the object to JSON format and returns the output string.
          *
@@ -177,6 +187,17 @@ namespace ac
          * @return A pointer to a new suit object that is a copy of this one.
          */
         suit *clone() const;
+
+        /**
+         * @brief Creates a number without locking the suit.
+         *
+         * Used for bulk construction of suits that are not yet shared.
+         * If a number with the same name exists, it is replaced.
+         * @param sName The name of the number to create.
+         * @param sDisplayName The display name of the number to create.
+         * @return A pointer to the newly created number.
+         */
+        number *emplace_number_unlocked(const std::string &sName, const std::string &sDisplayName);
     };
 
 } // namespace ac
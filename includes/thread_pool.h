@@ -0,0 +1,113 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+
+/**
+ * @file thread_pool.h
+ * @brief Declaration of the thread_pool class.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ac
+{
+
+    /**
+     * @class thread_pool
+     * @brief Worker threads running the tasks of one job at a time, with the calling thread.
+     *
+     * Used to split work such as the composition of large tables in tiles. A job started
+     * while the pool runs another one is run on the calling thread instead of waiting.
+     */
+    class thread_pool
+    {
+    public:
+        /**
+         * @brief Starts the worker threads.
+         * @param nWorkers The number of worker threads, besides the threads calling run.
+         */
+        explicit thread_pool(std::size_t nWorkers);
+
+        /**
+         * @brief Stops the worker threads.
+         */
+        ~thread_pool();
+
+        thread_pool(const thread_pool &) = delete;
+        thread_pool &operator=(const thread_pool &) = delete;
+
+    public:
+        /**
+         * @brief Gets the pool shared by the library, with a worker per core but one.
+         * @return The shared pool.
+         */
+        static thread_pool &get_shared();
+
+        /**
+         * @brief Gets the number of threads running a job.
+         * @return The number of workers plus the calling thread.
+         */
+        std::size_t get_thread_count() const;
+
+        /**
+         * @brief Runs tasks on the workers and the calling thread, and waits for all of them.
+         * @param nTasks The number of tasks.
+         * @param fnTask The task, called with every index from 0 to nTasks - 1, in any order and thread.
+         * @throws Rethrows the first exception thrown by a task, once every task ended.
+         */
+        void run(std::size_t nTasks, const std::function<void(std::size_t)> &fnTask);
+
+    private:
+        std::vector<std::thread> m_vWorkers;             ///< The worker threads.
+        std::mutex m_oRunMutex;                          ///< Held by the thread running a job.
+        std::mutex m_oMutex;                             ///< Mutex of the job.
+        std::condition_variable m_oStarted;              ///< Notified when a job starts or the pool stops.
+        std::condition_variable m_oEnded;                ///< Notified when workers leave a job.
+        const std::function<void(std::size_t)> *m_pTask; ///< The task of the job.
+        std::size_t m_nTasks;                            ///< The number of tasks of the job.
+        std::atomic<std::size_t> m_nNext;                ///< Index of the next task to run.
+        std::size_t m_nCompleted;                        ///< Number of tasks that ended.
+        std::size_t m_nJob;                              ///< Number of jobs started.
+        bool m_bOpen;                                    ///< Whether workers may join the job.
+        std::size_t m_nActive;                           ///< Number of workers in the job.
+        std::exception_ptr m_pException;                 ///< First exception thrown by a task.
+        bool m_bStop;                                    ///< Whether the workers must end.
+
+    private:
+        /**
+         * @brief Runs the tasks of the job until there are none left.
+         */
+        void run_tasks();
+
+        /**
+         * @brief Joins the jobs until the pool stops.
+         */
+        void work();
+    };
+
+} // namespace ac
@@ -0,0 +1,89 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+
+/**
+ * @file unicode.h
+ * @brief Provides tools for measuring UTF-8 text on terminals.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace ac
+{
+
+    namespace unicode
+    {
+
+        /**
+         * @brief Decodes the first code point of a UTF-8 string.
+         * @param sText The text. Must not be empty.
+         * @param nSize Receives the number of bytes of the code point.
+         * @return The code point.
+         * @throws std::invalid_argument If the text does not start with a valid UTF-8 sequence.
+         */
+        char32_t decode_utf8(std::string_view sText, std::size_t &nSize);
+
+        /**
+         * @brief Encodes a code point as UTF-8.
+         * @param nCodepoint The code point, at most U+10FFFF.
+         * @param pOut Receives the bytes, up to 4.
+         * @return The number of bytes written.
+         */
+        std::size_t encode_utf8(char32_t nCodepoint, char *pOut);
+
+        /**
+         * @brief Gets the number of terminal cells taken by a code point.
+         *
+         * Combining marks and format characters take no cell, East Asian wide and fullwidth
+         * characters (including emoji presented as pictures) take two, anything else one.
+         * Ranges are looked up with a binary search in tables checked at compile time.
+         * @param nCodepoint The code point.
+         * @return 0, 1 or 2.
+         */
+        std::size_t codepoint_width(char32_t nCodepoint);
+
+        /**
+         * @brief Gets the number of terminal cells taken by a UTF-8 string.
+         *
+         * A variation selector 16 (U+FE0F) asks for the emoji presentation of the previous
+         * code point, which then takes two cells.
+         * @param sText The text.
+         * @return The display width.
+         * @throws std::invalid_argument If the text is not valid UTF-8.
+         */
+        std::size_t display_width(std::string_view sText);
+
+        /**
+         * @brief Gets the first glyph of a UTF-8 string.
+         *
+         * The glyph is the first code point followed by the code points taking no cell
+         * (combining marks, variation selectors...).
+         * @param sText The text.
+         * @return A view of the glyph in sText, empty if sText is empty.
+         * @throws std::invalid_argument If the text does not start with valid UTF-8.
+         */
+        std::string_view first_glyph(std::string_view sText);
+
+    } // namespace unicode
+
+} // namespace ac
@@ -18,11 +18,39 @@
  */
 
 #include "ansi.h"
+#include "json.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
 #endif
 
 namespace ac
@@ -33,6 +61,262 @@ namespace ac
 
 #ifdef _WIN32
         static int ansi_to_windows_color(ansi_color nColor);
+#else
+        static void on_terminal_resize(int nSignal);
+        static bool query_private_mode(int nMode);
+        static void append_csi(std::string &sSequence, std::size_t nParameter, char cFinal);
+        static std::size_t get_cursor_columns();
+        template <std::size_t N>
+        static bool is_terminal_in(const std::array<std::string_view, N> &aPrefixes);
+#endif
+
+#ifndef _WIN32
+        static inline std::size_t basic_color_index(ansi_color nColor);
+        static const ansi_sgr &basic_sgr(ansi_color nColor, bool bBackground);
+#endif
+
+        /// Maximum time to wait for the answer of the terminal to a query, in milliseconds.
+        static constexpr int QUERY_TIMEOUT = 200;
+
+        /// Whether the alternate screen is in use.
+        static std::atomic<bool> s_bAlternateScreen(false);
+
+        /// Number of resize signals received. Lock free, so that it can be updated from the signal handler.
+        static std::atomic<std::size_t> s_nResizeCount(0);
+
+#ifndef _WIN32
+        /// The SIGWINCH action installed before watch_terminal_resize.
+        static struct sigaction s_oPreviousResizeAction;
+
+        /// Prefixes of the TERM of the terminals repeating characters (REP).
+        static constexpr std::array<std::string_view, 9> REPEAT_TERMINALS = {"xterm", "alacritty", "foot", "wezterm", "tmux", "vte", "konsole", "contour", "ghostty"};
+
+        /// Prefixes of the TERM of the terminals erasing characters (ECH) with the background color.
+        static constexpr std::array<std::string_view, 12> ERASE_TERMINALS = {"xterm", "alacritty", "foot", "wezterm", "tmux", "vte", "konsole", "contour", "ghostty", "linux", "rxvt", "putty"};
+
+        /// Maximum number of line feeds written to move the cursor down to the first column.
+        static constexpr std::size_t MAX_LINE_FEEDS = 4;
+
+        /**
+         * @struct cursor_state
+         * @brief The position of the cursor, tracked to choose the shortest motions.
+         */
+        struct cursor_state
+        {
+            std::size_t m_nX;           ///< Column of the cursor.
+            std::size_t m_nY;           ///< Row of the cursor.
+            bool m_bKnown;              ///< Whether the position is known.
+            std::size_t m_nColumns;     ///< Width of the terminal, SIZE_MAX when unknown.
+            std::size_t m_nResizeCount; ///< Resize count when the width was queried.
+            bool m_bQueried;            ///< Whether the width was queried.
+        };
+
+        /// The tracked cursor.
+        static cursor_state s_oCursor{0, 0, false, SIZE_MAX, 0, false};
+
+        /// Mutex of the tracked cursor.
+        static std::mutex s_oCursorMutex;
+
+        /**
+         * @struct output_target
+         * @brief A descriptor the output is written to, with the frames waiting for it.
+         *
+         * Frames are encoded once and shared by every target waiting for them.
+         */
+        struct output_target
+        {
+            int m_nFd;                                                ///< The descriptor written to.
+            bool m_bSpectator;                                        ///< Whether it is a spectator socket, closed when it fails.
+            bool m_bFailed;                                           ///< Whether writing failed, so that nothing is queued anymore.
+            bool m_bDropping;                                         ///< Whether frames are dropped until a complete one.
+            std::deque<std::shared_ptr<const std::string>> m_vFrames; ///< Output waiting for the writer thread.
+            std::size_t m_nQueued;                                    ///< Number of bytes in m_vFrames.
+            std::shared_ptr<const std::string> m_pWriting;            ///< Output being written, never dropped.
+            std::size_t m_nWritten;                                   ///< Number of bytes of m_pWriting written.
+        };
+
+        /**
+         * @struct recorded_output
+         * @brief Output waiting to be written to the recording.
+         */
+        struct recorded_output
+        {
+            std::chrono::steady_clock::time_point m_oTime; ///< When the output was committed.
+            bool m_bKeyframe;                              ///< Whether it is a complete frame.
+            std::shared_ptr<const std::string> m_pData;    ///< The output, shared with the targets.
+        };
+
+        /**
+         * @struct output_recording
+         * @brief An asciicast file the output is appended to.
+         */
+        struct output_recording
+        {
+            std::vector<char> m_vBuffer;                             ///< Buffer of the file, set before opening it.
+            std::ofstream m_oFile;                                   ///< The file.
+            std::chrono::steady_clock::time_point m_oStart;          ///< Start of the recording, time 0.
+            std::chrono::steady_clock::duration m_oKeyframeInterval; ///< Time between keyframes.
+            std::chrono::steady_clock::time_point m_oKeyframe;       ///< Time of the last keyframe, or of the last request of one.
+            bool m_bStarted;                                         ///< Whether a keyframe was recorded, so that the output is meaningful.
+            std::vector<recorded_output> m_vPending;                 ///< Output waiting for the writer thread.
+            std::string m_sLine;                                     ///< Buffer of the events.
+        };
+
+        /**
+         * @class output_sink
+         * @brief Stream buffer queueing the output in memory for a thread writing it to the terminal and spectators.
+         */
+        class output_sink : public std::streambuf
+        {
+        public:
+            /**
+             * @brief Starts the writer thread.
+             * @param nFd The descriptor of the terminal.
+             * @param bOwned Whether the descriptor is closed with the sink.
+             * @param nCapacity Number of bytes that may wait for a target before its frames are dropped.
+             */
+            output_sink(int nFd, bool bOwned, std::size_t nCapacity);
+
+            /**
+             * @brief Writes all the output to the terminal, waiting for it, and stops the writer thread.
+             *
+             * Spectators are not waited for.
+             */
+            ~output_sink() override;
+
+        public:
+            /**
+             * @brief Starts a frame, see ansi::begin_output_frame.
+             */
+            void begin_frame();
+
+            /**
+             * @brief Ends a frame, see ansi::end_output_frame.
+             * @param bComplete True if the frame redraws the whole screen.
+             */
+            void end_frame(bool bComplete);
+
+            /**
+             * @brief Checks if frames were dropped or a spectator is waiting for a complete frame.
+             * @return True if frames were dropped since the last call.
+             */
+            bool take_dropped();
+
+            /**
+             * @brief Accepts spectators on a listening socket, replacing the previous one.
+             * @param nListener The listening socket, closed with the sink.
+             */
+            void listen(int nListener);
+
+            /**
+             * @brief Closes the listening socket and disconnects every spectator.
+             */
+            void stop_listening();
+
+            /**
+             * @brief Gets the number of spectators connected.
+             * @return The number of spectators.
+             */
+            std::size_t get_spectator_count();
+
+            /**
+             * @brief Starts appending the output to a recording, replacing the previous one.
+             * @param pRecording The recording, with its header written.
+             */
+            void record(std::shared_ptr<output_recording> pRecording);
+
+            /**
+             * @brief Writes the output waiting for the recording and closes it.
+             */
+            void stop_recording();
+
+        protected:
+            int_type overflow(int_type nChar) override;
+            std::streamsize xsputn(const char *pData, std::streamsize nSize) override;
+            int sync() override;
+
+        private:
+            bool m_bOwned;                                          ///< Whether the descriptor of the terminal is closed with the sink.
+            std::size_t m_nCapacity;                                ///< Number of bytes that may wait before frames are dropped.
+            std::string m_sFrame;                                   ///< Output written and not queued yet.
+            std::size_t m_nFrameDepth;                              ///< Number of open frames.
+            bool m_bDropped;                                        ///< Whether frames were dropped since take_dropped.
+            bool m_bStop;                                           ///< Whether the writer thread must end once the terminal is written.
+            std::shared_ptr<output_target> m_pTerminal;             ///< The terminal, the first target.
+            std::vector<std::shared_ptr<output_target>> m_vTargets; ///< The terminal and the spectators.
+            int m_nListener;                                        ///< Socket accepting spectators, -1 when not broadcasting.
+            std::vector<int> m_vClosing;                            ///< Descriptors the writer thread must close.
+            int m_aWake[2];                                         ///< Pipe waking the writer thread.
+            std::shared_ptr<output_recording> m_pRecording;         ///< The recording, nullptr when not recording.
+            std::mutex m_oMutex;                                    ///< Mutex of the buffers, targets and flags.
+            std::mutex m_oRecordingMutex;                           ///< Mutex of the recording file, locked before m_oMutex.
+            std::thread m_oWriter;                                  ///< The writer thread.
+
+        private:
+            /**
+             * @brief Queues the output written outside of frames, which is never dropped.
+             */
+            void queue_unlocked();
+
+            /**
+             * @brief Queues a frame for a target.
+             * @param oTarget The target.
+             * @param pFrame The frame.
+             */
+            static void push_unlocked(output_target &oTarget, const std::shared_ptr<const std::string> &pFrame);
+
+            /**
+             * @brief Queues output for the recording, asking for a keyframe when the last one is too old.
+             * @param pFrame The output.
+             * @param bKeyframe Whether it is a complete frame.
+             */
+            void record_unlocked(const std::shared_ptr<const std::string> &pFrame, bool bKeyframe);
+
+            /**
+             * @brief Appends the output waiting for the recording to its file.
+             * @param bClose Whether the recording is closed afterwards.
+             */
+            void write_recording(bool bClose);
+
+            /**
+             * @brief Wakes the writer thread.
+             */
+            void wake();
+
+            /**
+             * @brief Accepts the spectators waiting on the listening socket.
+             * @param nListener The listening socket.
+             */
+            void accept_spectators(int nListener);
+
+            /**
+             * @brief Writes the output waiting for a target until it can not take more.
+             * @param oTarget The target.
+             * @param nEvents The events polled on its descriptor.
+             * @return False if the target failed.
+             */
+            bool write_target(output_target &oTarget, short nEvents);
+
+            /**
+             * @brief Writes the targets and accepts spectators until the sink stops.
+             */
+            void write_targets();
+        };
+
+        /// The sink of the standard output, nullptr when writing directly.
+        static output_sink *s_pSink = nullptr;
+
+        /// The buffer of the standard output before enable_nonblocking_output.
+        static std::streambuf *s_pDirectBuffer = nullptr;
+
+        /// Mutex of the sink.
+        static std::mutex s_oSinkMutex;
+
+        /// Size of the buffer of the recordings.
+        static constexpr std::size_t RECORDING_BUFFER_SIZE = 256 * 1024;
+
+        /// Path of the socket spectators connect to, empty when not broadcasting.
+        static std::string s_sBroadcastPath;
 #endif
 
         void set_ansi_foreground_color(ansi_color nColor)
@@ -46,9 +330,7 @@ namespace ac
             int wColor = ansi_to_windows_color(nColor);
             SetConsoleTextAttribute(hConsole, (csbi.wAttributes & 0xF0) | wColor);
 #else
-            std::ostringstream oOstream;
-            oOstream << "\033[" << static_cast<int>(nColor) << "m";
-            std::cout << oOstream.str();
+            set_ansi_color(basic_sgr(nColor, false));
 #endif
         }
 
@@ -63,10 +345,7 @@ namespace ac
             int wColor = ansi_to_windows_color(nColor);
             SetConsoleTextAttribute(hConsole, (csbi.wAttributes & 0x0F) | (wColor << 4));
 #else
-            // Background colors are 10 more than foreground
-            std::ostringstream oOstream;
-            oOstream << "\033[" << (static_cast<int>(nColor) + 10) << "m";
-            std::cout << oOstream.str();
+            set_ansi_color(basic_sgr(nColor, true));
 #endif
         }
 
@@ -82,6 +361,19 @@ namespace ac
 #endif
         }
 
+        void set_ansi_color(const ansi_sgr &oSgr)
+        {
+#ifdef _WIN32
+            if (oSgr.is_background())
+                set_ansi_background_color(oSgr.get_color().get_closest_basic());
+            else
+                set_ansi_foreground_color(oSgr.get_color().get_closest_basic());
+#else
+            std::string_view sSequence = oSgr.get_sequence();
+            std::cout.write(sSequence.data(), static_cast<std::streamsize>(sSequence.size()));
+#endif
+        }
+
         void move_ansi_cursor(std::size_t x, std::size_t y)
         {
 #ifdef _WIN32
@@ -90,10 +382,82 @@ namespace ac
             coord.Y = static_cast<SHORT>(y);
             SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), coord);
 #else
-            // Move cursor to (x, y)
-            std::ostringstream oOstream;
-            oOstream << "\033[" << (y + 1) << ";" << (x + 1) << "H";
-            std::cout << oOstream.str();
+            std::lock_guard<std::mutex> oLock(s_oCursorMutex);
+
+            // Absolute position, the row or the column omitted when they are the first
+            std::string sBest = "\033[";
+            if (y > 0)
+                sBest += std::to_string(y + 1);
+            if (x > 0)
+            {
+                sBest += ';';
+                sBest += std::to_string(x + 1);
+            }
+            sBest += "H";
+
+            if (s_oCursor.m_bKnown)
+            {
+                // Relative row
+                std::string sRow;
+                if (y < s_oCursor.m_nY)
+                    append_csi(sRow, s_oCursor.m_nY - y, 'A');
+                else if (y > s_oCursor.m_nY)
+                    append_csi(sRow, y - s_oCursor.m_nY, 'B');
+
+                // Shortest column motion. Past the right edge the terminal may be waiting to
+                // wrap, and relative columns would be off by one
+                std::string sColumn;
+                append_csi(sColumn, x + 1, 'G');
+                bool bRelative = s_oCursor.m_nX < get_cursor_columns();
+                if (x == s_oCursor.m_nX && bRelative)
+                    sColumn.clear();
+                else if (x == 0)
+                    sColumn.assign(1, '\r');
+                else if (bRelative && x + 1 == s_oCursor.m_nX)
+                    sColumn.assign(1, '\b');
+                else if (bRelative)
+                {
+                    std::string sRelative;
+                    if (x > s_oCursor.m_nX)
+                        append_csi(sRelative, x - s_oCursor.m_nX, 'C');
+                    else
+                        append_csi(sRelative, s_oCursor.m_nX - x, 'D');
+                    if (sRelative.size() < sColumn.size())
+                        sColumn = sRelative;
+                }
+                if (sRow.size() + sColumn.size() < sBest.size())
+                    sBest = sRow.append(sColumn);
+
+                // Carriage return and line feeds, to the first column of a row below
+                if (x == 0 && y > s_oCursor.m_nY && y - s_oCursor.m_nY <= MAX_LINE_FEEDS && y - s_oCursor.m_nY + 1 < sBest.size())
+                {
+                    sBest.assign(1, '\r');
+                    sBest.append(y - s_oCursor.m_nY, '\n');
+                }
+            }
+
+            std::cout.write(sBest.data(), static_cast<std::streamsize>(sBest.size()));
+            s_oCursor.m_nX = x;
+            s_oCursor.m_nY = y;
+            s_oCursor.m_bKnown = true;
+#endif
+        }
+
+        void advance_ansi_cursor(std::size_t nColumns)
+        {
+#ifndef _WIN32
+            std::lock_guard<std::mutex> oLock(s_oCursorMutex);
+            s_oCursor.m_nX += nColumns;
+            if (s_oCursor.m_nX > get_cursor_columns())
+                s_oCursor.m_bKnown = false;
+#endif
+        }
+
+        void forget_ansi_cursor()
+        {
+#ifndef _WIN32
+            std::lock_guard<std::mutex> oLock(s_oCursorMutex);
+            s_oCursor.m_bKnown = false;
 #endif
         }
 
@@ -103,6 +467,54 @@ namespace ac
             std::ostringstream oOstream;
             oOstream << "\033[8;" << h << ";" << w << "t";
             std::cout << oOstream.str();
+            forget_ansi_cursor();
+        }
+
+        bool supports_repeat_characters()
+        {
+#ifdef _WIN32
+            return false;
+#else
+            static const bool s_bSupported = is_terminal_in(REPEAT_TERMINALS);
+            return s_bSupported;
+#endif
+        }
+
+        bool supports_erase_characters()
+        {
+#ifdef _WIN32
+            return false;
+#else
+            static const bool s_bSupported = is_terminal_in(ERASE_TERMINALS);
+            return s_bSupported;
+#endif
+        }
+
+        void write_ansi_repeated(std::string_view sGlyph, std::size_t nCount)
+        {
+            // The shortest of the literal glyphs, the glyph and a repeat, or erasing and skipping blanks
+            std::string sBest;
+#ifndef _WIN32
+            if (nCount > 1 && supports_repeat_characters())
+            {
+                sBest = sGlyph;
+                append_csi(sBest, nCount - 1, 'b');
+            }
+            if (nCount > 1 && sGlyph == " " && supports_erase_characters())
+            {
+                std::string sErase;
+                append_csi(sErase, nCount, 'X');
+                append_csi(sErase, nCount, 'C');
+                if (sBest.empty() || sErase.size() < sBest.size())
+                    sBest = sErase;
+            }
+#endif
+            if (!sBest.empty() && sBest.size() < sGlyph.size() * nCount)
+                std::cout.write(sBest.data(), static_cast<std::streamsize>(sBest.size()));
+            else
+                for (std::size_t nGlyph = 0; nGlyph < nCount; ++nGlyph)
+                    std::cout.write(sGlyph.data(), static_cast<std::streamsize>(sGlyph.size()));
+            advance_ansi_cursor(nCount);
         }
 
         void clear_screen()
@@ -110,10 +522,859 @@ namespace ac
 #ifdef _WIN32
             system("CLS");
 #else
-            system("clear");
+            // Queued output must not be written after the screen is cleared
+            if (is_nonblocking_output())
+                std::cout << "\033[H\033[2J\033[3J";
+            else
+                system("clear");
+#endif
+            forget_ansi_cursor();
+        }
+
+        bool get_terminal_size(std::size_t &nWidth, std::size_t &nHeight)
+        {
+#ifdef _WIN32
+            CONSOLE_SCREEN_BUFFER_INFO csbi;
+            if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi))
+                return false;
+            nWidth = static_cast<std::size_t>(csbi.srWindow.Right - csbi.srWindow.Left + 1);
+            nHeight = static_cast<std::size_t>(csbi.srWindow.Bottom - csbi.srWindow.Top + 1);
+            return true;
+#else
+            winsize oSize{};
+            if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &oSize) != 0 || oSize.ws_col == 0 || oSize.ws_row == 0)
+                return false;
+            nWidth = oSize.ws_col;
+            nHeight = oSize.ws_row;
+            return true;
+#endif
+        }
+
+        void watch_terminal_resize()
+        {
+#ifndef _WIN32
+            static std::once_flag s_oWatching;
+            auto install = []()
+            {
+                struct sigaction oAction{};
+                oAction.sa_handler = on_terminal_resize;
+                sigemptyset(&oAction.sa_mask);
+                oAction.sa_flags = SA_RESTART;
+                sigaction(SIGWINCH, &oAction, &s_oPreviousResizeAction);
+            };
+            std::call_once(s_oWatching, install);
+#endif
+        }
+
+        std::size_t get_terminal_resize_count()
+        {
+            return s_nResizeCount.load(std::memory_order_relaxed);
+        }
+
+        bool supports_synchronized_output()
+        {
+#ifdef _WIN32
+            return false;
+#else
+            static const bool s_bSupported = query_private_mode(2026);
+            return s_bSupported;
+#endif
+        }
+
+        void begin_synchronized_update()
+        {
+#ifndef _WIN32
+            std::cout << "\033[?2026h";
+#endif
+        }
+
+        void end_synchronized_update()
+        {
+#ifndef _WIN32
+            std::cout << "\033[?2026l";
+#endif
+        }
+
+        void enter_alternate_screen()
+        {
+            if (s_bAlternateScreen.exchange(true))
+                return;
+
+            // Never leave the terminal on the alternate screen
+            static std::once_flag s_oRestoring;
+            auto restore = []()
+            {
+                std::atexit(leave_alternate_screen);
+            };
+            std::call_once(s_oRestoring, restore);
+            std::cout << "\033[?1049h";
+            std::cout.flush();
+            forget_ansi_cursor();
+        }
+
+        void leave_alternate_screen()
+        {
+            if (!s_bAlternateScreen.exchange(false))
+                return;
+
+            std::cout << "\033[?25h\033[?1049l";
+            std::cout.flush();
+            forget_ansi_cursor();
+        }
+
+        void hide_cursor()
+        {
+#ifdef _WIN32
+            HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+            CONSOLE_CURSOR_INFO cci;
+            GetConsoleCursorInfo(hConsole, &cci);
+            cci.bVisible = FALSE;
+            SetConsoleCursorInfo(hConsole, &cci);
+#else
+            std::cout << "\033[?25l";
+#endif
+        }
+
+        void show_cursor()
+        {
+#ifdef _WIN32
+            HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+            CONSOLE_CURSOR_INFO cci;
+            GetConsoleCursorInfo(hConsole, &cci);
+            cci.bVisible = TRUE;
+            SetConsoleCursorInfo(hConsole, &cci);
+#else
+            std::cout << "\033[?25h";
+#endif
+        }
+
+        bool enable_nonblocking_output(std::size_t nCapacity)
+        {
+#ifdef _WIN32
+            (void)nCapacity;
+            return false;
+#else
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            if (s_pSink != nullptr)
+                return true;
+
+            // A descriptor of its own, so that the standard input stays blocking
+            int nFd = -1;
+            char aName[256];
+            if (isatty(STDOUT_FILENO) && ttyname_r(STDOUT_FILENO, aName, sizeof(aName)) == 0)
+                nFd = open(aName, O_WRONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+            bool bOwned = nFd >= 0;
+            if (!bOwned)
+                nFd = STDOUT_FILENO;
+
+            // Never leave output in the queue
+            static std::once_flag s_oDraining;
+            auto drain = []()
+            {
+                std::atexit(disable_nonblocking_output);
+            };
+            std::call_once(s_oDraining, drain);
+
+            std::cout.flush();
+            s_pSink = new output_sink(nFd, bOwned, nCapacity);
+            s_pDirectBuffer = std::cout.rdbuf(s_pSink);
+            return true;
+#endif
+        }
+
+        void disable_nonblocking_output()
+        {
+#ifndef _WIN32
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            if (s_pSink == nullptr)
+                return;
+
+            std::cout.flush();
+            std::cout.rdbuf(s_pDirectBuffer);
+            delete s_pSink;
+            s_pSink = nullptr;
+            if (!s_sBroadcastPath.empty())
+                unlink(s_sBroadcastPath.c_str());
+            s_sBroadcastPath.clear();
+#endif
+        }
+
+        bool is_nonblocking_output()
+        {
+#ifdef _WIN32
+            return false;
+#else
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            return s_pSink != nullptr;
+#endif
+        }
+
+        void begin_output_frame()
+        {
+#ifndef _WIN32
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            if (s_pSink != nullptr)
+                s_pSink->begin_frame();
+#endif
+        }
+
+        void end_output_frame(bool bComplete)
+        {
+#ifdef _WIN32
+            (void)bComplete;
+#else
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            if (s_pSink != nullptr)
+                s_pSink->end_frame(bComplete);
+#endif
+        }
+
+        bool take_dropped_output()
+        {
+#ifdef _WIN32
+            return false;
+#else
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            return s_pSink != nullptr && s_pSink->take_dropped();
+#endif
+        }
+
+        bool broadcast_output(const std::string &sPath)
+        {
+#ifdef _WIN32
+            (void)sPath;
+            return false;
+#else
+            sockaddr_un oAddress{};
+            oAddress.sun_family = AF_UNIX;
+            if (sPath.empty() || sPath.size() >= sizeof(oAddress.sun_path))
+                throw std::invalid_argument("Invalid socket path \'" + sPath + "\'.");
+            std::memcpy(oAddress.sun_path, sPath.data(), sPath.size());
+
+            // Replace the socket left by a previous run, but no other file
+            struct stat oStat;
+            if (lstat(sPath.c_str(), &oStat) == 0 && S_ISSOCK(oStat.st_mode))
+                unlink(sPath.c_str());
+            int nListener = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (nListener < 0)
+                throw std::runtime_error("Unable to listen on \'" + sPath + "\'.");
+            if (bind(nListener, reinterpret_cast<const sockaddr *>(&oAddress), sizeof(oAddress)) != 0 || listen(nListener, SOMAXCONN) != 0)
+            {
+                close(nListener);
+                throw std::runtime_error("Unable to listen on \'" + sPath + "\'.");
+            }
+            fcntl(nListener, F_SETFL, fcntl(nListener, F_GETFL) | O_NONBLOCK);
+            fcntl(nListener, F_SETFD, FD_CLOEXEC);
+
+            // Spectators are more targets of the writer thread
+            enable_nonblocking_output();
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            if (s_pSink == nullptr)
+            {
+                close(nListener);
+                unlink(sPath.c_str());
+                return false;
+            }
+            if (!s_sBroadcastPath.empty() && s_sBroadcastPath != sPath)
+                unlink(s_sBroadcastPath.c_str());
+            s_sBroadcastPath = sPath;
+            s_pSink->listen(nListener);
+            return true;
+#endif
+        }
+
+        void stop_broadcast()
+        {
+#ifndef _WIN32
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            if (s_pSink != nullptr)
+                s_pSink->stop_listening();
+            if (!s_sBroadcastPath.empty())
+                unlink(s_sBroadcastPath.c_str());
+            s_sBroadcastPath.clear();
+#endif
+        }
+
+        std::size_t get_spectator_count()
+        {
+#ifdef _WIN32
+            return 0;
+#else
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            return s_pSink != nullptr ? s_pSink->get_spectator_count() : 0;
 #endif
         }
 
+        bool record_output(const std::string &sPath, std::size_t nWidth, std::size_t nHeight, double dKeyframeInterval)
+        {
+#ifdef _WIN32
+            (void)sPath;
+            (void)nWidth;
+            (void)nHeight;
+            (void)dKeyframeInterval;
+            return false;
+#else
+            if (!(dKeyframeInterval > 0))
+                throw std::invalid_argument("The keyframe interval must be positive.");
+
+            // Appended to with a large buffer, from the writer thread
+            auto pRecording = std::make_shared<output_recording>();
+            pRecording->m_vBuffer.resize(RECORDING_BUFFER_SIZE);
+            pRecording->m_oFile.rdbuf()->pubsetbuf(pRecording->m_vBuffer.data(), static_cast<std::streamsize>(pRecording->m_vBuffer.size()));
+            pRecording->m_oFile.open(sPath, std::ios::binary | std::ios::trunc);
+            if (!pRecording->m_oFile)
+                throw std::runtime_error("Unable to write recording \'" + sPath + "\'.");
+            pRecording->m_oStart = std::chrono::steady_clock::now();
+            pRecording->m_oKeyframeInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(dKeyframeInterval));
+            pRecording->m_oKeyframe = pRecording->m_oStart;
+            pRecording->m_bStarted = false;
+
+            // Asciicast v2 header
+            auto nTimestamp = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            pRecording->m_oFile << "{\"version\": 2, \"width\": " << nWidth << ", \"height\": " << nHeight << ", \"timestamp\": " << nTimestamp << "}\n";
+
+            enable_nonblocking_output();
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            if (s_pSink == nullptr)
+                return false;
+            s_pSink->record(std::move(pRecording));
+            return true;
+#endif
+        }
+
+        void stop_recording()
+        {
+#ifndef _WIN32
+            std::lock_guard<std::mutex> oLock(s_oSinkMutex);
+            if (s_pSink != nullptr)
+                s_pSink->stop_recording();
+#endif
+        }
+
+#ifndef _WIN32
+        bool query_private_mode(int nMode)
+        {
+            const char *sTerm = std::getenv("TERM");
+            if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO) || sTerm == nullptr || std::strcmp(sTerm, "dumb") == 0)
+                return false;
+
+            // Read the answers unbuffered and without echo
+            termios oSaved;
+            if (tcgetattr(STDIN_FILENO, &oSaved) != 0)
+                return false;
+            termios oRaw = oSaved;
+            oRaw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);
+            oRaw.c_cc[VMIN] = 0;
+            oRaw.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSANOW, &oRaw);
+
+            // Ask for the mode, then for the device attributes, answered last by every terminal.
+            // Written around std::cout, so that it is sent even while the output is queued
+            std::string sQuery = "\033[?";
+            sQuery += std::to_string(nMode);
+            sQuery += "$p\033[c";
+            std::cout.flush();
+            if (write(STDOUT_FILENO, sQuery.data(), sQuery.size()) != static_cast<ssize_t>(sQuery.size()))
+            {
+                tcsetattr(STDIN_FILENO, TCSANOW, &oSaved);
+                return false;
+            }
+            std::string sAnswer;
+            auto oDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(QUERY_TIMEOUT);
+            while (sAnswer.size() < 256)
+            {
+                auto nLeft = std::chrono::duration_cast<std::chrono::milliseconds>(oDeadline - std::chrono::steady_clock::now()).count();
+                pollfd oPoll{STDIN_FILENO, POLLIN, 0};
+                char nChar;
+                if (nLeft <= 0 || poll(&oPoll, 1, static_cast<int>(nLeft)) <= 0 || read(STDIN_FILENO, &nChar, 1) != 1)
+                    break;
+                sAnswer.push_back(nChar);
+                if (nChar == 'c')
+                    break;
+            }
+            tcsetattr(STDIN_FILENO, TCSANOW, &oSaved);
+
+            // Mode report: ESC [ ? mode ; value $ y, with value 1 (set) or 2 (reset) if recognized
+            std::string sReport = "\033[?" + std::to_string(nMode) + ";";
+            std::size_t nReport = sAnswer.find(sReport);
+            if (nReport == std::string::npos || nReport + sReport.size() >= sAnswer.size())
+                return false;
+            char nValue = sAnswer[nReport + sReport.size()];
+            return nValue == '1' || nValue == '2';
+        }
+
+        void on_terminal_resize(int nSignal)
+        {
+            s_nResizeCount.fetch_add(1, std::memory_order_relaxed);
+
+            // Chain the previous handler
+            auto fnPrevious = s_oPreviousResizeAction.sa_handler;
+            if ((s_oPreviousResizeAction.sa_flags & SA_SIGINFO) == 0 && fnPrevious != SIG_DFL && fnPrevious != SIG_IGN && fnPrevious != nullptr)
+                fnPrevious(nSignal);
+        }
+
+        void append_csi(std::string &sSequence, std::size_t nParameter, char cFinal)
+        {
+            // The parameter 1 is the default, so it is omitted
+            sSequence += "\033[";
+            if (nParameter != 1)
+                sSequence += std::to_string(nParameter);
+            sSequence += cFinal;
+        }
+
+        output_sink::output_sink(int nFd, bool bOwned, std::size_t nCapacity)
+            : m_bOwned(bOwned),
+              m_nCapacity(nCapacity),
+              m_nFrameDepth(0),
+              m_bDropped(false),
+              m_bStop(false),
+              m_pTerminal(std::make_shared<output_target>(output_target{nFd, false, false, false, {}, 0, nullptr, 0})),
+              m_vTargets{m_pTerminal},
+              m_nListener(-1),
+              m_aWake{-1, -1}
+        {
+            if (pipe(this->m_aWake) != 0)
+                throw std::runtime_error("Unable to create the pipe of the output thread.");
+            for (int nWake : this->m_aWake)
+            {
+                fcntl(nWake, F_SETFL, fcntl(nWake, F_GETFL) | O_NONBLOCK);
+                fcntl(nWake, F_SETFD, FD_CLOEXEC);
+            }
+            this->m_oWriter = std::thread(&output_sink::write_targets, this);
+        }
+
+        output_sink::~output_sink()
+        {
+            {
+                std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                this->queue_unlocked();
+                this->m_bStop = true;
+            }
+            this->wake();
+            this->m_oWriter.join();
+            this->stop_recording();
+            close(this->m_aWake[0]);
+            close(this->m_aWake[1]);
+            if (this->m_bOwned)
+                close(this->m_pTerminal->m_nFd);
+        }
+
+        void output_sink::begin_frame()
+        {
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            if (this->m_nFrameDepth++ == 0)
+                this->queue_unlocked();
+        }
+
+        void output_sink::end_frame(bool bComplete)
+        {
+            {
+                std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                if (this->m_nFrameDepth == 0 || --this->m_nFrameDepth > 0)
+                    return;
+
+                // Encoded once for every target
+                auto pFrame = std::make_shared<const std::string>(std::move(this->m_sFrame));
+                this->m_sFrame.clear();
+                if (this->m_pRecording != nullptr)
+                    this->record_unlocked(pFrame, bComplete);
+                for (const std::shared_ptr<output_target> &pTarget : this->m_vTargets)
+                {
+                    // Frames on top of dropped ones are useless until a complete one replaces them all
+                    output_target &oTarget = *pTarget;
+                    bool bCongested = oTarget.m_nQueued + pFrame->size() > this->m_nCapacity;
+                    if (oTarget.m_bFailed)
+                    {
+                        continue;
+                    }
+                    else if (bComplete && (bCongested || oTarget.m_bDropping))
+                    {
+                        oTarget.m_vFrames.clear();
+                        oTarget.m_nQueued = 0;
+                        oTarget.m_bDropping = false;
+                        push_unlocked(oTarget, pFrame);
+                    }
+                    else if (!bComplete && (bCongested || oTarget.m_bDropping))
+                    {
+                        oTarget.m_bDropping = true;
+                        this->m_bDropped = true;
+                    }
+                    else
+                    {
+                        push_unlocked(oTarget, pFrame);
+                    }
+                }
+            }
+            this->wake();
+        }
+
+        bool output_sink::take_dropped()
+        {
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            return std::exchange(this->m_bDropped, false);
+        }
+
+        void output_sink::listen(int nListener)
+        {
+            {
+                std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                if (this->m_nListener >= 0)
+                    this->m_vClosing.push_back(this->m_nListener);
+                this->m_nListener = nListener;
+            }
+            this->wake();
+        }
+
+        void output_sink::stop_listening()
+        {
+            {
+                // Only the writer thread closes descriptors, so that it never polls a closed one
+                std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                if (this->m_nListener >= 0)
+                    this->m_vClosing.push_back(std::exchange(this->m_nListener, -1));
+                for (const std::shared_ptr<output_target> &pTarget : this->m_vTargets)
+                    if (pTarget->m_bSpectator)
+                        this->m_vClosing.push_back(pTarget->m_nFd);
+                std::erase_if(this->m_vTargets, [](const std::shared_ptr<output_target> &pTarget)
+                              { return pTarget->m_bSpectator; });
+            }
+            this->wake();
+        }
+
+        std::size_t output_sink::get_spectator_count()
+        {
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            return this->m_vTargets.size() - 1;
+        }
+
+        void output_sink::record(std::shared_ptr<output_recording> pRecording)
+        {
+            this->stop_recording();
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            this->m_pRecording = std::move(pRecording);
+            this->m_bDropped = true;
+        }
+
+        void output_sink::stop_recording()
+        {
+            this->write_recording(true);
+        }
+
+        output_sink::int_type output_sink::overflow(int_type nChar)
+        {
+            if (traits_type::eq_int_type(nChar, traits_type::eof()))
+                return traits_type::not_eof(nChar);
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            this->m_sFrame += traits_type::to_char_type(nChar);
+            return nChar;
+        }
+
+        std::streamsize output_sink::xsputn(const char *pData, std::streamsize nSize)
+        {
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            this->m_sFrame.append(pData, static_cast<std::size_t>(nSize));
+            return nSize;
+        }
+
+        int output_sink::sync()
+        {
+            {
+                std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                if (this->m_nFrameDepth > 0)
+                    return 0;
+                this->queue_unlocked();
+            }
+            this->wake();
+            return 0;
+        }
+
+        void output_sink::queue_unlocked()
+        {
+            if (this->m_sFrame.empty())
+                return;
+
+            // Spectators waiting for a complete frame do not need it
+            auto pFrame = std::make_shared<const std::string>(std::move(this->m_sFrame));
+            this->m_sFrame.clear();
+            if (this->m_pRecording != nullptr)
+                this->record_unlocked(pFrame, false);
+            for (const std::shared_ptr<output_target> &pTarget : this->m_vTargets)
+                if (!pTarget->m_bFailed && !(pTarget->m_bSpectator && pTarget->m_bDropping))
+                    push_unlocked(*pTarget, pFrame);
+        }
+
+        void output_sink::push_unlocked(output_target &oTarget, const std::shared_ptr<const std::string> &pFrame)
+        {
+            if (pFrame->empty())
+                return;
+            oTarget.m_vFrames.push_back(pFrame);
+            oTarget.m_nQueued += pFrame->size();
+        }
+
+        void output_sink::record_unlocked(const std::shared_ptr<const std::string> &pFrame, bool bKeyframe)
+        {
+            // Keyframes are complete frames, asked for as dropped output
+            output_recording &oRecording = *this->m_pRecording;
+            auto oNow = std::chrono::steady_clock::now();
+            if (bKeyframe)
+            {
+                oRecording.m_bStarted = true;
+                oRecording.m_oKeyframe = oNow;
+            }
+            else if (oNow - oRecording.m_oKeyframe >= oRecording.m_oKeyframeInterval)
+            {
+                oRecording.m_oKeyframe = oNow;
+                this->m_bDropped = true;
+            }
+
+            // Whatever comes before the first keyframe can not be replayed
+            if (oRecording.m_bStarted && !pFrame->empty())
+                oRecording.m_vPending.push_back(recorded_output{oNow, bKeyframe, pFrame});
+        }
+
+        void output_sink::write_recording(bool bClose)
+        {
+            std::lock_guard<std::mutex> oRecordingLock(this->m_oRecordingMutex);
+            std::shared_ptr<output_recording> pRecording;
+            std::vector<recorded_output> vPending;
+            {
+                std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                pRecording = bClose ? std::exchange(this->m_pRecording, nullptr) : this->m_pRecording;
+                if (pRecording == nullptr)
+                    return;
+                vPending.swap(pRecording->m_vPending);
+            }
+
+            // One asciicast v2 event per line: [time, "o", data], keyframes preceded by a marker
+            std::string &sLine = pRecording->m_sLine;
+            for (const recorded_output &oOutput : vPending)
+            {
+                char aTime[32];
+                double dTime = std::chrono::duration<double>(oOutput.m_oTime - pRecording->m_oStart).count();
+                auto [pEnd, nError] = std::to_chars(aTime, aTime + sizeof(aTime), dTime, std::chars_format::fixed, 6);
+                std::string_view sTime(aTime, nError == std::errc() ? static_cast<std::size_t>(pEnd - aTime) : 0);
+                sLine.clear();
+                if (oOutput.m_bKeyframe)
+                {
+                    sLine += '[';
+                    sLine += sTime;
+                    sLine += ", \"m\", \"keyframe\"]\n";
+                }
+                sLine += '[';
+                sLine += sTime;
+                sLine += ", \"o\", ";
+                write_json_string(sLine, *oOutput.m_pData);
+                sLine += "]\n";
+                pRecording->m_oFile.write(sLine.data(), static_cast<std::streamsize>(sLine.size()));
+            }
+            if (bClose)
+                pRecording->m_oFile.close();
+        }
+
+        void output_sink::wake()
+        {
+            // A full pipe wakes the thread already
+            char nByte = 0;
+            while (write(this->m_aWake[1], &nByte, 1) < 0 && errno == EINTR)
+                ;
+        }
+
+        void output_sink::accept_spectators(int nListener)
+        {
+            for (;;)
+            {
+                int nSpectator = accept(nListener, nullptr, nullptr);
+                if (nSpectator < 0 && errno == EINTR)
+                    continue;
+                if (nSpectator < 0)
+                    return;
+                fcntl(nSpectator, F_SETFL, fcntl(nSpectator, F_GETFL) | O_NONBLOCK);
+                fcntl(nSpectator, F_SETFD, FD_CLOEXEC);
+
+                // Late joiners wait for the next complete frame, which the renderer is asked for
+                std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                this->m_vTargets.push_back(std::make_shared<output_target>(output_target{nSpectator, true, false, true, {}, 0, nullptr, 0}));
+                this->m_bDropped = true;
+            }
+        }
+
+        bool output_sink::write_target(output_target &oTarget, short nEvents)
+        {
+            // Spectators are not listened to, but their input is read so that they can not block
+            if (oTarget.m_bSpectator && (nEvents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) != 0)
+            {
+                char aDiscarded[256];
+                ssize_t nRead = read(oTarget.m_nFd, aDiscarded, sizeof(aDiscarded));
+                if (nRead == 0 || (nRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                    return false;
+            }
+            // A hung up or broken terminal is reported even when nothing is queued for it,
+            // so it must fail instead of being polled again at once
+            if ((nEvents & (POLLNVAL | POLLHUP | POLLERR)) != 0)
+                return false;
+
+            for (;;)
+            {
+                std::shared_ptr<const std::string> pWriting;
+                std::size_t nWritten = 0;
+                {
+                    std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                    if (oTarget.m_pWriting == nullptr)
+                    {
+                        if (oTarget.m_vFrames.empty())
+                            return true;
+                        oTarget.m_pWriting = std::move(oTarget.m_vFrames.front());
+                        oTarget.m_vFrames.pop_front();
+                        oTarget.m_nQueued -= oTarget.m_pWriting->size();
+                        oTarget.m_nWritten = 0;
+                    }
+                    pWriting = oTarget.m_pWriting;
+                    nWritten = oTarget.m_nWritten;
+                }
+
+                // Spectators hanging up must not raise SIGPIPE
+                const char *pData = pWriting->data() + nWritten;
+                std::size_t nSize = pWriting->size() - nWritten;
+                ssize_t nResult = oTarget.m_bSpectator ? send(oTarget.m_nFd, pData, nSize, MSG_NOSIGNAL) : write(oTarget.m_nFd, pData, nSize);
+                if (nResult < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    return true;
+                if (nResult < 0 && errno == EINTR)
+                    continue;
+                if (nResult <= 0)
+                    return false;
+
+                std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                oTarget.m_nWritten += static_cast<std::size_t>(nResult);
+                if (oTarget.m_nWritten == oTarget.m_pWriting->size())
+                    oTarget.m_pWriting = nullptr;
+            }
+        }
+
+        void output_sink::write_targets()
+        {
+            std::vector<std::shared_ptr<output_target>> vTargets;
+            std::vector<pollfd> vPoll;
+            std::vector<int> vClosing;
+            for (;;)
+            {
+                // Poll the wake pipe, the listening socket and the targets
+                int nListener = -1;
+                bool bStop = false;
+                {
+                    std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                    vClosing.swap(this->m_vClosing);
+                    const output_target &oTerminal = *this->m_pTerminal;
+                    bStop = this->m_bStop && (oTerminal.m_bFailed || (oTerminal.m_pWriting == nullptr && oTerminal.m_vFrames.empty()));
+                    vTargets = this->m_vTargets;
+                    nListener = this->m_nListener;
+                    vPoll.assign(1, pollfd{this->m_aWake[0], POLLIN, 0});
+                    if (nListener >= 0)
+                        vPoll.push_back(pollfd{nListener, POLLIN, 0});
+                    for (const std::shared_ptr<output_target> &pTarget : vTargets)
+                    {
+                        short nEvents = pTarget->m_pWriting != nullptr || !pTarget->m_vFrames.empty() ? POLLOUT : 0;
+                        if (pTarget->m_bSpectator)
+                            nEvents |= POLLIN;
+                        vPoll.push_back(pollfd{pTarget->m_bFailed ? -1 : pTarget->m_nFd, nEvents, 0});
+                    }
+                }
+                for (int nFd : vClosing)
+                    close(nFd);
+                vClosing.clear();
+
+                // Spectators are not waited for
+                if (bStop)
+                {
+                    std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                    for (const std::shared_ptr<output_target> &pTarget : this->m_vTargets)
+                        if (pTarget->m_bSpectator)
+                            close(pTarget->m_nFd);
+                    if (this->m_nListener >= 0)
+                        close(this->m_nListener);
+                    return;
+                }
+
+                if (poll(vPoll.data(), vPoll.size(), -1) < 0)
+                    continue;
+                char aWake[64];
+                if ((vPoll[0].revents & POLLIN) != 0)
+                    while (read(this->m_aWake[0], aWake, sizeof(aWake)) > 0)
+                        ;
+                std::size_t nPoll = 1;
+                if (nListener >= 0 && (vPoll[nPoll++].revents & POLLIN) != 0)
+                    this->accept_spectators(nListener);
+                this->write_recording(false);
+
+                for (const std::shared_ptr<output_target> &pTarget : vTargets)
+                {
+                    short nEvents = vPoll[nPoll++].revents;
+                    if (nEvents == 0 || this->write_target(*pTarget, nEvents))
+                        continue;
+
+                    // Failed spectators are closed, a failed terminal is not written anymore
+                    std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                    pTarget->m_bFailed = true;
+                    pTarget->m_vFrames.clear();
+                    pTarget->m_nQueued = 0;
+                    pTarget->m_pWriting = nullptr;
+                    if (pTarget->m_bSpectator && std::erase(this->m_vTargets, pTarget) > 0)
+                        close(pTarget->m_nFd);
+                }
+            }
+        }
+
+        template <std::size_t N>
+        bool is_terminal_in(const std::array<std::string_view, N> &aPrefixes)
+        {
+            const char *sTerm = std::getenv("TERM");
+            if (!isatty(STDOUT_FILENO) || sTerm == nullptr)
+                return false;
+            std::string_view sName(sTerm);
+            return std::any_of(aPrefixes.begin(), aPrefixes.end(), [&sName](std::string_view sPrefix)
+                               { return sName.starts_with(sPrefix); });
+        }
+
+        std::size_t get_cursor_columns()
+        {
+            // Queried again after every resize
+            std::size_t nResizeCount = get_terminal_resize_count();
+            if (!s_oCursor.m_bQueried || s_oCursor.m_nResizeCount != nResizeCount)
+            {
+                std::size_t nWidth = 0;
+                std::size_t nHeight = 0;
+                s_oCursor.m_nColumns = get_terminal_size(nWidth, nHeight) ? nWidth : SIZE_MAX;
+                s_oCursor.m_nResizeCount = nResizeCount;
+                s_oCursor.m_bQueried = true;
+            }
+            return s_oCursor.m_nColumns;
+        }
+#endif
+
+#ifndef _WIN32
+        std::size_t basic_color_index(ansi_color nColor)
+        {
+            int nCode = static_cast<int>(nColor);
+            return static_cast<std::size_t>(nCode >= 90 ? nCode - 90 + 8 : nCode - 30);
+        }
+
+        const ansi_sgr &basic_sgr(ansi_color nColor, bool bBackground)
+        {
+            // Encoded once, indexed by background and color
+            static const auto s_aSequences = []()
+            {
+                std::array<ansi_sgr, 32> aSequences;
+                for (int nCode : {30, 31, 32, 33, 34, 35, 36, 37, 90, 91, 92, 93, 94, 95, 96, 97})
+                {
+                    ansi_color nBasic = static_cast<ansi_color>(nCode);
+                    aSequences[basic_color_index(nBasic)] = ansi_sgr::foreground(nBasic);
+                    aSequences[16 + basic_color_index(nBasic)] = ansi_sgr::background(nBasic);
+                }
+                return aSequences;
+            }();
+            return s_aSequences[(bBackground ? 16 : 0) + (basic_color_index(nColor) & 15)];
+        }
+#endif
+
 #ifdef _WIN32
         int ansi_to_windows_color(ansi_color nColor)
         {
@@ -159,4 +1420,148 @@ namespace ac
 
     } // namespace ansi
 
+    /// Components of the basic colors, as in the default xterm palette, by basic color index.
+    static constexpr std::array<std::array<std::uint8_t, 3>, 16> BASIC_COLOR_COMPONENTS = {{
+        {0, 0, 0},
+        {205, 0, 0},
+        {0, 205, 0},
+        {205, 205, 0},
+        {0, 0, 238},
+        {205, 0, 205},
+        {0, 205, 205},
+        {229, 229, 229},
+        {127, 127, 127},
+        {255, 0, 0},
+        {0, 255, 0},
+        {255, 255, 0},
+        {92, 92, 255},
+        {255, 0, 255},
+        {0, 255, 255},
+        {255, 255, 255},
+    }};
+
+    ansi_color ansi_extended_color::get_closest_basic() const
+    {
+        auto basic = [](std::size_t nIndex)
+        {
+            return static_cast<ansi_color>(nIndex < 8 ? 30 + nIndex : 90 + nIndex - 8);
+        };
+
+        // Components of the color
+        std::array<int, 3> aComponents;
+        if (this->m_nType == ansi_color_type::BASIC)
+            return this->m_nBasic;
+        else if (this->m_nType == ansi_color_type::INDEXED && this->m_nIndex < 16)
+            return basic(this->m_nIndex);
+        else if (this->m_nType == ansi_color_type::INDEXED && this->m_nIndex < 232)
+        {
+            // 6x6x6 color cube
+            auto level = [](int nStep)
+            {
+                return nStep == 0 ? 0 : 55 + 40 * nStep;
+            };
+            int nCube = this->m_nIndex - 16;
+            aComponents = {level(nCube / 36), level(nCube / 6 % 6), level(nCube % 6)};
+        }
+        else if (this->m_nType == ansi_color_type::INDEXED)
+        {
+            // Grayscale ramp
+            int nGray = 8 + 10 * (this->m_nIndex - 232);
+            aComponents = {nGray, nGray, nGray};
+        }
+        else
+            aComponents = {this->m_nRed, this->m_nGreen, this->m_nBlue};
+
+        // Nearest basic color
+        std::size_t nClosest = 0;
+        int nClosestDistance = -1;
+        for (std::size_t nIndex = 0; nIndex < BASIC_COLOR_COMPONENTS.size(); ++nIndex)
+        {
+            int nDistance = 0;
+            for (std::size_t nComponent = 0; nComponent < 3; ++nComponent)
+            {
+                int nDelta = aComponents[nComponent] - BASIC_COLOR_COMPONENTS[nIndex][nComponent];
+                nDistance += nDelta * nDelta;
+            }
+            if (nClosestDistance < 0 || nDistance < nClosestDistance)
+            {
+                nClosest = nIndex;
+                nClosestDistance = nDistance;
+            }
+        }
+        return basic(nClosest);
+    }
+
+    ansi_sgr::ansi_sgr()
+        : m_aData{},
+          m_nSize(0),
+          m_bBackground(false) {}
+
+    ansi_sgr::ansi_sgr(const ansi_extended_color &oColor, bool bBackground)
+        : m_aData{},
+          m_nSize(0),
+          m_bBackground(bBackground),
+          m_oColor(oColor)
+    {
+        char *pBegin = this->m_aData.data();
+        char *pEnd = pBegin + this->m_aData.size();
+        char *pData = pBegin;
+        auto append = [&pData](std::string_view sText)
+        {
+            pData = std::copy(sText.begin(), sText.end(), pData);
+        };
+        auto number = [&pData, pEnd](unsigned nNumber)
+        {
+            pData = std::to_chars(pData, pEnd, nNumber).ptr;
+        };
+
+        // Basic background colors are 10 more than foreground
+        append("\033[");
+        switch (oColor.get_type())
+        {
+        case ansi_color_type::BASIC:
+            number(static_cast<unsigned>(oColor.get_basic()) + (bBackground ? 10 : 0));
+            break;
+        case ansi_color_type::INDEXED:
+            append(bBackground ? "48;5;" : "38;5;");
+            number(oColor.get_index());
+            break;
+        case ansi_color_type::RGB:
+            append(bBackground ? "48;2;" : "38;2;");
+            number(oColor.get_red());
+            append(";");
+            number(oColor.get_green());
+            append(";");
+            number(oColor.get_blue());
+            break;
+        }
+        append("m");
+        this->m_nSize = static_cast<std::uint8_t>(pData - pBegin);
+    }
+
+    ansi_sgr ansi_sgr::foreground(const ansi_extended_color &oColor)
+    {
+        return ansi_sgr(oColor, false);
+    }
+
+    ansi_sgr ansi_sgr::background(const ansi_extended_color &oColor)
+    {
+        return ansi_sgr(oColor, true);
+    }
+
+    std::string_view ansi_sgr::get_sequence() const noexcept
+    {
+        return std::string_view(this->m_aData.data(), this->m_nSize);
+    }
+
+    const ansi_extended_color &ansi_sgr::get_color() const noexcept
+    {
+        return this->m_oColor;
+    }
+
+    bool ansi_sgr::is_background() const noexcept
+    {
+        return this->m_bBackground;
+    }
+
 } // namespace ac
@@ -19,16 +19,19 @@
 
 #include "ansi_card_renderer.h"
 
+#include "deck_definition.h"
 #include "number.h"
 #include "suit.h"
+#include "unicode.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <string_view>
+#include <vector>
 
 namespace ac
 {
 
-    static inline std::string first_codepoint(const std::string &sString);
-
     static std::mutex s_RenderMutex;
 
     ansi_card_renderer::ansi_card_renderer(
@@ -36,17 +39,17 @@ namespace ac
         std::size_t nCardHeight,
         std::size_t nTableWidth,
         std::size_t nTableHeight,
-        ansi_color nClubsColor,
-        ansi_color nHeartsColor,
-        ansi_color nDiamondsColor,
-        ansi_color nSpadesColor,
-        ansi_color nGoldsColor,
-        ansi_color nCupsColor,
-        ansi_color nSwordsColor,
-        ansi_color nJokersColor,
-        ansi_color nFrameColor,
-        ansi_color nCardPaperColor,
-        ansi_color nTableColor)
+        ansi_extended_color nClubsColor,
+        ansi_extended_color nHeartsColor,
+        ansi_extended_color nDiamondsColor,
+        ansi_extended_color nSpadesColor,
+        ansi_extended_color nGoldsColor,
+        ansi_extended_color nCupsColor,
+        ansi_extended_color nSwordsColor,
+        ansi_extended_color nJokersColor,
+        ansi_extended_color nFrameColor,
+        ansi_extended_color nCardPaperColor,
+        ansi_extended_color nTableColor)
         : m_nClubsColor(nClubsColor),
           m_nHeartsColor(nHeartsColor),
           m_nDiamondsColor(nDiamondsColor),
@@ -57,8 +60,19 @@ namespace ac
           m_nJokersColor(nJokersColor),
           m_nFrameColor(nFrameColor),
           m_nCardPaperColor(nCardPaperColor),
-          m_nTableColor(nTableColor)
-    {
+          m_nTableColor(nTableColor),
+          m_bFitTerminal(false),
+          m_bSynchronizedOutput(true),
+          m_bAlternateScreen(false),
+          m_bRunLengthEncoding(false),
+          m_nTerminalWidth(BEYOND_REACH),
+          m_nTerminalHeight(BEYOND_REACH),
+          m_nResizeCount(BEYOND_REACH),
+          m_bCompleteFrame(false),
+          m_oViewport(0, 0, BEYOND_REACH, BEYOND_REACH),
+          m_bViewport(false)
+    {
+        this->encode_colors();
         this->set_card_width(nCardWidth);
         this->set_card_height(nCardHeight);
         this->set_table_width(nTableWidth);
@@ -70,89 +84,262 @@ namespace ac
           m_nCardHeight(ansi_card_renderer::DEFAULT_CARD_HEIGHT),
           m_nTableWidth(ansi_card_renderer::DEFAULT_TABLE_WIDTH),
           m_nTableHeight(ansi_card_renderer::DEFAULT_TABLE_HEIGHT),
-          m_nClubsColor(ansi_color::GREEN),
-          m_nHeartsColor(ansi_color::RED),
-          m_nDiamondsColor(ansi_color::CYAN),
-          m_nSpadesColor(ansi_color::BRIGHT_BLACK),
-          m_nGoldsColor(ansi_color::YELLOW),
-          m_nCupsColor(ansi_color::CYAN),
-          m_nSwordsColor(ansi_color::BRIGHT_BLACK),
-          m_nJokersColor(ansi_color::MAGENTA),
+          m_nClubsColor(POKER_DECK.find_suit("club")->get_color()),
+          m_nHeartsColor(POKER_DECK.find_suit("heart")->get_color()),
+          m_nDiamondsColor(POKER_DECK.find_suit("diamond")->get_color()),
+          m_nSpadesColor(POKER_DECK.find_suit("spade")->get_color()),
+          m_nGoldsColor(SPANISH_DECK.find_suit("gold")->get_color()),
+          m_nCupsColor(SPANISH_DECK.find_suit("cup")->get_color()),
+          m_nSwordsColor(SPANISH_DECK.find_suit("sword")->get_color()),
+          m_nJokersColor(JOKER_SUIT.get_color()),
+          m_nFrameColor(ansi_color::BLACK),
           m_nCardPaperColor(ansi_color::WHITE),
-          m_nTableColor(ansi_color::GREEN) {}
+          m_nTableColor(ansi_color::GREEN),
+          m_bFitTerminal(false),
+          m_bSynchronizedOutput(true),
+          m_bAlternateScreen(false),
+          m_bRunLengthEncoding(false),
+          m_nTerminalWidth(BEYOND_REACH),
+          m_nTerminalHeight(BEYOND_REACH),
+          m_nResizeCount(BEYOND_REACH),
+          m_bCompleteFrame(false),
+          m_oViewport(0, 0, BEYOND_REACH, BEYOND_REACH),
+          m_bViewport(false)
+    {
+        this->encode_colors();
+    }
 
     void ansi_card_renderer::render_card(const number *pCard, point oPos) const
+    {
+        rect oCard(oPos, this->m_nCardWidth, this->m_nCardHeight);
+        this->render_card(pCard, oPos, std::span<const rect>(&oCard, 1));
+    }
+
+    void ansi_card_renderer::render_card(const number *pCard, point oPos, std::span<const rect> vExposed) const
     {
         std::lock_guard<std::mutex> oLock(s_RenderMutex);
 
-        // Render the frame
-        ansi::set_ansi_background_color(this->m_nCardPaperColor);
-        ansi::set_ansi_foreground_color(this->m_nFrameColor);
-        ansi::move_ansi_cursor(oPos.get_x(), oPos.get_y());
-        std::cout << "*" << std::string(this->m_nCardWidth - 2, '-') << "*";
-        ansi::move_ansi_cursor(oPos.get_x(), oPos.get_y() + this->m_nCardHeight - 1);
-        std::cout << "*" << std::string(this->m_nCardWidth - 2, '-') << "*";
-        for (std::size_t nHeight = 1; nHeight < this->m_nCardHeight - 1; ++nHeight)
+        card_face oFace;
+        this->layout_card(pCard, oFace);
+
+        // A cell is drawn when exposed, inside the card and, when fitting it, inside the terminal
+        std::size_t nWidth = this->m_nCardWidth;
+        rect oCard(oPos, nWidth, this->m_nCardHeight);
+        rect oScreen = this->get_screen();
+        auto visible = [&vExposed, &oCard, &oScreen](const point &oCell)
         {
-            ansi::move_ansi_cursor(oPos.get_x(), oPos.get_y() + nHeight);
-            std::cout << "|" << std::string(this->m_nCardWidth - 2, ' ') << "|";
+            return oCard.contains(oCell) && oScreen.contains(oCell) &&
+                   std::any_of(vExposed.begin(), vExposed.end(), [&oCell](const rect &oExposed)
+                               { return oExposed.contains(oCell); });
+        };
+
+        // Draw the exposed cells, row by row
+        const ansi_sgr &oSuitSgr = this->m_aSgr[this->get_suit_sgr(pCard->get_suit()->get_name())];
+        ansi::set_ansi_color(this->m_aSgr[CARD_PAPER_SGR]);
+        for (const rect &oExposed : vExposed)
+        {
+            for (std::size_t nY = oExposed.get_y(); nY - oExposed.get_y() < oExposed.get_height(); ++nY)
+            {
+                // Identical narrow cells are written at once, as a run
+                bool bMoved = false;
+                bool bSuitColored = false;
+                std::string_view sRun;
+                std::size_t nRun = 0;
+                auto flush = [this, &sRun, &nRun]()
+                {
+                    if (nRun > 0)
+                        this->write_run(sRun, nRun);
+                    nRun = 0;
+                };
+                for (std::size_t nX = oExposed.get_x(); nX - oExposed.get_x() < oExposed.get_width(); ++nX)
+                {
+                    // Clip to the card, and to the terminal when fitting it
+                    if (!oCard.contains(point(nX, nY)) || !oScreen.contains(point(nX, nY)))
+                    {
+                        flush();
+                        bMoved = false;
+                        continue;
+                    }
+
+                    // Half a wide glyph can not be drawn, so a lone half is blanked
+                    std::size_t nCell = (nY - oPos.get_y()) * nWidth + (nX - oPos.get_x());
+                    std::string_view sGlyph = oFace.m_vGlyphs[nCell];
+                    std::size_t nGlyphWidth = oFace.m_vWidths[nCell];
+                    if (nGlyphWidth == 0)
+                    {
+                        if (nX > 0 && visible(point(nX - 1, nY)))
+                            continue;
+                        sGlyph = " ";
+                        nGlyphWidth = 1;
+                    }
+                    else if (nGlyphWidth == 2 && !visible(point(nX + 1, nY)))
+                    {
+                        sGlyph = " ";
+                        nGlyphWidth = 1;
+                    }
+
+                    if (!bMoved || oFace.m_vSuitColored[nCell] != bSuitColored)
+                    {
+                        flush();
+                        if (!bMoved)
+                            this->move_cursor(nX, nY);
+                        ansi::set_ansi_color(oFace.m_vSuitColored[nCell] ? oSuitSgr : this->m_aSgr[FRAME_SGR]);
+                        bMoved = true;
+                        bSuitColored = oFace.m_vSuitColored[nCell];
+                    }
+                    if (nGlyphWidth == 1 && nRun > 0 && sGlyph == sRun)
+                    {
+                        ++nRun;
+                        continue;
+                    }
+                    flush();
+                    if (nGlyphWidth == 1)
+                    {
+                        sRun = sGlyph;
+                        nRun = 1;
+                        continue;
+                    }
+                    std::cout << sGlyph;
+                    ansi::advance_ansi_cursor(nGlyphWidth);
+                }
+                flush();
+            }
         }
 
-        // Calcultare values
-        std::string sNumber = first_codepoint(pCard->get_display_name());
-        std::string sSuit = first_codepoint(pCard->get_suit()->get_display_name());
-        std::string sDisplayL = sSuit + sNumber;
-        std::string sDisplayR = sNumber + sSuit;
-        std::string sStdSuit = pCard->get_suit()->get_name();
+        // Reset colors
+        ansi::reset_ansi_colors();
+        std::cout.flush();
+    }
 
-        // Set suit color
+    ansi_card_renderer::sgr_index ansi_card_renderer::get_suit_sgr(const std::string &sStdSuit) const
+    {
         if (sStdSuit == "heart")
-        {
-            ansi::set_ansi_foreground_color(this->m_nHeartsColor);
-        }
+            return HEARTS_SGR;
         else if (sStdSuit == "diamond")
-        {
-            ansi::set_ansi_foreground_color(this->m_nDiamondsColor);
-        }
+            return DIAMONDS_SGR;
         else if (sStdSuit == "club")
-        {
-            ansi::set_ansi_foreground_color(this->m_nClubsColor);
-        }
+            return CLUBS_SGR;
         else if (sStdSuit == "spade")
+            return SPADES_SGR;
+        else if (sStdSuit == "gold")
+            return GOLDS_SGR;
+        else if (sStdSuit == "cup")
+            return CUPS_SGR;
+        else if (sStdSuit == "sword")
+            return SWORDS_SGR;
+        else if (sStdSuit == "joker")
+            return JOKERS_SGR;
+        return FRAME_SGR;
+    }
+
+    void ansi_card_renderer::layout_card(const number *pCard, card_face &oFace) const
+    {
+        // Lay out the frame, one glyph per cell
+        std::size_t nWidth = this->m_nCardWidth;
+        std::size_t nHeight = this->m_nCardHeight;
+        oFace.m_vGlyphs.assign(nWidth * nHeight, " ");
+        oFace.m_vWidths.assign(nWidth * nHeight, 1);
+        oFace.m_vSuitColored.assign(nWidth * nHeight, false);
+        for (std::size_t nColumn = 0; nColumn < nWidth; ++nColumn)
         {
-            ansi::set_ansi_foreground_color(this->m_nSpadesColor);
+            bool bCorner = nColumn == 0 || nColumn == nWidth - 1;
+            oFace.m_vGlyphs[nColumn] = bCorner ? "*" : "-";
+            oFace.m_vGlyphs[(nHeight - 1) * nWidth + nColumn] = bCorner ? "*" : "-";
         }
-        else if (sStdSuit == "gold")
+        for (std::size_t nRow = 1; nRow < nHeight - 1; ++nRow)
         {
-            ansi::set_ansi_foreground_color(this->m_nGoldsColor);
+            oFace.m_vGlyphs[nRow * nWidth] = "|";
+            oFace.m_vGlyphs[nRow * nWidth + nWidth - 1] = "|";
         }
-        else if (sStdSuit == "cup")
+
+        // Measure the displays: glyphs taking no cell are not shown, wider ones take two cells
+        bool bJoker = pCard->get_suit()->get_name() == "joker";
+        oFace.m_sSuit = bJoker ? std::string("J") : std::string(unicode::first_glyph(pCard->get_suit()->get_display_name()));
+        oFace.m_sNumber = bJoker ? std::string() : std::string(unicode::first_glyph(pCard->get_display_name()));
+        auto measure = [](std::string &sGlyph)
+        {
+            std::size_t nGlyphWidth = unicode::display_width(sGlyph);
+            if (nGlyphWidth == 0)
+                sGlyph.clear();
+            return std::min<std::size_t>(nGlyphWidth, 2);
+        };
+        std::size_t nSuitWidth = measure(oFace.m_sSuit);
+        std::size_t nNumberWidth = measure(oFace.m_sNumber);
+
+        // Lay out the displays: suit and number on the top left corner, number and suit on the bottom right one
+        auto display = [&oFace, nWidth](std::size_t nColumn, std::size_t nRow, std::string_view sGlyph, std::size_t nGlyphWidth)
         {
-            ansi::set_ansi_foreground_color(this->m_nCupsColor);
+            std::size_t nCell = nRow * nWidth + nColumn;
+            oFace.m_vGlyphs[nCell] = sGlyph;
+            oFace.m_vWidths[nCell] = static_cast<std::uint8_t>(nGlyphWidth);
+            oFace.m_vSuitColored[nCell] = true;
+            for (std::size_t nNext = 1; nNext < nGlyphWidth; ++nNext)
+            {
+                oFace.m_vGlyphs[nCell + nNext] = "";
+                oFace.m_vWidths[nCell + nNext] = 0;
+                oFace.m_vSuitColored[nCell + nNext] = true;
+            }
+        };
+        std::size_t nInner = nWidth - 2;
+        if (nSuitWidth > 0 && nSuitWidth <= nInner)
+        {
+            display(1, 1, oFace.m_sSuit, nSuitWidth);
+            display(nWidth - 1 - nSuitWidth, nHeight - 2, oFace.m_sSuit, nSuitWidth);
         }
-        else if (sStdSuit == "sword")
+        if (nNumberWidth > 0 && nSuitWidth + nNumberWidth <= nInner)
         {
-            ansi::set_ansi_foreground_color(this->m_nSwordsColor);
+            display(1 + nSuitWidth, 1, oFace.m_sNumber, nNumberWidth);
+            display(nWidth - 1 - nSuitWidth - nNumberWidth, nHeight - 2, oFace.m_sNumber, nNumberWidth);
         }
-        else if (sStdSuit == "joker")
+    }
+
+    void ansi_card_renderer::encode_colors()
+    {
+        this->m_aSgr[CLUBS_SGR] = ansi_sgr::foreground(this->m_nClubsColor);
+        this->m_aSgr[HEARTS_SGR] = ansi_sgr::foreground(this->m_nHeartsColor);
+        this->m_aSgr[DIAMONDS_SGR] = ansi_sgr::foreground(this->m_nDiamondsColor);
+        this->m_aSgr[SPADES_SGR] = ansi_sgr::foreground(this->m_nSpadesColor);
+        this->m_aSgr[GOLDS_SGR] = ansi_sgr::foreground(this->m_nGoldsColor);
+        this->m_aSgr[CUPS_SGR] = ansi_sgr::foreground(this->m_nCupsColor);
+        this->m_aSgr[SWORDS_SGR] = ansi_sgr::foreground(this->m_nSwordsColor);
+        this->m_aSgr[JOKERS_SGR] = ansi_sgr::foreground(this->m_nJokersColor);
+        this->m_aSgr[FRAME_SGR] = ansi_sgr::foreground(this->m_nFrameColor);
+        this->m_aSgr[CARD_PAPER_SGR] = ansi_sgr::background(this->m_nCardPaperColor);
+        this->m_aSgr[TABLE_SGR] = ansi_sgr::background(this->m_nTableColor);
+    }
+
+    void ansi_card_renderer::write_run(std::string_view sGlyph, std::size_t nCount) const
+    {
+        if (this->m_bRunLengthEncoding)
         {
-            ansi::set_ansi_foreground_color(this->m_nJokersColor);
+            ansi::write_ansi_repeated(sGlyph, nCount);
+            return;
         }
+        for (std::size_t nGlyph = 0; nGlyph < nCount; ++nGlyph)
+            std::cout << sGlyph;
+        ansi::advance_ansi_cursor(nCount);
+    }
 
-        // Draw displays
-        if (sStdSuit != "joker")
+    void ansi_card_renderer::render_table() const
+    {
+        // A viewport shares the terminal, so only its own cells are painted
+        if (this->m_bViewport)
         {
-            ansi::move_ansi_cursor(oPos.get_x() + 1, oPos.get_y() + 1);
-            std::cout << sDisplayL;
-            ansi::move_ansi_cursor(oPos.get_x() + this->m_nCardWidth - 3, oPos.get_y() + this->m_nCardHeight - 2);
-            std::cout << sDisplayR;
+            rect oArea(0, 0, this->m_oViewport.get_width(), this->m_oViewport.get_height());
+            this->render_table(std::span<const rect>(&oArea, 1));
+            return;
         }
-        else
+
+        std::lock_guard<std::mutex> oLock(s_RenderMutex);
+        ansi::clear_screen();
+        this->m_bCompleteFrame = true;
+
+        // Render the table
+        ansi::set_ansi_color(this->m_aSgr[TABLE_SGR]);
+        for (std::size_t nHeight = 0; nHeight < this->get_table_height(); ++nHeight)
         {
-            ansi::move_ansi_cursor(oPos.get_x() + 1, oPos.get_y() + 1);
-            std::cout << "J";
-            ansi::move_ansi_cursor(oPos.get_x() + this->m_nCardWidth - 2, oPos.get_y() + this->m_nCardHeight - 2);
-            std::cout << "J";
+            this->move_cursor(0, nHeight);
+            this->write_run(" ", this->get_table_width());
         }
 
         // Reset colors
@@ -160,19 +347,44 @@ namespace ac
         std::cout.flush();
     }
 
-    void ansi_card_renderer::render_table() const
+    void ansi_card_renderer::render_table(std::span<const rect> vRegions) const
     {
         std::lock_guard<std::mutex> oLock(s_RenderMutex);
-        ansi::clear_screen();
 
-        // Render the table
-        std::string sBlank(this->m_nTableWidth, ' ');
-        ansi::set_ansi_background_color(this->m_nTableColor);
-        for (std::size_t nHeight = 0; nHeight < this->m_nTableHeight; ++nHeight)
+        // Paint every row of the regions, switching colors at the border of the table
+        rect oTable(0, 0, this->get_table_width(), this->get_table_height());
+        rect oScreen = this->get_screen();
+        for (const rect &oRegion : vRegions)
         {
-            ansi::move_ansi_cursor(0, nHeight);
-            std::cout << "\033[42m";
-            std::cout << sBlank;
+            for (std::size_t nY = oRegion.get_y(); nY - oRegion.get_y() < oRegion.get_height(); ++nY)
+            {
+                // Nothing is drawn outside the viewport, nor outside the terminal when fitting it
+                if (!oScreen.contains(point(oRegion.get_x(), nY)))
+                    continue;
+
+                this->move_cursor(oRegion.get_x(), nY);
+                bool bInside = false;
+                bool bFirst = true;
+                std::size_t nRun = 0;
+                for (std::size_t nX = oRegion.get_x(); nX - oRegion.get_x() < oRegion.get_width() && oScreen.contains(point(nX, nY)); ++nX)
+                {
+                    if (bFirst || oTable.contains(point(nX, nY)) != bInside)
+                    {
+                        if (nRun > 0)
+                            this->write_run(" ", nRun);
+                        nRun = 0;
+                        bInside = oTable.contains(point(nX, nY));
+                        if (bInside)
+                            ansi::set_ansi_color(this->m_aSgr[TABLE_SGR]);
+                        else
+                            ansi::reset_ansi_colors();
+                        bFirst = false;
+                    }
+                    ++nRun;
+                }
+                if (nRun > 0)
+                    this->write_run(" ", nRun);
+            }
         }
 
         // Reset colors
@@ -180,6 +392,75 @@ namespace ac
         std::cout.flush();
     }
 
+    bool ansi_card_renderer::can_render_regions() const
+    {
+        return true;
+    }
+
+    void ansi_card_renderer::get_wide_glyphs(const number *pCard, std::vector<rect> &vGlyphs) const
+    {
+        card_face oFace;
+        this->layout_card(pCard, oFace);
+        for (std::size_t nCell = 0; nCell < oFace.m_vWidths.size(); ++nCell)
+        {
+            if (oFace.m_vWidths[nCell] > 1)
+                vGlyphs.emplace_back(nCell % this->m_nCardWidth, nCell / this->m_nCardWidth, oFace.m_vWidths[nCell], 1);
+        }
+    }
+
+    bool ansi_card_renderer::update_size() const
+    {
+        // Frames dropped by a congested terminal are replaced by a full redraw, of the whole
+        // terminal for viewports (see ansi_compositor::refresh)
+        bool bDropped = !this->m_bViewport && ansi::take_dropped_output();
+        if (!this->m_bFitTerminal)
+            return bDropped;
+
+        // Query the terminal once per burst of resizes
+        std::size_t nResizeCount = ansi::get_terminal_resize_count();
+        if (this->m_nResizeCount.exchange(nResizeCount) == nResizeCount)
+            return bDropped;
+
+        // Unknown sizes do not clip
+        std::size_t nWidth = BEYOND_REACH;
+        std::size_t nHeight = BEYOND_REACH;
+        if (!ansi::get_terminal_size(nWidth, nHeight))
+            nWidth = nHeight = BEYOND_REACH;
+        bool bWidthChanged = this->m_nTerminalWidth.exchange(nWidth) != nWidth;
+        bool bHeightChanged = this->m_nTerminalHeight.exchange(nHeight) != nHeight;
+        return bDropped || bWidthChanged || bHeightChanged;
+    }
+
+    void ansi_card_renderer::begin_frame() const
+    {
+        std::lock_guard<std::mutex> oLock(s_RenderMutex);
+        ansi::begin_output_frame();
+        this->m_bCompleteFrame = false;
+        if (this->m_bAlternateScreen)
+            ansi::enter_alternate_screen();
+        ansi::hide_cursor();
+
+        // Terminals without the mode ignore it, so it is not probed from here (that would read the input)
+        if (this->m_bSynchronizedOutput)
+            ansi::begin_synchronized_update();
+
+        // Anything written around the stream, as when clearing the screen, must come after.
+        // Whatever was written since the last frame moved the cursor
+        std::cout.flush();
+        ansi::forget_ansi_cursor();
+    }
+
+    void ansi_card_renderer::end_frame() const
+    {
+        std::lock_guard<std::mutex> oLock(s_RenderMutex);
+        if (this->m_bSynchronizedOutput)
+            ansi::end_synchronized_update();
+        ansi::show_cursor();
+        std::cout.flush();
+        ansi::forget_ansi_cursor();
+        ansi::end_output_frame(this->m_bCompleteFrame);
+    }
+
     std::size_t ansi_card_renderer::get_card_width() const
     {
         return this->m_nCardWidth;
@@ -192,69 +473,99 @@ namespace ac
 
     std::size_t ansi_card_renderer::get_table_width() const
     {
-        return this->m_nTableWidth;
+        return std::min<std::size_t>(this->m_nTableWidth, this->get_screen().get_width());
     }
 
     std::size_t ansi_card_renderer::get_table_height() const
     {
-        return this->m_nTableHeight;
+        return std::min<std::size_t>(this->m_nTableHeight, this->get_screen().get_height());
     }
 
-    ansi_color ansi_card_renderer::get_clubs_color() const
+    ansi_extended_color ansi_card_renderer::get_clubs_color() const
     {
         return this->m_nClubsColor;
     }
 
-    ansi_color ansi_card_renderer::get_hearts_color() const
+    ansi_extended_color ansi_card_renderer::get_hearts_color() const
     {
         return this->m_nHeartsColor;
     }
 
-    ansi_color ansi_card_renderer::get_diamonds_color() const
+    ansi_extended_color ansi_card_renderer::get_diamonds_color() const
     {
         return this->m_nDiamondsColor;
     }
 
-    ansi_color ansi_card_renderer::get_spades_color() const
+    ansi_extended_color ansi_card_renderer::get_spades_color() const
     {
         return this->m_nSpadesColor;
     }
 
-    ansi_color ansi_card_renderer::get_golds_color() const
+    ansi_extended_color ansi_card_renderer::get_golds_color() const
     {
         return this->m_nGoldsColor;
     }
 
-    ansi_color ansi_card_renderer::get_cups_color() const
+    ansi_extended_color ansi_card_renderer::get_cups_color() const
     {
         return this->m_nCupsColor;
     }
 
-    ansi_color ansi_card_renderer::get_swords_color() const
+    ansi_extended_color ansi_card_renderer::get_swords_color() const
     {
         return this->m_nSwordsColor;
     }
 
-    ansi_color ansi_card_renderer::get_jokers_color() const
+    ansi_extended_color ansi_card_renderer::get_jokers_color() const
     {
         return this->m_nJokersColor;
     }
 
-    ansi_color ansi_card_renderer::get_frame_color() const
+    ansi_extended_color ansi_card_renderer::get_frame_color() const
     {
         return this->m_nFrameColor;
     }
 
-    ansi_color ansi_card_renderer::get_card_paper_color() const
+    ansi_extended_color ansi_card_renderer::get_card_paper_color() const
     {
         return this->m_nCardPaperColor;
     }
 
-    ansi_color ansi_card_renderer::get_table_color() const
+    ansi_extended_color ansi_card_renderer::get_table_color() const
     {
         return this->m_nTableColor;
     }
 
+    bool ansi_card_renderer::get_fit_terminal() const
+    {
+        return this->m_bFitTerminal;
+    }
+
+    bool ansi_card_renderer::get_synchronized_output() const
+    {
+        return this->m_bSynchronizedOutput;
+    }
+
+    bool ansi_card_renderer::get_alternate_screen() const
+    {
+        return this->m_bAlternateScreen;
+    }
+
+    bool ansi_card_renderer::get_run_length_encoding() const
+    {
+        return this->m_bRunLengthEncoding;
+    }
+
+    bool ansi_card_renderer::has_viewport() const
+    {
+        return this->m_bViewport;
+    }
+
+    rect ansi_card_renderer::get_viewport() const
+    {
+        return this->m_oViewport;
+    }
+
     void ansi_card_renderer::set_card_width(std::size_t nWidth)
     {
         if (nWidth < 4 || nWidth > 100)
@@ -287,104 +598,128 @@ namespace ac
             this->m_nTableHeight = nHeight;
     }
 
-    void ansi_card_renderer::set_clubs_color(ansi_color nColor)
+    void ansi_card_renderer::set_clubs_color(ansi_extended_color nColor)
     {
         this->m_nClubsColor = nColor;
+        this->encode_colors();
     }
 
-    void ansi_card_renderer::set_hearts_color(ansi_color nColor)
+    void ansi_card_renderer::set_hearts_color(ansi_extended_color nColor)
     {
         this->m_nHeartsColor = nColor;
+        this->encode_colors();
     }
 
-    void ansi_card_renderer::set_diamonds_color(ansi_color nColor)
+    void ansi_card_renderer::set_diamonds_color(ansi_extended_color nColor)
     {
         this->m_nDiamondsColor = nColor;
+        this->encode_colors();
     }
 
-    void ansi_card_renderer::set_spades_color(ansi_color nColor)
+    void ansi_card_renderer::set_spades_color(ansi_extended_color nColor)
     {
         this->m_nSpadesColor = nColor;
+        this->encode_colors();
     }
 
-    void ansi_card_renderer::set_golds_color(ansi_color nColor)
+    void ansi_card_renderer::set_golds_color(ansi_extended_color nColor)
     {
         this->m_nGoldsColor = nColor;
+        this->encode_colors();
     }
 
-    void ansi_card_renderer::set_cups_color(ansi_color nColor)
+    void ansi_card_renderer::set_cups_color(ansi_extended_color nColor)
     {
         this->m_nCupsColor = nColor;
+        this->encode_colors();
     }
 
-    void ansi_card_renderer::set_swords_color(ansi_color nColor)
+    void ansi_card_renderer::set_swords_color(ansi_extended_color nColor)
     {
         this->m_nSwordsColor = nColor;
+        this->encode_colors();
     }
 
-    void ansi_card_renderer::set_jokers_color(ansi_color nColor)
+    void ansi_card_renderer::set_jokers_color(ansi_extended_color nColor)
     {
         this->m_nJokersColor = nColor;
+        this->encode_colors();
     }
 
-    void ansi_card_renderer::set_frame_color(ansi_color nColor)
+    void ansi_card_renderer::set_frame_color(ansi_extended_color nColor)
     {
         this->m_nFrameColor = nColor;
+        this->encode_colors();
     }
 
-    void ansi_card_renderer::set_card_paper_color(ansi_color nColor)
+    void ansi_card_renderer::set_card_paper_color(ansi_extended_color nColor)
     {
         this->m_nCardPaperColor = nColor;
+        this->encode_colors();
     }
 
-    void ansi_card_renderer::set_table_color(ansi_color nColor)
+    void ansi_card_renderer::set_table_color(ansi_extended_color nColor)
     {
         this->m_nTableColor = nColor;
+        this->encode_colors();
     }
 
-    std::string first_codepoint(const std::string &sString)
+    void ansi_card_renderer::set_fit_terminal(bool bFitTerminal)
     {
+        this->m_bFitTerminal = bFitTerminal;
+        this->m_nTerminalWidth = BEYOND_REACH;
+        this->m_nTerminalHeight = BEYOND_REACH;
 
-        if (sString.empty())
-            return "";
+        // The terminal is queried on the next update
+        this->m_nResizeCount = BEYOND_REACH;
+        if (bFitTerminal)
+            ansi::watch_terminal_resize();
+    }
 
-        unsigned char cFirstByte = static_cast<unsigned char>(sString[0]);
+    void ansi_card_renderer::set_synchronized_output(bool bSynchronizedOutput)
+    {
+        this->m_bSynchronizedOutput = bSynchronizedOutput;
+    }
 
-        // Determine the number of bytes in the UTF-8 character
-        if ((cFirstByte & 0x80) == 0)
-        {
-            // 1-byte character (ASCII)
-            // Code point is the same as the byte value
-            return sString.substr(0, 1);
-        }
-        else if ((cFirstByte & 0xE0) == 0xC0)
-        {
-            // 2-byte character
-            if (sString.size() < 2)
-                throw std::invalid_argument("Invalid UTF-8 string.");
-            // Code point is the same as the byte value
-            return sString.substr(0, 2);
-        }
-        else if ((cFirstByte & 0xF0) == 0xE0)
-        {
-            // 3-byte character
-            if (sString.size() < 3)
-                throw std::invalid_argument("Invalid UTF-8 string.");
-            // Code point is the same as the byte value
-            return sString.substr(0, 3);
-        }
-        else if ((cFirstByte & 0xF8) == 0xF0)
-        {
-            // 4-byte character
-            if (sString.size() < 4)
-                throw std::invalid_argument("Invalid UTF-8 string.");
-            // Code point is the same as the byte value
-            return sString.substr(0, 4);
-        }
-        else
-        {
-            throw std::invalid_argument("Invalid UTF-8 string.");
-        }
+    void ansi_card_renderer::set_alternate_screen(bool bAlternateScreen)
+    {
+        if (this->m_bAlternateScreen && !bAlternateScreen)
+            ansi::leave_alternate_screen();
+        this->m_bAlternateScreen = bAlternateScreen;
+    }
+
+    void ansi_card_renderer::set_run_length_encoding(bool bRunLengthEncoding)
+    {
+        this->m_bRunLengthEncoding = bRunLengthEncoding;
+    }
+
+    void ansi_card_renderer::set_viewport(const rect &oViewport)
+    {
+        this->m_oViewport = oViewport;
+        this->m_bViewport = true;
+    }
+
+    void ansi_card_renderer::reset_viewport()
+    {
+        this->m_oViewport = rect(0, 0, BEYOND_REACH, BEYOND_REACH);
+        this->m_bViewport = false;
+    }
+
+    rect ansi_card_renderer::get_screen() const
+    {
+        // The cells of the viewport inside the terminal, from the origin of the table
+        std::size_t nTerminalWidth = this->m_nTerminalWidth;
+        std::size_t nTerminalHeight = this->m_nTerminalHeight;
+        std::size_t nX = this->m_oViewport.get_x();
+        std::size_t nY = this->m_oViewport.get_y();
+        std::size_t nWidth = nTerminalWidth > nX ? nTerminalWidth - nX : 0;
+        std::size_t nHeight = nTerminalHeight > nY ? nTerminalHeight - nY : 0;
+        return rect(0, 0, std::min(nWidth, this->m_oViewport.get_width()), std::min(nHeight, this->m_oViewport.get_height()));
+    }
+
+    void ansi_card_renderer::move_cursor(std::size_t nX, std::size_t nY) const
+    {
+        ansi::move_ansi_cursor(this->m_oViewport.get_x() + nX, this->m_oViewport.get_y() + nY);
     }
 
 } // namespace ac
@@ -0,0 +1,105 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+#include "ansi_compositor.h"
+#include "ansi.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace ac
+{
+
+    ansi_compositor::ansi_compositor()
+        : m_nResizeCount(BEYOND_REACH)
+    {
+    }
+
+    void ansi_compositor::add_viewport(ansi_card_table *pTable, ansi_card_renderer *pRenderer, const rect &oViewport)
+    {
+        if (pTable == nullptr || pRenderer == nullptr)
+            throw std::invalid_argument("A viewport needs a table and a renderer.");
+
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        auto pIt = std::find_if(this->m_vViewports.begin(), this->m_vViewports.end(), [pTable](const viewport &oViewport)
+                                { return oViewport.m_pTable == pTable; });
+        if (pIt != this->m_vViewports.end())
+            throw std::invalid_argument("The table already has a viewport.");
+
+        pRenderer->set_viewport(oViewport);
+        pTable->set_renderer(pRenderer);
+        this->m_vViewports.push_back(viewport{pTable, pRenderer, oViewport});
+    }
+
+    bool ansi_compositor::remove_viewport(const ansi_card_table *pTable)
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        auto pIt = std::find_if(this->m_vViewports.begin(), this->m_vViewports.end(), [pTable](const viewport &oViewport)
+                                { return oViewport.m_pTable == pTable; });
+        if (pIt == this->m_vViewports.end())
+            return false;
+
+        pIt->m_pRenderer->reset_viewport();
+        this->m_vViewports.erase(pIt);
+        return true;
+    }
+
+    std::size_t ansi_compositor::get_viewport_count() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return this->m_vViewports.size();
+    }
+
+    void ansi_compositor::render() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        // The tables are nested in one frame, so that it replaces the frames queued before
+        ansi::begin_output_frame();
+        if (std::any_of(this->m_vViewports.begin(), this->m_vViewports.end(), [](const viewport &oViewport)
+                        { return oViewport.m_pRenderer->get_alternate_screen(); }))
+            ansi::enter_alternate_screen();
+        std::cout.flush();
+        ansi::clear_screen();
+        std::cout.flush();
+        for (const viewport &oViewport : this->m_vViewports)
+            oViewport.m_pTable->render_safe();
+        ansi::end_output_frame(true);
+    }
+
+    bool ansi_compositor::refresh() const
+    {
+        // Every renderer is updated, even once a redraw is known to be needed
+        bool bRedraw = ansi::take_dropped_output();
+        {
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            std::size_t nResizeCount = ansi::get_terminal_resize_count();
+            bRedraw = std::exchange(this->m_nResizeCount, nResizeCount) != nResizeCount || bRedraw;
+            for (const viewport &oViewport : this->m_vViewports)
+                bRedraw = oViewport.m_pRenderer->update_size() || bRedraw;
+        }
+        if (!bRedraw)
+            return false;
+        this->render();
+        return true;
+    }
+
+} // namespace ac
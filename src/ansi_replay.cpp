@@ -0,0 +1,275 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+
+#include "ansi_replay.h"
+#include "ansi.h"
+#include "json_sax.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace ac
+{
+
+    /**
+     * @class ansi_replay_handler
+     * @brief Handler filling an ansi_replay from the lines of an asciicast v2 file.
+     */
+    class ansi_replay_handler : public json_sax_handler
+    {
+    public:
+        /**
+         * @brief Constructs a handler.
+         * @param pReplay The replay to fill.
+         * @param sPath The path of the file, for the error messages.
+         */
+        ansi_replay_handler(ansi_replay *pReplay, const std::string &sPath);
+
+    public:
+        virtual void on_start_object() override;
+        virtual void on_end_object() override;
+        virtual void on_start_array() override;
+        virtual void on_end_array() override;
+        virtual void on_key(std::string_view sKey) override;
+        virtual void on_value(json_type nType, std::string_view sValue) override;
+
+    private:
+        ansi_replay *m_pReplay; ///< The replay filled.
+        std::string m_sPath;    ///< The path of the file.
+        std::size_t m_nDepth;   ///< Nesting depth.
+        std::size_t m_nValues;  ///< Number of top-level values parsed.
+        std::size_t m_nElement; ///< Index of the next element of the event.
+        std::string m_sKey;     ///< Last key of the header.
+        std::size_t m_nVersion; ///< Version of the header.
+        double m_dTime;         ///< Time of the event.
+        std::string m_sType;    ///< Type of the event.
+        std::string m_sData;    ///< Data of the event.
+        bool m_bKeyframe;       ///< Whether the next output event is a keyframe.
+
+    private:
+        /**
+         * @brief Throws an error about the file.
+         * @param sMessage The error message.
+         */
+        [[noreturn]] void fail(const std::string &sMessage) const;
+    };
+
+    ansi_replay::ansi_replay(const std::string &sPath)
+        : m_nWidth(0),
+          m_nHeight(0)
+    {
+        std::ifstream oFile(sPath, std::ios::binary);
+        if (!oFile)
+            throw std::runtime_error("Unable to open recording \'" + sPath + "\'.");
+        ansi_replay_handler oHandler(this, sPath);
+        json_sax_reader oReader(oFile);
+        oReader.parse(&oHandler);
+    }
+
+    std::size_t ansi_replay::get_width() const
+    {
+        return this->m_nWidth;
+    }
+
+    std::size_t ansi_replay::get_height() const
+    {
+        return this->m_nHeight;
+    }
+
+    double ansi_replay::get_duration() const
+    {
+        return this->m_vEvents.empty() ? 0.0 : this->m_vEvents.back().m_dTime;
+    }
+
+    std::size_t ansi_replay::get_event_count() const
+    {
+        return this->m_vEvents.size();
+    }
+
+    std::size_t ansi_replay::get_keyframe_count() const
+    {
+        return this->m_vKeyframes.size();
+    }
+
+    void ansi_replay::seek(double dTime) const
+    {
+        // Start at the last keyframe up to the time
+        std::size_t nEnd = this->find_event(dTime);
+        auto pKeyframe = std::lower_bound(this->m_vKeyframes.begin(), this->m_vKeyframes.end(), nEnd);
+        if (pKeyframe != this->m_vKeyframes.begin())
+        {
+            this->write_events(*std::prev(pKeyframe), nEnd);
+        }
+        else
+        {
+            ansi::clear_screen();
+            this->write_events(0, nEnd);
+        }
+        std::cout.flush();
+    }
+
+    void ansi_replay::play(double dSpeed, double dFrom, double dTo) const
+    {
+        if (!(dSpeed > 0))
+            throw std::invalid_argument("The replay speed must be positive.");
+
+        this->seek(dFrom);
+        auto oStart = std::chrono::steady_clock::now();
+        for (std::size_t nEvent = this->find_event(dFrom); nEvent < this->m_vEvents.size() && this->m_vEvents[nEvent].m_dTime <= dTo; ++nEvent)
+        {
+            double dDelay = (this->m_vEvents[nEvent].m_dTime - dFrom) / dSpeed;
+            std::this_thread::sleep_until(oStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(dDelay)));
+            this->write_events(nEvent, nEvent + 1);
+            std::cout.flush();
+        }
+    }
+
+    std::size_t ansi_replay::find_event(double dTime) const
+    {
+        auto pEvent = std::upper_bound(this->m_vEvents.begin(), this->m_vEvents.end(), dTime, [](double dValue, const replay_event &oEvent)
+                                       { return dValue < oEvent.m_dTime; });
+        return static_cast<std::size_t>(pEvent - this->m_vEvents.begin());
+    }
+
+    void ansi_replay::write_events(std::size_t nFirst, std::size_t nEnd) const
+    {
+        // The output of consecutive events is contiguous
+        if (nFirst < nEnd)
+        {
+            std::size_t nOffset = this->m_vEvents[nFirst].m_nOffset;
+            std::size_t nSize = this->m_vEvents[nEnd - 1].m_nOffset + this->m_vEvents[nEnd - 1].m_nSize - nOffset;
+            std::cout.write(this->m_sOutput.data() + nOffset, static_cast<std::streamsize>(nSize));
+        }
+        ansi::forget_ansi_cursor();
+    }
+
+    ansi_replay_handler::ansi_replay_handler(ansi_replay *pReplay, const std::string &sPath)
+        : m_pReplay(pReplay),
+          m_sPath(sPath),
+          m_nDepth(0),
+          m_nValues(0),
+          m_nElement(0),
+          m_nVersion(0),
+          m_dTime(0),
+          m_bKeyframe(false) {}
+
+    void ansi_replay_handler::on_start_object()
+    {
+        if (this->m_nDepth++ == 0 && this->m_nValues > 0)
+            this->fail("unexpected object");
+    }
+
+    void ansi_replay_handler::on_end_object()
+    {
+        if (--this->m_nDepth > 0)
+            return;
+        if (this->m_nVersion != 2)
+            this->fail("not an asciicast v2 header");
+        ++this->m_nValues;
+    }
+
+    void ansi_replay_handler::on_start_array()
+    {
+        if (this->m_nDepth++ > 0)
+            return;
+        if (this->m_nValues == 0)
+            this->fail("missing header");
+        this->m_nElement = 0;
+        this->m_sType.clear();
+        this->m_sData.clear();
+    }
+
+    void ansi_replay_handler::on_end_array()
+    {
+        if (--this->m_nDepth > 0)
+            return;
+        ++this->m_nValues;
+
+        // Output events, keyframes marked by the event before them
+        if (this->m_sType == "m" && this->m_sData == "keyframe")
+        {
+            this->m_bKeyframe = true;
+        }
+        else if (this->m_sType == "o")
+        {
+            std::vector<ansi_replay::replay_event> &vEvents = this->m_pReplay->m_vEvents;
+            double dTime = vEvents.empty() ? this->m_dTime : std::max(this->m_dTime, vEvents.back().m_dTime);
+            if (std::exchange(this->m_bKeyframe, false))
+                this->m_pReplay->m_vKeyframes.push_back(vEvents.size());
+            vEvents.push_back(ansi_replay::replay_event{dTime, this->m_pReplay->m_sOutput.size(), this->m_sData.size()});
+            this->m_pReplay->m_sOutput += this->m_sData;
+        }
+    }
+
+    void ansi_replay_handler::on_key(std::string_view sKey)
+    {
+        this->m_sKey = sKey;
+    }
+
+    void ansi_replay_handler::on_value(json_type nType, std::string_view sValue)
+    {
+        if (this->m_nDepth != 1)
+            return;
+
+        // Header: {"version": 2, "width": w, "height": h, ...}
+        if (this->m_nValues == 0)
+        {
+            std::size_t nValue = 0;
+            if (nType == json_type::NUMBER)
+                std::from_chars(sValue.data(), sValue.data() + sValue.size(), nValue);
+            if (this->m_sKey == "version")
+                this->m_nVersion = nValue;
+            else if (this->m_sKey == "width")
+                this->m_pReplay->m_nWidth = nValue;
+            else if (this->m_sKey == "height")
+                this->m_pReplay->m_nHeight = nValue;
+            return;
+        }
+
+        // Event: [time, type, data]
+        switch (this->m_nElement++)
+        {
+        case 0:
+            if (nType != json_type::NUMBER || std::from_chars(sValue.data(), sValue.data() + sValue.size(), this->m_dTime).ec != std::errc())
+                this->fail("invalid event time");
+            break;
+        case 1:
+            this->m_sType = sValue;
+            break;
+        case 2:
+            this->m_sData = sValue;
+            break;
+        default:
+            break;
+        }
+    }
+
+    void ansi_replay_handler::fail(const std::string &sMessage) const
+    {
+        throw std::runtime_error("Invalid recording \'" + this->m_sPath + "\': " + sMessage + ".");
+    }
+
+} // namespace ac
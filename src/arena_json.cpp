@@ -0,0 +1,380 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+#include "arena_json.h"
+
+#include "unicode.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ac
+{
+
+    /// Maximum nesting depth accepted by the parser.
+    static constexpr std::size_t MAX_JSON_DEPTH = 512;
+
+    arena_json_item::arena_json_item()
+        : m_nType(json_type::NUL),
+          m_nChildren(0),
+          m_nSkip(1) {}
+
+    const arena_json_item *arena_json_item::find(std::string_view sKey) const
+    {
+        if (this->m_nType != json_type::OBJECT)
+            return nullptr;
+
+        for (const arena_json_item &oChild : *this)
+        {
+            if (oChild.m_sKey == sKey)
+                return &oChild;
+        }
+
+        return nullptr;
+    }
+
+    const json_item *arena_json_item::get_item(const std::string &sKey) const
+    {
+        const arena_json_item *pItem = this->find(sKey);
+        if (pItem == nullptr || pItem->m_nType != json_type::OBJECT)
+            throw std::runtime_error("Json item with key \'" + sKey + "\' not found.");
+        return pItem;
+    }
+
+    std::string_view arena_json_item::get_string_view(std::string_view sKey) const
+    {
+        const arena_json_item *pItem = this->find(sKey);
+        if (pItem == nullptr || pItem->m_nType != json_type::STRING)
+            throw std::runtime_error("String with key \'" + std::string(sKey) + "\' not found.");
+        return pItem->m_sValue;
+    }
+
+    std::string arena_json_item::get_string(const std::string &sKey) const
+    {
+        return std::string(this->get_string_view(sKey));
+    }
+
+    std::vector<const json_item *> arena_json_item::get_array(const std::string &sKey) const
+    {
+        const arena_json_item *pItem = this->find(sKey);
+        if (pItem == nullptr || pItem->m_nType != json_type::ARRAY)
+            throw std::runtime_error("Json item with key \'" + sKey + "\' not found.");
+
+        std::vector<const json_item *> vItems;
+        vItems.reserve(pItem->m_nChildren);
+        for (const arena_json_item &oChild : *pItem)
+            vItems.push_back(&oChild);
+        return vItems;
+    }
+
+    arena_json_document::arena_json_document(std::string sText)
+        : m_sBuffer(std::move(sText)),
+          m_nItems(0)
+    {
+        this->parse();
+    }
+
+    arena_json_document::arena_json_document(std::istream &oIstream)
+        : m_nItems(0)
+    {
+        // Read the whole stream in big chunks
+        constexpr std::size_t nChunk = 64 * 1024;
+        std::size_t nSize = 0;
+        do
+        {
+            this->m_sBuffer.resize(nSize + nChunk);
+            oIstream.read(this->m_sBuffer.data() + nSize, nChunk);
+            nSize += static_cast<std::size_t>(oIstream.gcount());
+        } while (oIstream);
+        this->m_sBuffer.resize(nSize);
+
+        this->parse();
+    }
+
+    const arena_json_item *arena_json_document::get_root() const noexcept
+    {
+        return this->m_pItems.get();
+    }
+
+    std::size_t arena_json_document::get_item_count() const noexcept
+    {
+        return this->m_nItems;
+    }
+
+    void arena_json_document::parse()
+    {
+        // Every value but the first one is preceded by one of these, so the arena is allocated once
+        std::size_t nItems = 1;
+        for (char c : this->m_sBuffer)
+            nItems += (c == ',') | (c == '[') | (c == '{');
+        this->m_pItems.reset(new arena_json_item[nItems]);
+
+        // The buffer is null-terminated, which stops the parser at the end
+        char *pCursor = this->m_sBuffer.data();
+        this->skip_whitespace(pCursor);
+        this->parse_value(pCursor, std::string_view(), 0);
+        this->skip_whitespace(pCursor);
+        if (pCursor != this->m_sBuffer.data() + this->m_sBuffer.size())
+            this->fail(pCursor, "unexpected trailing data");
+    }
+
+    std::size_t arena_json_document::add_item(json_type nType, std::string_view sKey, std::string_view sValue)
+    {
+        arena_json_item &oItem = this->m_pItems[this->m_nItems];
+        oItem.m_nType = nType;
+        oItem.m_sKey = sKey;
+        oItem.m_sValue = sValue;
+        return this->m_nItems++;
+    }
+
+    void arena_json_document::parse_value(char *&pCursor, std::string_view sKey, std::size_t nDepth)
+    {
+        if (nDepth > MAX_JSON_DEPTH)
+            this->fail(pCursor, "nesting too deep");
+
+        switch (*pCursor)
+        {
+        case '{':
+        case '[':
+        {
+            bool bObject = *pCursor == '{';
+            char cClose = bObject ? '}' : ']';
+            std::size_t nIndex = this->add_item(bObject ? json_type::OBJECT : json_type::ARRAY, sKey, std::string_view());
+
+            ++pCursor;
+            this->skip_whitespace(pCursor);
+            std::uint32_t nChildren = 0;
+            if (*pCursor != cClose)
+            {
+                while (true)
+                {
+                    std::string_view sChildKey;
+                    if (bObject)
+                    {
+                        if (*pCursor != '\"')
+                            this->fail(pCursor, "expected a key");
+                        ++pCursor;
+                        sChildKey = this->parse_string(pCursor);
+                        this->skip_whitespace(pCursor);
+                        if (*pCursor != ':')
+                            this->fail(pCursor, "expected \':\'");
+                        ++pCursor;
+                        this->skip_whitespace(pCursor);
+                    }
+
+                    this->parse_value(pCursor, sChildKey, nDepth + 1);
+                    ++nChildren;
+                    this->skip_whitespace(pCursor);
+
+                    if (*pCursor == ',')
+                    {
+                        ++pCursor;
+                        this->skip_whitespace(pCursor);
+                    }
+                    else if (*pCursor == cClose)
+                    {
+                        break;
+                    }
+                    else
+                    {
+                        this->fail(pCursor, bObject ? "expected \',\' or \'}\'" : "expected \',\' or \']\'");
+                    }
+                }
+            }
+            ++pCursor;
+
+            arena_json_item &oItem = this->m_pItems[nIndex];
+            oItem.m_nChildren = nChildren;
+            oItem.m_nSkip = static_cast<std::uint32_t>(this->m_nItems - nIndex);
+            return;
+        }
+        case '\"':
+        {
+            ++pCursor;
+            std::string_view sValue = this->parse_string(pCursor);
+            this->add_item(json_type::STRING, sKey, sValue);
+            return;
+        }
+        case 't':
+        case 'f':
+        case 'n':
+        {
+            std::string_view sRest(pCursor, this->m_sBuffer.data() + this->m_sBuffer.size() - pCursor);
+            for (std::string_view sLiteral : {std::string_view("true"), std::string_view("false"), std::string_view("null")})
+            {
+                if (sRest.substr(0, sLiteral.size()) == sLiteral)
+                {
+                    json_type nType = sLiteral[0] == 'n' ? json_type::NUL : json_type::BOOLEAN;
+                    this->add_item(nType, sKey, std::string_view(pCursor, sLiteral.size()));
+                    pCursor += sLiteral.size();
+                    return;
+                }
+            }
+            this->fail(pCursor, "invalid literal");
+        }
+        default:
+        {
+            // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+            char *pStart = pCursor;
+            auto is_digit = [](char c)
+            { return c >= '0' && c <= '9'; };
+
+            if (*pCursor == '-')
+                ++pCursor;
+            if (*pCursor == '0')
+                ++pCursor;
+            else if (is_digit(*pCursor))
+                while (is_digit(*pCursor))
+                    ++pCursor;
+            else
+                this->fail(pStart, "invalid value");
+
+            if (*pCursor == '.')
+            {
+                ++pCursor;
+                if (!is_digit(*pCursor))
+                    this->fail(pCursor, "invalid number");
+                while (is_digit(*pCursor))
+                    ++pCursor;
+            }
+            if (*pCursor == 'e' || *pCursor == 'E')
+            {
+                ++pCursor;
+                if (*pCursor == '+' || *pCursor == '-')
+                    ++pCursor;
+                if (!is_digit(*pCursor))
+                    this->fail(pCursor, "invalid number");
+                while (is_digit(*pCursor))
+                    ++pCursor;
+            }
+
+            this->add_item(json_type::NUMBER, sKey, std::string_view(pStart, pCursor - pStart));
+            return;
+        }
+        }
+    }
+
+    std::string_view arena_json_document::parse_string(char *&pCursor)
+    {
+        char *pStart = pCursor;
+
+        // Fast path: strings without escapes stay where they are
+        char *pRead = pCursor;
+        while (*pRead != '\"' && *pRead != '\\' && static_cast<unsigned char>(*pRead) >= 0x20)
+            ++pRead;
+
+        char *pWrite = pRead;
+        while (*pRead != '\"')
+        {
+            unsigned char c = static_cast<unsigned char>(*pRead);
+            if (c < 0x20)
+                this->fail(pRead, *pRead == '\0' ? "unterminated string" : "control character in string");
+
+            if (c != '\\')
+            {
+                *pWrite++ = *pRead++;
+                continue;
+            }
+
+            ++pRead;
+            switch (*pRead)
+            {
+            case '\"':
+                *pWrite++ = '\"';
+                break;
+            case '\\':
+                *pWrite++ = '\\';
+                break;
+            case '/':
+                *pWrite++ = '/';
+                break;
+            case 'b':
+                *pWrite++ = '\b';
+                break;
+            case 'f':
+                *pWrite++ = '\f';
+                break;
+            case 'n':
+                *pWrite++ = '\n';
+                break;
+            case 'r':
+                *pWrite++ = '\r';
+                break;
+            case 't':
+                *pWrite++ = '\t';
+                break;
+            case 'u':
+            {
+                // The encoded form is never shorter than its UTF-8 form, so writing in situ is safe
+                auto read_hex4 = [this](char *pHex)
+                {
+                    std::uint32_t nValue = 0;
+                    for (std::size_t nPos = 0; nPos < 4; ++nPos)
+                    {
+                        int nDigit = get_json_hex_digit(pHex[nPos]);
+                        if (nDigit < 0)
+                            this->fail(pHex + nPos, "invalid unicode escape");
+                        nValue = (nValue << 4) | static_cast<std::uint32_t>(nDigit);
+                    }
+                    return nValue;
+                };
+
+                std::uint32_t nCodePoint = read_hex4(pRead + 1);
+                pRead += 4;
+                if (nCodePoint >= 0xD800 && nCodePoint <= 0xDBFF)
+                {
+                    if (pRead[1] != '\\' || pRead[2] != 'u')
+                        this->fail(pRead, "unpaired surrogate");
+                    std::uint32_t nLow = read_hex4(pRead + 3);
+                    if (nLow < 0xDC00 || nLow > 0xDFFF)
+                        this->fail(pRead, "unpaired surrogate");
+                    nCodePoint = 0x10000 + ((nCodePoint - 0xD800) << 10) + (nLow - 0xDC00);
+                    pRead += 6;
+                }
+                else if (nCodePoint >= 0xDC00 && nCodePoint <= 0xDFFF)
+                {
+                    this->fail(pRead, "unpaired surrogate");
+                }
+                pWrite += unicode::encode_utf8(nCodePoint, pWrite);
+                break;
+            }
+            default:
+                this->fail(pRead, "invalid escape");
+            }
+            ++pRead;
+        }
+
+        pCursor = pRead + 1;
+        return std::string_view(pStart, pWrite - pStart);
+    }
+
+    void arena_json_document::skip_whitespace(char *&pCursor) const noexcept
+    {
+        while (*pCursor == ' ' || *pCursor == '\n' || *pCursor == '\r' || *pCursor == '\t')
+            ++pCursor;
+    }
+
+    void arena_json_document::fail(const char *pCursor, const char *sMessage) const
+    {
+        std::size_t nOffset = pCursor - this->m_sBuffer.data();
+        throw std::runtime_error("Invalid json at offset " + std::to_string(nOffset) + ": " + sMessage + ".");
+    }
+
+} // namespace ac
@@ -0,0 +1,91 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+#include "binary.h"
+
+namespace ac
+{
+
+    void write_varint(std::string &sBuffer, std::uint64_t nValue)
+    {
+        char aBytes[10];
+        std::size_t nSize = 0;
+        while (nValue >= 0x80)
+        {
+            aBytes[nSize++] = static_cast<char>((nValue & 0x7F) | 0x80);
+            nValue >>= 7;
+        }
+        aBytes[nSize++] = static_cast<char>(nValue);
+        sBuffer.append(aBytes, nSize);
+    }
+
+    bool read_varint(const char *&pData, const char *pEnd, std::uint64_t &nValue)
+    {
+        const char *pCursor = pData;
+        std::uint64_t nResult = 0;
+        for (unsigned nShift = 0; nShift < 64 && pCursor != pEnd; nShift += 7)
+        {
+            // The 10th byte only holds the 64th bit
+            unsigned char c = static_cast<unsigned char>(*pCursor++);
+            if (nShift == 63 && c > 1)
+                return false;
+            nResult |= static_cast<std::uint64_t>(c & 0x7F) << nShift;
+            if ((c & 0x80) == 0)
+            {
+                pData = pCursor;
+                nValue = nResult;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void write_fixed32(std::string &sBuffer, std::uint32_t nValue)
+    {
+        char aBytes[4];
+        for (std::size_t nByte = 0; nByte < 4; ++nByte)
+            aBytes[nByte] = static_cast<char>(nValue >> (8 * nByte));
+        sBuffer.append(aBytes, 4);
+    }
+
+    void write_fixed64(std::string &sBuffer, std::uint64_t nValue)
+    {
+        char aBytes[8];
+        for (std::size_t nByte = 0; nByte < 8; ++nByte)
+            aBytes[nByte] = static_cast<char>(nValue >> (8 * nByte));
+        sBuffer.append(aBytes, 8);
+    }
+
+    std::uint32_t read_fixed32(const char *pData) noexcept
+    {
+        std::uint32_t nValue = 0;
+        for (std::size_t nByte = 0; nByte < 4; ++nByte)
+            nValue |= static_cast<std::uint32_t>(static_cast<unsigned char>(pData[nByte])) << (8 * nByte);
+        return nValue;
+    }
+
+    std::uint64_t read_fixed64(const char *pData) noexcept
+    {
+        std::uint64_t nValue = 0;
+        for (std::size_t nByte = 0; nByte < 8; ++nByte)
+            nValue |= static_cast<std::uint64_t>(static_cast<unsigned char>(pData[nByte])) << (8 * nByte);
+        return nValue;
+    }
+
+} // namespace ac
@@ -0,0 +1,218 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+
+#include "card_animator.h"
+#include "card_table.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace ac
+{
+
+    static inline double ease(easing nEasing, double dProgress);
+    static inline std::size_t interpolate(std::size_t nFrom, std::size_t nTo, double dProgress);
+
+    card_animator::card_animator(card_table *pTable, std::size_t nFrameRate)
+        : m_pTable(pTable),
+          m_nFrameRate(nFrameRate > 0 ? nFrameRate : DEFAULT_FRAME_RATE)
+    {
+        if (pTable == nullptr)
+            throw std::invalid_argument("The animated table can not be nullptr.");
+    }
+
+    std::size_t card_animator::get_frame_rate() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return this->m_nFrameRate;
+    }
+
+    void card_animator::set_frame_rate(std::size_t nFrameRate)
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        this->m_nFrameRate = nFrameRate > 0 ? nFrameRate : DEFAULT_FRAME_RATE;
+    }
+
+    bool card_animator::is_running() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return !this->m_vTweens.empty();
+    }
+
+    void card_animator::animate(const number *pCard, point oTarget, clock::duration oDuration, easing nEasing, clock::duration oDelay)
+    {
+        // Start from where the card is
+        point oFrom = this->m_pTable->get_card_horizontal_position(pCard);
+        if (oFrom == YOUR_IMAGINATION)
+            return;
+
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        this->add_unlocked({pCard, oFrom, oTarget, oFrom, clock::now() + oDelay, oDuration, nEasing});
+    }
+
+    void card_animator::animate(std::span<const number *const> vCards, std::span<const point> vTargets, clock::duration oDuration, clock::duration oStagger, easing nEasing)
+    {
+        if (vCards.size() != vTargets.size())
+            throw std::invalid_argument("There must be one target per card.");
+
+        // Look up the starting positions in a single scan
+        std::unordered_map<const number *, point> mPositions;
+        for (const auto &oHolder : this->m_pTable->get_holders())
+            mPositions.try_emplace(oHolder.m_pCard, oHolder.m_oPos);
+
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        clock::time_point oStart = clock::now();
+        for (std::size_t nCard = 0; nCard < vCards.size(); ++nCard)
+        {
+            auto pIt = mPositions.find(vCards[nCard]);
+            if (vCards[nCard] == nullptr || pIt == mPositions.end())
+                continue;
+            this->add_unlocked({vCards[nCard], pIt->second, vTargets[nCard], pIt->second, oStart + oStagger * static_cast<clock::rep>(nCard), oDuration, nEasing});
+        }
+    }
+
+    void card_animator::cancel(const number *pCard)
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        std::erase_if(this->m_vTweens, [pCard](const tween &oTween)
+                      { return oTween.m_pCard == pCard; });
+    }
+
+    void card_animator::cancel_all()
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        this->m_vTweens.clear();
+    }
+
+    void card_animator::finish()
+    {
+        std::vector<const number *> vCards;
+        std::vector<point> vPositions;
+        {
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            vCards.reserve(this->m_vTweens.size());
+            vPositions.reserve(this->m_vTweens.size());
+            for (const auto &oTween : this->m_vTweens)
+            {
+                vCards.push_back(oTween.m_pCard);
+                vPositions.push_back(oTween.m_oTo);
+            }
+            this->m_vTweens.clear();
+        }
+
+        // The table is updated without holding the animator, so that observers may animate
+        if (!vCards.empty())
+            this->m_pTable->move_cards(vCards, vPositions);
+    }
+
+    bool card_animator::tick(clock::time_point oNow)
+    {
+        std::vector<const number *> vCards;
+        std::vector<point> vPositions;
+        bool bRunning;
+        {
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+            // Interpolate every card, keeping only the positions that changed
+            for (auto &oTween : this->m_vTweens)
+            {
+                if (oNow < oTween.m_oStart)
+                    continue;
+
+                double dProgress = 1;
+                if (oTween.m_oDuration > clock::duration::zero())
+                    dProgress = std::min(std::chrono::duration<double>(oNow - oTween.m_oStart) / oTween.m_oDuration, 1.0);
+                double dEased = ease(oTween.m_nEasing, dProgress);
+
+                point oPos = dProgress >= 1 ? oTween.m_oTo : point(interpolate(oTween.m_oFrom.get_x(), oTween.m_oTo.get_x(), dEased), interpolate(oTween.m_oFrom.get_y(), oTween.m_oTo.get_y(), dEased));
+                if (oPos != oTween.m_oLast)
+                {
+                    vCards.push_back(oTween.m_pCard);
+                    vPositions.push_back(oPos);
+                    oTween.m_oLast = oPos;
+                }
+            }
+
+            // Drop the finished animations
+            std::erase_if(this->m_vTweens, [oNow](const tween &oTween)
+                          { return oNow >= oTween.m_oStart + oTween.m_oDuration; });
+            bRunning = !this->m_vTweens.empty();
+        }
+
+        // One table update per frame
+        if (!vCards.empty())
+            this->m_pTable->move_cards(vCards, vPositions);
+        return bRunning;
+    }
+
+    void card_animator::run()
+    {
+        clock::time_point oNext = clock::now();
+        while (this->tick(clock::now()))
+        {
+            // Pace to the frame rate; a late frame restarts the pace instead of catching up
+            oNext += std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1)) / this->get_frame_rate();
+            oNext = std::max(oNext, clock::now());
+            std::this_thread::sleep_until(oNext);
+        }
+    }
+
+    void card_animator::add_unlocked(const tween &oTween)
+    {
+        auto pIt = std::find_if(this->m_vTweens.begin(), this->m_vTweens.end(), [&oTween](const tween &oOther)
+                                { return oOther.m_pCard == oTween.m_pCard; });
+        if (pIt == this->m_vTweens.end())
+        {
+            this->m_vTweens.push_back(oTween);
+            return;
+        }
+
+        // Continue from the last applied position of the replaced animation
+        tween oReplacement = oTween;
+        oReplacement.m_oFrom = pIt->m_oLast;
+        oReplacement.m_oLast = pIt->m_oLast;
+        *pIt = oReplacement;
+    }
+
+    double ease(easing nEasing, double dProgress)
+    {
+        switch (nEasing)
+        {
+        case easing::EASE_IN:
+            return dProgress * dProgress;
+        case easing::EASE_OUT:
+            return 1 - (1 - dProgress) * (1 - dProgress);
+        case easing::EASE_IN_OUT:
+            return dProgress < 0.5 ? 2 * dProgress * dProgress : 1 - 2 * (1 - dProgress) * (1 - dProgress);
+        default:
+            return dProgress;
+        }
+    }
+
+    std::size_t interpolate(std::size_t nFrom, std::size_t nTo, double dProgress)
+    {
+        double dFrom = static_cast<double>(nFrom);
+        return static_cast<std::size_t>(std::lround(dFrom + (static_cast<double>(nTo) - dFrom) * dProgress));
+    }
+
+} // namespace ac
@@ -0,0 +1,299 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+#include "card_archive.h"
+
+#include "arena_json.h"
+#include "binary.h"
+#include "card_index.h"
+#include "card_table.h"
+#include "deck.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ac
+{
+
+    /// Magic of the archives.
+    static constexpr std::string_view ARCHIVE_MAGIC = "ACAR";
+
+    /// Version of the archives.
+    static constexpr std::uint32_t ARCHIVE_VERSION = 1;
+
+    /// Size of the archive header.
+    static constexpr std::size_t ARCHIVE_HEADER_SIZE = 20;
+
+    /// Size of an index record: kind, deck, name size, reserved (4 bytes each),
+    /// name offset, payload offset, payload size (8 bytes each).
+    static constexpr std::size_t ARCHIVE_RECORD_SIZE = 40;
+
+    std::uint32_t card_archive_writer::add_deck(const std::string &sName, const deck *pDeck)
+    {
+        if (pDeck == nullptr)
+            throw std::invalid_argument("The deck of an archive entry can not be null.");
+
+        std::size_t nOffset = this->m_sPayloads.size();
+        pDeck->to_json(this->m_sPayloads);
+        this->m_vEntries.push_back({archive_entry::DECK, UINT32_MAX, sName, nOffset, this->m_sPayloads.size() - nOffset});
+        return static_cast<std::uint32_t>(this->m_vEntries.size() - 1);
+    }
+
+    std::uint32_t card_archive_writer::add_table(const std::string &sName, std::uint32_t nDeckEntry, const card_table *pTable, const card_index &oIndex)
+    {
+        if (pTable == nullptr)
+            throw std::invalid_argument("The table of an archive entry can not be null.");
+        if (nDeckEntry >= this->m_vEntries.size() || this->m_vEntries[nDeckEntry].m_nKind != archive_entry::DECK)
+            throw std::invalid_argument("Archive entry " + std::to_string(nDeckEntry) + " is not a deck.");
+
+        std::size_t nOffset = this->m_sPayloads.size();
+        pTable->save_snapshot(this->m_sPayloads, oIndex);
+        this->m_vEntries.push_back({archive_entry::TABLE, nDeckEntry, sName, nOffset, this->m_sPayloads.size() - nOffset});
+        return static_cast<std::uint32_t>(this->m_vEntries.size() - 1);
+    }
+
+    void card_archive_writer::write(std::string &sBuffer) const
+    {
+        std::size_t nStart = sBuffer.size();
+        std::size_t nPayloads = ARCHIVE_HEADER_SIZE;
+        std::size_t nNames = nPayloads + this->m_sPayloads.size();
+        std::size_t nIndex = nNames;
+        for (const entry &oEntry : this->m_vEntries)
+            nIndex += oEntry.m_sName.size();
+        sBuffer.reserve(nStart + nIndex + this->m_vEntries.size() * ARCHIVE_RECORD_SIZE);
+
+        // Header
+        sBuffer.append(ARCHIVE_MAGIC);
+        write_fixed32(sBuffer, ARCHIVE_VERSION);
+        write_fixed32(sBuffer, static_cast<std::uint32_t>(this->m_vEntries.size()));
+        write_fixed64(sBuffer, nIndex);
+
+        // Payloads and names
+        sBuffer.append(this->m_sPayloads);
+        for (const entry &oEntry : this->m_vEntries)
+            sBuffer.append(oEntry.m_sName);
+
+        // Index
+        std::size_t nName = nNames;
+        for (const entry &oEntry : this->m_vEntries)
+        {
+            write_fixed32(sBuffer, static_cast<std::uint32_t>(oEntry.m_nKind));
+            write_fixed32(sBuffer, oEntry.m_nDeck);
+            write_fixed32(sBuffer, static_cast<std::uint32_t>(oEntry.m_sName.size()));
+            write_fixed32(sBuffer, 0);
+            write_fixed64(sBuffer, nName);
+            write_fixed64(sBuffer, nPayloads + oEntry.m_nOffset);
+            write_fixed64(sBuffer, oEntry.m_nSize);
+            nName += oEntry.m_sName.size();
+        }
+    }
+
+    void card_archive_writer::write(const std::string &sPath) const
+    {
+        std::string sBuffer;
+        this->write(sBuffer);
+
+        std::ofstream oOfstream(sPath, std::ios::binary | std::ios::trunc);
+        oOfstream.write(sBuffer.data(), sBuffer.size());
+        oOfstream.close();
+        if (!oOfstream)
+            throw std::runtime_error("Unable to write archive \'" + sPath + "\'.");
+    }
+
+    card_archive::card_archive(const std::string &sPath)
+        : m_pData(nullptr),
+          m_nSize(0),
+          m_nEntries(0),
+          m_pIndex(nullptr)
+    {
+#ifdef _WIN32
+        // Read the whole file
+        std::ifstream oIfstream(sPath, std::ios::binary | std::ios::ate);
+        if (!oIfstream)
+            throw std::runtime_error("Unable to open archive \'" + sPath + "\'.");
+        this->m_vFallback.resize(static_cast<std::size_t>(oIfstream.tellg()));
+        oIfstream.seekg(0);
+        oIfstream.read(this->m_vFallback.data(), this->m_vFallback.size());
+        if (!oIfstream)
+            throw std::runtime_error("Unable to read archive \'" + sPath + "\'.");
+        this->m_pData = this->m_vFallback.data();
+        this->m_nSize = this->m_vFallback.size();
+#else
+        // Map the whole file, the descriptor is not needed afterwards
+        int nFd = ::open(sPath.c_str(), O_RDONLY);
+        if (nFd < 0)
+            throw std::runtime_error("Unable to open archive \'" + sPath + "\'.");
+        struct stat oStat;
+        if (::fstat(nFd, &oStat) != 0)
+        {
+            ::close(nFd);
+            throw std::runtime_error("Unable to read archive \'" + sPath + "\'.");
+        }
+        this->m_nSize = static_cast<std::size_t>(oStat.st_size);
+        if (this->m_nSize > 0)
+        {
+            void *pMap = ::mmap(nullptr, this->m_nSize, PROT_READ, MAP_PRIVATE, nFd, 0);
+            if (pMap == MAP_FAILED)
+            {
+                ::close(nFd);
+                throw std::runtime_error("Unable to map archive \'" + sPath + "\'.");
+            }
+            this->m_pData = static_cast<const char *>(pMap);
+        }
+        ::close(nFd);
+#endif
+
+        try
+        {
+            this->open_index();
+        }
+        catch (...)
+        {
+#ifndef _WIN32
+            if (this->m_pData != nullptr)
+                ::munmap(const_cast<char *>(this->m_pData), this->m_nSize);
+#endif
+            throw;
+        }
+    }
+
+    card_archive::~card_archive()
+    {
+#ifndef _WIN32
+        if (this->m_pData != nullptr)
+            ::munmap(const_cast<char *>(this->m_pData), this->m_nSize);
+#endif
+    }
+
+    void card_archive::open_index()
+    {
+        auto fail = [](const char *sMessage)
+        {
+            throw std::runtime_error(std::string("Invalid archive: ") + sMessage + ".");
+        };
+
+        // Header
+        if (this->m_nSize < ARCHIVE_HEADER_SIZE || std::string_view(this->m_pData, ARCHIVE_MAGIC.size()) != ARCHIVE_MAGIC)
+            fail("bad magic");
+        if (read_fixed32(this->m_pData + 4) != ARCHIVE_VERSION)
+            fail("unsupported version");
+        this->m_nEntries = read_fixed32(this->m_pData + 8);
+        std::uint64_t nIndex = read_fixed64(this->m_pData + 12);
+        if (nIndex > this->m_nSize || (this->m_nSize - nIndex) / ARCHIVE_RECORD_SIZE < this->m_nEntries)
+            fail("truncated index");
+        this->m_pIndex = this->m_pData + nIndex;
+
+        // Records: check the ranges once, so that lookups do not need to
+        auto in_range = [this](std::uint64_t nOffset, std::uint64_t nSize)
+        {
+            return nOffset <= this->m_nSize && nSize <= this->m_nSize - nOffset;
+        };
+        this->m_mNames.reserve(this->m_nEntries);
+        for (std::uint32_t nEntry = 0; nEntry < this->m_nEntries; ++nEntry)
+        {
+            const char *pRecord = this->m_pIndex + nEntry * ARCHIVE_RECORD_SIZE;
+            std::uint32_t nKind = read_fixed32(pRecord);
+            std::uint32_t nDeck = read_fixed32(pRecord + 4);
+            std::uint32_t nNameSize = read_fixed32(pRecord + 8);
+            std::uint64_t nName = read_fixed64(pRecord + 16);
+            if (nKind != static_cast<std::uint32_t>(archive_entry::DECK) && nKind != static_cast<std::uint32_t>(archive_entry::TABLE))
+                fail("unknown entry kind");
+            if (nKind == static_cast<std::uint32_t>(archive_entry::TABLE) &&
+                (nDeck >= this->m_nEntries || read_fixed32(this->m_pIndex + nDeck * ARCHIVE_RECORD_SIZE) != static_cast<std::uint32_t>(archive_entry::DECK)))
+                fail("table entry without deck");
+            if (!in_range(nName, nNameSize) || !in_range(read_fixed64(pRecord + 24), read_fixed64(pRecord + 32)))
+                fail("entry out of range");
+
+            // Keep the first entry of every name
+            this->m_mNames.emplace(std::string_view(this->m_pData + nName, nNameSize), nEntry);
+        }
+    }
+
+    const char *card_archive::get_record(std::uint32_t nEntry) const
+    {
+        if (nEntry >= this->m_nEntries)
+            throw std::out_of_range("Archive entry " + std::to_string(nEntry) + " does not exist.");
+        return this->m_pIndex + nEntry * ARCHIVE_RECORD_SIZE;
+    }
+
+    std::uint32_t card_archive::get_entry_count() const noexcept
+    {
+        return this->m_nEntries;
+    }
+
+    std::uint32_t card_archive::find(std::string_view sName) const
+    {
+        auto pIt = this->m_mNames.find(sName);
+        return pIt != this->m_mNames.cend() ? pIt->second : NOT_FOUND;
+    }
+
+    archive_entry card_archive::get_kind(std::uint32_t nEntry) const
+    {
+        return static_cast<archive_entry>(read_fixed32(this->get_record(nEntry)));
+    }
+
+    std::string_view card_archive::get_name(std::uint32_t nEntry) const
+    {
+        const char *pRecord = this->get_record(nEntry);
+        return std::string_view(this->m_pData + read_fixed64(pRecord + 16), read_fixed32(pRecord + 8));
+    }
+
+    std::string_view card_archive::get_data(std::uint32_t nEntry) const
+    {
+        const char *pRecord = this->get_record(nEntry);
+        return std::string_view(this->m_pData + read_fixed64(pRecord + 24), read_fixed64(pRecord + 32));
+    }
+
+    std::uint32_t card_archive::get_table_deck(std::uint32_t nEntry) const
+    {
+        const char *pRecord = this->get_record(nEntry);
+        if (read_fixed32(pRecord) != static_cast<std::uint32_t>(archive_entry::TABLE))
+            throw std::invalid_argument("Archive entry " + std::to_string(nEntry) + " is not a table.");
+        return read_fixed32(pRecord + 4);
+    }
+
+    deck *card_archive::load_deck(std::uint32_t nEntry) const
+    {
+        if (this->get_kind(nEntry) != archive_entry::DECK)
+            throw std::invalid_argument("Archive entry " + std::to_string(nEntry) + " is not a deck.");
+
+        // The document unescapes in situ, so it works on its own copy of this entry only
+        arena_json_document oDocument{std::string(this->get_data(nEntry))};
+        return deck::from_json(oDocument.get_root());
+    }
+
+    void card_archive::load_table(std::uint32_t nEntry, card_table *pTable, const card_index &oIndex) const
+    {
+        if (this->get_kind(nEntry) != archive_entry::TABLE)
+            throw std::invalid_argument("Archive entry " + std::to_string(nEntry) + " is not a table.");
+        if (pTable == nullptr)
+            throw std::invalid_argument("The table to load into can not be null.");
+
+        // Snapshots are read in place, straight from the mapping
+        pTable->load_snapshot(this->get_data(nEntry), oIndex);
+    }
+
+} // namespace ac
@@ -0,0 +1,184 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+#include "card_change.h"
+
+#include <iterator>
+#include <stdexcept>
+
+namespace ac
+{
+
+    static inline std::list<card_holder>::iterator layer_iterator(std::list<card_holder> &lHolders, std::size_t nLayer);
+
+    card_change::card_change(card_change_type nType)
+        : m_nType(nType),
+          m_pCard(nullptr),
+          m_pPreviousCard(nullptr),
+          m_nLayer(0),
+          m_nPreviousLayer(0),
+          m_oPos(YOUR_IMAGINATION),
+          m_oPreviousPos(YOUR_IMAGINATION),
+          m_bVisible(false) {}
+
+    card_change card_change::insert(const number *pCard, std::size_t nLayer, point oPos, bool bVisible)
+    {
+        card_change oChange(card_change_type::INSERT);
+        oChange.m_pCard = pCard;
+        oChange.m_nLayer = nLayer;
+        oChange.m_oPos = oPos;
+        oChange.m_bVisible = bVisible;
+        return oChange;
+    }
+
+    card_change card_change::erase(const number *pCard, std::size_t nLayer, point oPos, bool bVisible)
+    {
+        card_change oChange(card_change_type::ERASE);
+        oChange.m_pCard = pCard;
+        oChange.m_nLayer = nLayer;
+        oChange.m_oPos = oPos;
+        oChange.m_bVisible = bVisible;
+        return oChange;
+    }
+
+    card_change card_change::move(const number *pCard, std::size_t nLayer, point oPreviousPos, point oPos)
+    {
+        card_change oChange(card_change_type::MOVE);
+        oChange.m_pCard = pCard;
+        oChange.m_nLayer = nLayer;
+        oChange.m_oPos = oPos;
+        oChange.m_oPreviousPos = oPreviousPos;
+        return oChange;
+    }
+
+    card_change card_change::restack(const number *pCard, std::size_t nPreviousLayer, std::size_t nLayer)
+    {
+        card_change oChange(card_change_type::RESTACK);
+        oChange.m_pCard = pCard;
+        oChange.m_nLayer = nLayer;
+        oChange.m_nPreviousLayer = nPreviousLayer;
+        return oChange;
+    }
+
+    card_change card_change::replace(std::size_t nLayer, const number *pPreviousCard, const number *pCard)
+    {
+        card_change oChange(card_change_type::REPLACE);
+        oChange.m_pCard = pCard;
+        oChange.m_pPreviousCard = pPreviousCard;
+        oChange.m_nLayer = nLayer;
+        return oChange;
+    }
+
+    card_change card_change::visibility(const number *pCard, std::size_t nLayer, bool bVisible)
+    {
+        card_change oChange(card_change_type::VISIBILITY);
+        oChange.m_pCard = pCard;
+        oChange.m_nLayer = nLayer;
+        oChange.m_bVisible = bVisible;
+        return oChange;
+    }
+
+    card_change card_change::reset()
+    {
+        return card_change(card_change_type::RESET);
+    }
+
+    card_change card_change::get_inverse() const
+    {
+        switch (this->m_nType)
+        {
+        case card_change_type::INSERT:
+            return erase(this->m_pCard, this->m_nLayer, this->m_oPos, this->m_bVisible);
+        case card_change_type::ERASE:
+            return insert(this->m_pCard, this->m_nLayer, this->m_oPos, this->m_bVisible);
+        case card_change_type::MOVE:
+            return move(this->m_pCard, this->m_nLayer, this->m_oPos, this->m_oPreviousPos);
+        case card_change_type::RESTACK:
+            return restack(this->m_pCard, this->m_nLayer, this->m_nPreviousLayer);
+        case card_change_type::REPLACE:
+            return replace(this->m_nLayer, this->m_pCard, this->m_pPreviousCard);
+        case card_change_type::VISIBILITY:
+            return visibility(this->m_pCard, this->m_nLayer, !this->m_bVisible);
+        default:
+            throw std::logic_error("A reset change can not be inverted.");
+        }
+    }
+
+    void card_change::apply(std::list<card_holder> &lHolders) const
+    {
+        auto fail = []()
+        {
+            throw std::invalid_argument("The card change does not match the card holders.");
+        };
+
+        if (this->m_nType == card_change_type::INSERT)
+        {
+            if (this->m_nLayer > lHolders.size())
+                fail();
+            lHolders.emplace(layer_iterator(lHolders, this->m_nLayer), this->m_pCard, this->m_oPos, this->m_bVisible);
+            return;
+        }
+
+        // Every other change acts on an existing layer
+        std::size_t nLayer = this->m_nType == card_change_type::RESTACK ? this->m_nPreviousLayer : this->m_nLayer;
+        const number *pCard = this->m_nType == card_change_type::REPLACE ? this->m_pPreviousCard : this->m_pCard;
+        if (this->m_nType == card_change_type::RESET || nLayer >= lHolders.size())
+            fail();
+        auto pIt = layer_iterator(lHolders, nLayer);
+        if (pIt->m_pCard != pCard)
+            fail();
+
+        switch (this->m_nType)
+        {
+        case card_change_type::ERASE:
+            lHolders.erase(pIt);
+            break;
+        case card_change_type::MOVE:
+            pIt->m_oPos = this->m_oPos;
+            break;
+        case card_change_type::RESTACK:
+        {
+            if (this->m_nLayer >= lHolders.size())
+                fail();
+
+            // The new layer counts the list without the card
+            std::size_t nDestination = this->m_nLayer >= nLayer ? this->m_nLayer + 1 : this->m_nLayer;
+            lHolders.splice(layer_iterator(lHolders, nDestination), lHolders, pIt);
+            break;
+        }
+        case card_change_type::REPLACE:
+            pIt->m_pCard = this->m_pCard;
+            break;
+        case card_change_type::VISIBILITY:
+            pIt->m_bVisible = this->m_bVisible;
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::list<card_holder>::iterator layer_iterator(std::list<card_holder> &lHolders, std::size_t nLayer)
+    {
+        // Walk from the closest end, so that changes near the top of a pile are constant time
+        if (nLayer <= lHolders.size() / 2)
+            return std::next(lHolders.begin(), nLayer);
+        return std::prev(lHolders.end(), lHolders.size() - nLayer);
+    }
+
+} // namespace ac
@@ -0,0 +1,249 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+#include "card_grid.h"
+
+#include <algorithm>
+
+namespace ac
+{
+
+    static inline std::size_t saturated_end(std::size_t nStart, std::size_t nSize);
+
+    card_grid::card_grid(std::size_t nCardWidth, std::size_t nCardHeight)
+        : m_nCardWidth(nCardWidth > 0 ? nCardWidth : 1),
+          m_nCardHeight(nCardHeight > 0 ? nCardHeight : 1),
+          m_nTop(-1),
+          m_nBottom(0),
+          m_bExact(true) {}
+
+    std::size_t card_grid::get_card_width() const noexcept
+    {
+        return this->m_nCardWidth;
+    }
+
+    std::size_t card_grid::get_card_height() const noexcept
+    {
+        return this->m_nCardHeight;
+    }
+
+    void card_grid::rebuild(const std::list<card_holder> &lHolders)
+    {
+        this->m_mCards.clear();
+        this->m_mBuckets.clear();
+        this->m_nTop = -1;
+        this->m_nBottom = 0;
+        this->m_bExact = true;
+
+        for (const auto &oHolder : lHolders)
+        {
+            // A card placed twice is indexed at its upper position
+            auto pIt = this->m_mCards.find(oHolder.m_pCard);
+            if (pIt != this->m_mCards.end())
+            {
+                this->link(oHolder.m_pCard, pIt->second.m_oPos, false);
+                this->m_bExact = false;
+            }
+            this->m_mCards.insert_or_assign(oHolder.m_pCard, entry{oHolder.m_oPos, ++this->m_nTop, oHolder.m_bVisible});
+            this->link(oHolder.m_pCard, oHolder.m_oPos, true);
+        }
+    }
+
+    bool card_grid::update(const card_change &oChange)
+    {
+        if (!this->m_bExact)
+            return false;
+
+        // Insertions only keep the ordering keys at the ends of the stack
+        if (oChange.m_nType == card_change_type::INSERT)
+        {
+            std::int64_t nOrder = 0;
+            if (this->m_mCards.contains(oChange.m_pCard))
+                return false;
+            else if (oChange.m_nLayer == this->m_mCards.size())
+                nOrder = ++this->m_nTop;
+            else if (oChange.m_nLayer == 0)
+                nOrder = --this->m_nBottom;
+            else
+                return false;
+            this->m_mCards.emplace(oChange.m_pCard, entry{oChange.m_oPos, nOrder, oChange.m_bVisible});
+            this->link(oChange.m_pCard, oChange.m_oPos, true);
+            return true;
+        }
+
+        if (oChange.m_nType == card_change_type::REPLACE || oChange.m_nType == card_change_type::RESET)
+            return false;
+
+        // Every other change acts on an indexed card
+        auto pIt = this->m_mCards.find(oChange.m_pCard);
+        if (pIt == this->m_mCards.end())
+            return false;
+        entry &oEntry = pIt->second;
+
+        switch (oChange.m_nType)
+        {
+        case card_change_type::ERASE:
+            this->link(oChange.m_pCard, oEntry.m_oPos, false);
+            this->m_mCards.erase(pIt);
+            return true;
+        case card_change_type::MOVE:
+            this->link(oChange.m_pCard, oEntry.m_oPos, false);
+            oEntry.m_oPos = oChange.m_oPos;
+            this->link(oChange.m_pCard, oEntry.m_oPos, true);
+            return true;
+        case card_change_type::RESTACK:
+            if (oChange.m_nLayer + 1 == this->m_mCards.size())
+                oEntry.m_nOrder = ++this->m_nTop;
+            else if (oChange.m_nLayer == 0)
+                oEntry.m_nOrder = --this->m_nBottom;
+            else
+                return false;
+            return true;
+        case card_change_type::VISIBILITY:
+            oEntry.m_bVisible = oChange.m_bVisible;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    const number *card_grid::get_card_at(const point &oPoint) const
+    {
+        auto pBucket = this->m_mBuckets.find(get_bucket_key(oPoint.get_x() / this->m_nCardWidth, oPoint.get_y() / this->m_nCardHeight));
+        if (pBucket == this->m_mBuckets.end())
+            return nullptr;
+
+        // Keep the upper visible card covering the cell
+        const number *pTopmost = nullptr;
+        std::int64_t nTopmost = 0;
+        for (const number *pCard : pBucket->second)
+        {
+            const entry &oEntry = this->m_mCards.at(pCard);
+            if (!oEntry.m_bVisible || (pTopmost != nullptr && oEntry.m_nOrder <= nTopmost))
+                continue;
+            if (!this->get_card_rect(oEntry.m_oPos).contains(oPoint))
+                continue;
+            pTopmost = pCard;
+            nTopmost = oEntry.m_nOrder;
+        }
+
+        return pTopmost;
+    }
+
+    void card_grid::get_cards_in(const rect &oRect, std::vector<const number *> &vCards) const
+    {
+        vCards.clear();
+        if (oRect.is_empty())
+            return;
+
+        std::vector<std::pair<std::int64_t, const number *>> vFound;
+        auto collect = [this, &oRect, &vFound](const number *pCard, const entry &oEntry)
+        {
+            if (oEntry.m_bVisible && this->get_card_rect(oEntry.m_oPos).intersects(oRect))
+                vFound.emplace_back(oEntry.m_nOrder, pCard);
+        };
+
+        // Look at the buckets under the rectangle, or at every card if they are fewer
+        std::size_t nColumn0 = oRect.get_x() / this->m_nCardWidth;
+        std::size_t nColumn1 = saturated_end(oRect.get_x(), oRect.get_width()) / this->m_nCardWidth;
+        std::size_t nRow0 = oRect.get_y() / this->m_nCardHeight;
+        std::size_t nRow1 = saturated_end(oRect.get_y(), oRect.get_height()) / this->m_nCardHeight;
+        std::size_t nColumns = nColumn1 - nColumn0 + 1;
+        std::size_t nRows = nRow1 - nRow0 + 1;
+        if (nColumns == 0 || nRows == 0 || nColumns > this->m_mCards.size() || nRows > this->m_mCards.size() / nColumns)
+        {
+            for (const auto &oCard : this->m_mCards)
+                collect(oCard.first, oCard.second);
+        }
+        else
+        {
+            for (std::size_t nColumn = nColumn0; nColumn - nColumn0 < nColumns; ++nColumn)
+            {
+                for (std::size_t nRow = nRow0; nRow - nRow0 < nRows; ++nRow)
+                {
+                    auto pBucket = this->m_mBuckets.find(get_bucket_key(nColumn, nRow));
+                    if (pBucket == this->m_mBuckets.end())
+                        continue;
+                    for (const number *pCard : pBucket->second)
+                        collect(pCard, this->m_mCards.at(pCard));
+                }
+            }
+        }
+
+        // Stacking order, a card may be listed in several buckets
+        std::sort(vFound.begin(), vFound.end());
+        vFound.erase(std::unique(vFound.begin(), vFound.end()), vFound.end());
+        vCards.reserve(vFound.size());
+        for (const auto &oFound : vFound)
+            vCards.push_back(oFound.second);
+    }
+
+    rect card_grid::get_card_rect(const point &oPos) const noexcept
+    {
+        return rect(oPos, this->m_nCardWidth, this->m_nCardHeight);
+    }
+
+    std::uint64_t card_grid::get_bucket_key(std::size_t nColumn, std::size_t nRow) noexcept
+    {
+        // Colliding keys only add candidates, which are checked against the card rectangle
+        return (static_cast<std::uint64_t>(nColumn) << 32) ^ static_cast<std::uint64_t>(nRow);
+    }
+
+    void card_grid::link(const number *pCard, const point &oPos, bool bAdd)
+    {
+        std::size_t nColumn0 = oPos.get_x() / this->m_nCardWidth;
+        std::size_t nColumn1 = saturated_end(oPos.get_x(), this->m_nCardWidth) / this->m_nCardWidth;
+        std::size_t nRow0 = oPos.get_y() / this->m_nCardHeight;
+        std::size_t nRow1 = saturated_end(oPos.get_y(), this->m_nCardHeight) / this->m_nCardHeight;
+
+        // A card covers at most two buckets in every direction
+        for (std::size_t nColumn = nColumn0; nColumn >= nColumn0 && nColumn <= nColumn1; ++nColumn)
+        {
+            for (std::size_t nRow = nRow0; nRow >= nRow0 && nRow <= nRow1; ++nRow)
+            {
+                std::uint64_t nKey = get_bucket_key(nColumn, nRow);
+                if (bAdd)
+                {
+                    this->m_mBuckets[nKey].push_back(pCard);
+                    continue;
+                }
+
+                auto pBucket = this->m_mBuckets.find(nKey);
+                if (pBucket == this->m_mBuckets.end())
+                    continue;
+                auto &vBucket = pBucket->second;
+                auto pCardIt = std::find(vBucket.begin(), vBucket.end(), pCard);
+                if (pCardIt != vBucket.end())
+                {
+                    *pCardIt = vBucket.back();
+                    vBucket.pop_back();
+                }
+                if (vBucket.empty())
+                    this->m_mBuckets.erase(pBucket);
+            }
+        }
+    }
+
+    std::size_t saturated_end(std::size_t nStart, std::size_t nSize)
+    {
+        // Last cell of a range, clamped to the largest coordinate
+        return nSize > BEYOND_REACH - nStart ? BEYOND_REACH : nStart + nSize - 1;
+    }
+
+} // namespace ac
@@ -0,0 +1,78 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+#include "card_index.h"
+
+#include "binary.h"
+#include "deck.h"
+
+#include <stdexcept>
+
+namespace ac
+{
+
+    card_index::card_index(const deck *pDeck)
+        : m_pDeck(pDeck),
+          m_nFingerprint(fnv1a_hash(""))
+    {
+        if (pDeck == nullptr)
+            throw std::invalid_argument("The deck of a card_index can not be null.");
+
+        this->m_vCards = pDeck->get_numbers();
+        this->m_mIds.reserve(this->m_vCards.size());
+        for (std::size_t nId = 0; nId < this->m_vCards.size(); ++nId)
+        {
+            const number *pCard = this->m_vCards[nId];
+            this->m_mIds.emplace(pCard, static_cast<std::uint32_t>(nId));
+
+            // Separate the names so that "ab/c" and "a/bc" differ
+            this->m_nFingerprint = fnv1a_hash(pCard->get_suit()->get_name(), this->m_nFingerprint);
+            this->m_nFingerprint = fnv1a_hash(std::string_view("\0", 1), this->m_nFingerprint);
+            this->m_nFingerprint = fnv1a_hash(pCard->get_name(), this->m_nFingerprint);
+            this->m_nFingerprint = fnv1a_hash(std::string_view("\0", 1), this->m_nFingerprint);
+        }
+    }
+
+    const deck *card_index::get_deck() const noexcept
+    {
+        return this->m_pDeck;
+    }
+
+    std::uint64_t card_index::get_fingerprint() const noexcept
+    {
+        return this->m_nFingerprint;
+    }
+
+    std::size_t card_index::get_card_count() const noexcept
+    {
+        return this->m_vCards.size();
+    }
+
+    std::uint32_t card_index::get_id(const number *pCard) const
+    {
+        auto pIt = this->m_mIds.find(pCard);
+        return pIt != this->m_mIds.cend() ? pIt->second : INVALID_ID;
+    }
+
+    const number *card_index::get_card(std::uint32_t nId) const noexcept
+    {
+        return nId < this->m_vCards.size() ? this->m_vCards[nId] : nullptr;
+    }
+
+} // namespace ac
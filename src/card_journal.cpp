@@ -0,0 +1,430 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+#include "card_journal.h"
+
+#include "binary.h"
+#include "card_index.h"
+#include "card_table.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace ac
+{
+
+    /// Magic of the journals.
+    static constexpr std::string_view JOURNAL_MAGIC = "ACJL";
+
+    /// Version of the journals.
+    static constexpr std::uint64_t JOURNAL_VERSION = 1;
+
+    /// Tag of the records closing a frame.
+    static constexpr std::uint8_t JOURNAL_END_FRAME = 0x10;
+
+    /// Tag of the keyframe records.
+    static constexpr std::uint8_t JOURNAL_KEYFRAME = 0x11;
+
+    card_journal::card_journal(const card_index &oIndex, std::size_t nKeyframeInterval)
+        : m_pIndex(&oIndex),
+          m_nKeyframeInterval(nKeyframeInterval),
+          m_nFrames(0),
+          m_nFramesSinceKeyframe(0)
+    {
+        this->m_sData.append(JOURNAL_MAGIC);
+        write_varint(this->m_sData, JOURNAL_VERSION);
+        write_fixed64(this->m_sData, oIndex.get_fingerprint());
+    }
+
+    std::size_t card_journal::get_frame_count() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return this->m_nFrames;
+    }
+
+    std::size_t card_journal::get_size() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return this->m_sData.size();
+    }
+
+    void card_journal::get_data(std::string &sBuffer) const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        sBuffer.append(this->m_sData);
+    }
+
+    std::string card_journal::get_data() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return this->m_sData;
+    }
+
+    void card_journal::record(const std::vector<card_change> &vChanges, const std::list<card_holder> &lHolders)
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        std::size_t nStart = this->m_sData.size();
+        std::string &sData = this->m_sData;
+
+        auto write_card = [this, &sData, nStart](const number *pCard)
+        {
+            std::uint32_t nId = this->m_pIndex->get_id(pCard);
+            if (nId == card_index::INVALID_ID)
+            {
+                sData.resize(nStart);
+                throw std::invalid_argument("Card \'" + pCard->get_name() + "\' is not part of the indexed deck.");
+            }
+            write_varint(sData, nId);
+        };
+
+        for (const card_change &oChange : vChanges)
+        {
+            sData.push_back(static_cast<char>(oChange.m_nType));
+            switch (oChange.m_nType)
+            {
+            case card_change_type::INSERT:
+            case card_change_type::ERASE:
+                write_card(oChange.m_pCard);
+                write_varint(sData, oChange.m_nLayer);
+                write_varint(sData, oChange.m_oPos.get_x());
+                write_varint(sData, oChange.m_oPos.get_y());
+                write_varint(sData, oChange.m_bVisible);
+                break;
+            case card_change_type::MOVE:
+                write_card(oChange.m_pCard);
+                write_varint(sData, oChange.m_nLayer);
+                write_varint(sData, oChange.m_oPreviousPos.get_x());
+                write_varint(sData, oChange.m_oPreviousPos.get_y());
+                write_varint(sData, oChange.m_oPos.get_x());
+                write_varint(sData, oChange.m_oPos.get_y());
+                break;
+            case card_change_type::RESTACK:
+                write_card(oChange.m_pCard);
+                write_varint(sData, oChange.m_nPreviousLayer);
+                write_varint(sData, oChange.m_nLayer);
+                break;
+            case card_change_type::REPLACE:
+                write_card(oChange.m_pPreviousCard);
+                write_card(oChange.m_pCard);
+                write_varint(sData, oChange.m_nLayer);
+                break;
+            case card_change_type::VISIBILITY:
+                write_card(oChange.m_pCard);
+                write_varint(sData, oChange.m_nLayer);
+                write_varint(sData, oChange.m_bVisible);
+                break;
+            case card_change_type::RESET:
+            {
+                // A reset is the last change of its frame, so the state is the one after it
+                std::string sSnapshot;
+                try
+                {
+                    card_table::write_snapshot(sSnapshot, lHolders, *this->m_pIndex);
+                }
+                catch (...)
+                {
+                    sData.resize(nStart);
+                    throw;
+                }
+                write_varint(sData, sSnapshot.size());
+                sData.append(sSnapshot);
+                break;
+            }
+            }
+        }
+        sData.push_back(static_cast<char>(JOURNAL_END_FRAME));
+        ++this->m_nFrames;
+
+        // Periodic keyframe
+        if (this->m_nKeyframeInterval > 0 && ++this->m_nFramesSinceKeyframe >= this->m_nKeyframeInterval)
+            this->record_keyframe_unlocked(lHolders);
+    }
+
+    void card_journal::record_keyframe(const std::list<card_holder> &lHolders)
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        this->record_keyframe_unlocked(lHolders);
+    }
+
+    void card_journal::record_keyframe_unlocked(const std::list<card_holder> &lHolders)
+    {
+        std::string sSnapshot;
+        card_table::write_snapshot(sSnapshot, lHolders, *this->m_pIndex);
+
+        this->m_sData.push_back(static_cast<char>(JOURNAL_KEYFRAME));
+        write_varint(this->m_sData, sSnapshot.size());
+        this->m_sData.append(sSnapshot);
+        this->m_nFramesSinceKeyframe = 0;
+    }
+
+    card_journal_player::card_journal_player(std::string_view sData, const card_index &oIndex)
+        : m_sData(sData),
+          m_pIndex(&oIndex),
+          m_nStart(0),
+          m_nFrames(0)
+    {
+        const char *pData = sData.data();
+        const char *pEnd = pData + sData.size();
+        std::uint64_t nVersion = 0;
+
+        // Header
+        if (sData.substr(0, JOURNAL_MAGIC.size()) != JOURNAL_MAGIC)
+            throw std::runtime_error("Invalid journal: bad magic.");
+        pData += JOURNAL_MAGIC.size();
+        if (!read_varint(pData, pEnd, nVersion) || nVersion != JOURNAL_VERSION)
+            throw std::runtime_error("Invalid journal: unsupported version.");
+        if (pEnd - pData < 8)
+            throw std::runtime_error("Invalid journal: truncated data.");
+        if (read_fixed64(pData) != oIndex.get_fingerprint())
+            throw std::runtime_error("Invalid journal: written against a different deck.");
+        pData += 8;
+        this->m_nStart = pData - sData.data();
+
+        // Locate frames and keyframes
+        std::uint8_t nTag = 0;
+        card_change oChange = card_change::reset();
+        std::string_view sSnapshot;
+        while (pData != pEnd)
+        {
+            std::size_t nOffset = pData - sData.data();
+            this->read_record(pData, nTag, oChange, sSnapshot);
+            if (nTag == JOURNAL_END_FRAME)
+                ++this->m_nFrames;
+            else if (nTag == JOURNAL_KEYFRAME)
+                this->m_vKeyframes.push_back({this->m_nFrames, nOffset});
+        }
+    }
+
+    std::size_t card_journal_player::get_frame_count() const noexcept
+    {
+        return this->m_nFrames;
+    }
+
+    void card_journal_player::read_record(const char *&pData, std::uint8_t &nTag, card_change &oChange, std::string_view &sSnapshot) const
+    {
+        const char *pEnd = this->m_sData.data() + this->m_sData.size();
+        auto fail = [](const char *sMessage)
+        {
+            throw std::runtime_error(std::string("Invalid journal: ") + sMessage + ".");
+        };
+        auto read = [&pData, pEnd, &fail]()
+        {
+            std::uint64_t nValue = 0;
+            if (!read_varint(pData, pEnd, nValue))
+                fail("truncated data");
+            return nValue;
+        };
+        auto read_card = [this, &read, &fail]()
+        {
+            std::uint64_t nId = read();
+            const number *pCard = nId < card_index::INVALID_ID ? this->m_pIndex->get_card(static_cast<std::uint32_t>(nId)) : nullptr;
+            if (pCard == nullptr)
+                fail("unknown card identifier");
+            return pCard;
+        };
+
+        if (pData == pEnd)
+            fail("truncated data");
+        nTag = static_cast<std::uint8_t>(*pData++);
+
+        switch (nTag)
+        {
+        case static_cast<std::uint8_t>(card_change_type::INSERT):
+        case static_cast<std::uint8_t>(card_change_type::ERASE):
+        {
+            const number *pCard = read_card();
+            std::size_t nLayer = read();
+            std::size_t nX = read();
+            std::size_t nY = read();
+            bool bVisible = read() != 0;
+            oChange = nTag == static_cast<std::uint8_t>(card_change_type::INSERT)
+                          ? card_change::insert(pCard, nLayer, point(nX, nY), bVisible)
+                          : card_change::erase(pCard, nLayer, point(nX, nY), bVisible);
+            break;
+        }
+        case static_cast<std::uint8_t>(card_change_type::MOVE):
+        {
+            const number *pCard = read_card();
+            std::size_t nLayer = read();
+            std::size_t nPreviousX = read();
+            std::size_t nPreviousY = read();
+            std::size_t nX = read();
+            std::size_t nY = read();
+            oChange = card_change::move(pCard, nLayer, point(nPreviousX, nPreviousY), point(nX, nY));
+            break;
+        }
+        case static_cast<std::uint8_t>(card_change_type::RESTACK):
+        {
+            const number *pCard = read_card();
+            std::size_t nPreviousLayer = read();
+            std::size_t nLayer = read();
+            oChange = card_change::restack(pCard, nPreviousLayer, nLayer);
+            break;
+        }
+        case static_cast<std::uint8_t>(card_change_type::REPLACE):
+        {
+            const number *pPreviousCard = read_card();
+            const number *pCard = read_card();
+            std::size_t nLayer = read();
+            oChange = card_change::replace(nLayer, pPreviousCard, pCard);
+            break;
+        }
+        case static_cast<std::uint8_t>(card_change_type::VISIBILITY):
+        {
+            const number *pCard = read_card();
+            std::size_t nLayer = read();
+            bool bVisible = read() != 0;
+            oChange = card_change::visibility(pCard, nLayer, bVisible);
+            break;
+        }
+        case static_cast<std::uint8_t>(card_change_type::RESET):
+        case JOURNAL_KEYFRAME:
+        {
+            std::uint64_t nSize = read();
+            if (nSize > static_cast<std::uint64_t>(pEnd - pData))
+                fail("truncated data");
+            sSnapshot = std::string_view(pData, nSize);
+            pData += nSize;
+            oChange = card_change::reset();
+            break;
+        }
+        case JOURNAL_END_FRAME:
+            break;
+        default:
+            fail("unknown record");
+        }
+    }
+
+    const char *card_journal_player::replay(std::size_t nFrame, std::list<card_holder> &lHolders) const
+    {
+        // Closest keyframe at or before the frame
+        auto pIt = std::upper_bound(this->m_vKeyframes.cbegin(), this->m_vKeyframes.cend(), nFrame,
+                                    [](std::size_t nValue, const keyframe &oKeyframe)
+                                    { return nValue < oKeyframe.m_nFrame; });
+        const char *pData = this->m_sData.data() + this->m_nStart;
+        std::size_t nCurrent = 0;
+        lHolders.clear();
+        if (pIt != this->m_vKeyframes.cbegin())
+        {
+            --pIt;
+            pData = this->m_sData.data() + pIt->m_nOffset;
+            nCurrent = pIt->m_nFrame;
+        }
+
+        // Replay the remaining changes in memory
+        std::uint8_t nTag = 0;
+        card_change oChange = card_change::reset();
+        std::string_view sSnapshot;
+        const char *pEnd = this->m_sData.data() + this->m_sData.size();
+        while (pData != pEnd)
+        {
+            // Stop at the first record after the frame, except a keyframe, which is consumed
+            if (nCurrent == nFrame && static_cast<std::uint8_t>(*pData) != JOURNAL_KEYFRAME)
+                break;
+
+            this->read_record(pData, nTag, oChange, sSnapshot);
+            if (nTag == JOURNAL_END_FRAME)
+            {
+                ++nCurrent;
+            }
+            else if (oChange.m_nType == card_change_type::RESET)
+            {
+                card_table::read_snapshot(sSnapshot, *this->m_pIndex, lHolders);
+            }
+            else
+            {
+                try
+                {
+                    oChange.apply(lHolders);
+                }
+                catch (const std::invalid_argument &)
+                {
+                    throw std::runtime_error("Invalid journal: a change does not match the replayed state.");
+                }
+            }
+        }
+        return pData;
+    }
+
+    void card_journal_player::seek(std::size_t nFrame, card_table *pTable) const
+    {
+        if (pTable == nullptr)
+            throw std::invalid_argument("The table to seek can not be null.");
+
+        std::list<card_holder> lHolders;
+        this->replay(std::min(nFrame, this->m_nFrames), lHolders);
+        pTable->set_holders(std::move(lHolders));
+    }
+
+    void card_journal_player::play(std::size_t nFrom, std::size_t nTo, card_table *pTable, const std::function<void(std::size_t)> &fnOnFrame) const
+    {
+        if (pTable == nullptr)
+            throw std::invalid_argument("The table to play into can not be null.");
+
+        nTo = std::min(nTo, this->m_nFrames);
+        nFrom = std::min(nFrom, nTo);
+
+        // Start state
+        std::list<card_holder> lHolders;
+        const char *pData = this->replay(nFrom, lHolders);
+        pTable->set_holders(std::move(lHolders));
+
+        // Frames, one update each (snapshots inside a frame update the table on their own)
+        std::uint8_t nTag = 0;
+        card_change oChange = card_change::reset();
+        std::string_view sSnapshot;
+        std::vector<card_change> vChanges;
+        for (std::size_t nFrame = nFrom; nFrame < nTo;)
+        {
+            this->read_record(pData, nTag, oChange, sSnapshot);
+            if (nTag == JOURNAL_END_FRAME)
+            {
+                try
+                {
+                    pTable->apply_changes(vChanges);
+                }
+                catch (const std::invalid_argument &)
+                {
+                    throw std::runtime_error("Invalid journal: a change does not match the replayed state.");
+                }
+                vChanges.clear();
+                ++nFrame;
+                if (fnOnFrame)
+                    fnOnFrame(nFrame);
+            }
+            else if (nTag == JOURNAL_KEYFRAME)
+            {
+                // Keyframes repeat the state reached so far, they only help seeking
+                continue;
+            }
+            else if (oChange.m_nType == card_change_type::RESET)
+            {
+                pTable->apply_changes(vChanges);
+                vChanges.clear();
+                card_table::read_snapshot(sSnapshot, *this->m_pIndex, lHolders);
+                pTable->set_holders(std::move(lHolders));
+            }
+            else
+            {
+                vChanges.push_back(oChange);
+            }
+        }
+    }
+
+} // namespace ac
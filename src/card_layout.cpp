@@ -0,0 +1,97 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+#include "card_layout.h"
+#include "card_renderer.h"
+
+#include <algorithm>
+
+namespace ac
+{
+
+    card_layout::card_layout(std::size_t nCardWidth, std::size_t nCardHeight)
+        : m_nCardWidth(nCardWidth),
+          m_nCardHeight(nCardHeight) {}
+
+    card_layout::card_layout(const card_renderer *pRenderer)
+        : m_nCardWidth(pRenderer != nullptr ? pRenderer->get_card_width() : 1),
+          m_nCardHeight(pRenderer != nullptr ? pRenderer->get_card_height() : 1) {}
+
+    std::size_t card_layout::get_card_width() const noexcept
+    {
+        return this->m_nCardWidth;
+    }
+
+    std::size_t card_layout::get_card_height() const noexcept
+    {
+        return this->m_nCardHeight;
+    }
+
+    void card_layout::row(std::vector<point> &vPositions, point oOrigin, std::size_t nCount, std::size_t nGap) const
+    {
+        std::size_t nStep = this->m_nCardWidth + nGap;
+        vPositions.reserve(vPositions.size() + nCount);
+        for (std::size_t nCard = 0; nCard < nCount; ++nCard)
+            vPositions.emplace_back(oOrigin.get_x() + nCard * nStep, oOrigin.get_y());
+    }
+
+    void card_layout::grid(std::vector<point> &vPositions, point oOrigin, std::size_t nCount, std::size_t nColumns, std::size_t nGapX, std::size_t nGapY) const
+    {
+        nColumns = std::max<std::size_t>(nColumns, 1);
+        std::size_t nStepX = this->m_nCardWidth + nGapX;
+        std::size_t nStepY = this->m_nCardHeight + nGapY;
+        vPositions.reserve(vPositions.size() + nCount);
+        for (std::size_t nCard = 0; nCard < nCount; ++nCard)
+            vPositions.emplace_back(oOrigin.get_x() + (nCard % nColumns) * nStepX, oOrigin.get_y() + (nCard / nColumns) * nStepY);
+    }
+
+    void card_layout::fan(std::vector<point> &vPositions, point oOrigin, std::size_t nCount, std::size_t nWidth) const
+    {
+        // Spread the free width evenly, in fixed point so that the last card ends at the width
+        std::size_t nFree = nWidth > this->m_nCardWidth ? nWidth - this->m_nCardWidth : 0;
+        std::size_t nGaps = nCount > 1 ? nCount - 1 : 1;
+        std::size_t nMaxStep = std::max<std::size_t>(this->m_nCardWidth, 1);
+        vPositions.reserve(vPositions.size() + nCount);
+        for (std::size_t nCard = 0; nCard < nCount; ++nCard)
+        {
+            std::size_t nOffset = nFree * nCard / nGaps;
+            nOffset = std::clamp<std::size_t>(nOffset, nCard, nCard * nMaxStep);
+            vPositions.emplace_back(oOrigin.get_x() + nOffset, oOrigin.get_y());
+        }
+    }
+
+    void card_layout::cascade(std::vector<point> &vPositions, point oOrigin, std::size_t nCount, std::size_t nStep) const
+    {
+        nStep = std::max<std::size_t>(nStep, 1);
+        vPositions.reserve(vPositions.size() + nCount);
+        for (std::size_t nCard = 0; nCard < nCount; ++nCard)
+            vPositions.emplace_back(oOrigin.get_x(), oOrigin.get_y() + nCard * nStep);
+    }
+
+    void card_layout::pile(std::vector<point> &vPositions, point oOrigin, std::size_t nCount, std::size_t nEvery, std::size_t nOffsetX, std::size_t nOffsetY) const
+    {
+        vPositions.reserve(vPositions.size() + nCount);
+        for (std::size_t nCard = 0; nCard < nCount; ++nCard)
+        {
+            std::size_t nShift = nEvery > 0 ? nCard / nEvery : 0;
+            vPositions.emplace_back(oOrigin.get_x() + nShift * nOffsetX, oOrigin.get_y() + nShift * nOffsetY);
+        }
+    }
+
+} // namespace ac
@@ -24,4 +24,40 @@ namespace ac
 
     card_renderer::~card_renderer() {}
 
+    void card_renderer::render_card(const number *pCard, point nPos, std::span<const rect>) const
+    {
+        this->render_card(pCard, nPos);
+    }
+
+    void card_renderer::render_table(std::span<const rect>) const
+    {
+        this->render_table();
+    }
+
+    bool card_renderer::can_render_regions() const
+    {
+        return false;
+    }
+
+    void card_renderer::get_wide_glyphs(const number *, std::vector<rect> &) const {}
+
+    bool card_renderer::update_size() const
+    {
+        return false;
+    }
+
+    void card_renderer::begin_frame() const {}
+
+    void card_renderer::end_frame() const {}
+
+    std::size_t card_renderer::get_card_width() const
+    {
+        return 1;
+    }
+
+    std::size_t card_renderer::get_card_height() const
+    {
+        return 1;
+    }
+
 } // namespace ac
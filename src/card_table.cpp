@@ -18,15 +18,56 @@
  */
 
 #include "card_table.h"
+#include "binary.h"
+#include "card_index.h"
+#include "card_journal.h"
+#include "json.h"
+#include "suit.h"
+#include "thread_pool.h"
 
 #include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 namespace ac
 {
 
+    /// Largest number of changes repainted region by region, larger updates repaint the whole table.
+    static constexpr std::size_t MAX_DAMAGED_CHANGES = 64;
+
+    /// Columns of a row of the table, from the first one to the one past the last.
+    using row_span = std::pair<std::size_t, std::size_t>;
+
+    /// Smallest number of card cells composed by a tile, so that composing in parallel pays for the threads.
+    static constexpr std::size_t MIN_TILE_CELLS = 16 * 1024;
+
+    /**
+     * @struct composed_tile
+     * @brief The exposed parts of the cards in a band of rows of the table.
+     */
+    struct composed_tile
+    {
+        std::size_t m_nTop;                ///< First row of the band.
+        std::size_t m_nBottom;             ///< Row past the last one of the band.
+        std::vector<rect> m_vExposed;      ///< Exposed rectangles of the cards, card after card.
+        std::vector<std::size_t> m_vStart; ///< Start of the rectangles of every card in m_vExposed, and their end.
+    };
+
+    static bool intersects_any(std::span<const rect> vRegions, const rect &oArea);
+    static void merge_exposed(std::vector<rect> &vExposed, std::size_t nStart, const rect &oRun);
+    static void cover_row(std::vector<row_span> &vCovered, const row_span &oSpan, std::vector<row_span> &vUncovered);
+    static void compose_tile(const card_renderer *pRenderer, std::span<const card_holder *const> vCards, std::span<const rect> vRegions, bool bClip, composed_tile &oTile);
+
     card_table::card_table(const card_renderer *pRenderer, bool bRenderOnChange)
         : m_pRenderer(pRenderer),
-          m_bRenderOnChange(bRenderOnChange)
+          m_bRenderOnChange(bRenderOnChange),
+          m_bParallelComposition(true),
+          m_pJournal(nullptr),
+          m_nHistoryLimit(0),
+          m_nNextObserver(0),
+          m_bGridDirty(false)
     {
         // Render
         if (this->m_bRenderOnChange)
@@ -40,18 +81,114 @@ namespace ac
         if (this->m_pRenderer == nullptr)
             return;
 
+        this->m_pRenderer->begin_frame();
         this->m_pRenderer->render_table();
-        for (auto oHolder : this->m_lCards)
+        this->render_cards_unlocked(std::span<const rect>(), false);
+        this->m_pRenderer->end_frame();
+    }
+
+    void card_table::render_regions(std::span<const rect> vRegions) const
+    {
+        if (this->m_pRenderer == nullptr)
+            return;
+
+        this->m_pRenderer->begin_frame();
+        this->m_pRenderer->render_table(vRegions);
+        this->render_cards_unlocked(vRegions, true);
+        this->m_pRenderer->end_frame();
+    }
+
+    void card_table::render_cards_unlocked(std::span<const rect> vRegions, bool bClip) const
+    {
+        // The cards that may be drawn, from the top. When clipping, cards next to a region
+        // may hide the wide glyphs cut by its edge
+        std::size_t nCardWidth = std::max<std::size_t>(this->m_pRenderer->get_card_width(), 1);
+        std::size_t nCardHeight = std::max<std::size_t>(this->m_pRenderer->get_card_height(), 1);
+        std::vector<const card_holder *> vCards;
+        std::size_t nTop = SIZE_MAX;
+        std::size_t nBottom = 0;
+        for (auto pIt = this->m_lCards.rbegin(); pIt != this->m_lCards.rend(); ++pIt)
         {
-            if (oHolder.m_bVisible)
-                this->m_pRenderer->render_card(oHolder.m_pCard, oHolder.m_oPos);
+            std::size_t nLeft = std::min<std::size_t>(pIt->m_oPos.get_x(), 1);
+            rect oNear(pIt->m_oPos.get_x() - nLeft, pIt->m_oPos.get_y(), nCardWidth + nLeft + 1, nCardHeight);
+            if (!pIt->m_bVisible || (bClip && !intersects_any(vRegions, oNear)))
+                continue;
+            vCards.push_back(&*pIt);
+            nTop = std::min(nTop, pIt->m_oPos.get_y());
+            nBottom = std::max(nBottom, pIt->m_oPos.get_y() + nCardHeight);
+        }
+        if (vCards.empty())
+            return;
+
+        // Cells of different rows never hide each other, so bands of rows are composed apart
+        std::size_t nRows = nBottom - nTop;
+        // The shared pool is only started by tables large enough to need it
+        std::size_t nTiles = 1;
+        std::size_t nEstimate = vCards.size() * nCardWidth * nCardHeight / MIN_TILE_CELLS;
+        if (this->m_bParallelComposition && nEstimate > 1)
+        {
+            std::size_t nThreads = thread_pool::get_shared().get_thread_count();
+            nTiles = std::clamp<std::size_t>(nEstimate, 1, std::min(nThreads, nRows));
+        }
+        std::vector<composed_tile> vTiles(nTiles);
+        for (std::size_t nTile = 0; nTile < nTiles; ++nTile)
+        {
+            vTiles[nTile].m_nTop = nTop + nTile * (nRows / nTiles) + std::min(nTile, nRows % nTiles);
+            vTiles[nTile].m_nBottom = nTop + (nTile + 1) * (nRows / nTiles) + std::min(nTile + 1, nRows % nTiles);
+        }
+        auto compose = [this, &vCards, &vRegions, bClip, &vTiles](std::size_t nTile)
+        {
+            compose_tile(this->m_pRenderer, vCards, vRegions, bClip, vTiles[nTile]);
+        };
+        if (nTiles > 1)
+            thread_pool::get_shared().run(nTiles, compose);
+        else
+            compose(0);
+
+        // Join the bands card by card, merging the rectangles cut by their edges
+        std::vector<std::pair<const card_holder *, std::size_t>> vDraws;
+        std::vector<rect> vExposed;
+        for (std::size_t nCard = 0; nCard < vCards.size(); ++nCard)
+        {
+            std::size_t nStart = vExposed.size();
+            for (const composed_tile &oTile : vTiles)
+                for (std::size_t nRun = oTile.m_vStart[nCard]; nRun < oTile.m_vStart[nCard + 1]; ++nRun)
+                    merge_exposed(vExposed, nStart, oTile.m_vExposed[nRun]);
+
+            // Fully covered cards are not drawn
+            if (vExposed.size() > nStart)
+                vDraws.emplace_back(vCards[nCard], nStart);
+        }
+
+        // Draw from the bottom, so that renderers drawing whole cards stay correct
+        for (std::size_t nDraw = vDraws.size(); nDraw > 0; --nDraw)
+        {
+            const card_holder *pHolder = vDraws[nDraw - 1].first;
+            std::size_t nStart = vDraws[nDraw - 1].second;
+            std::size_t nEnd = nDraw < vDraws.size() ? vDraws[nDraw].second : vExposed.size();
+            std::span<const rect> vCardExposed(vExposed.data() + nStart, nEnd - nStart);
+            if (vCardExposed.size() == 1 && vCardExposed[0] == rect(pHolder->m_oPos, nCardWidth, nCardHeight))
+                this->m_pRenderer->render_card(pHolder->m_pCard, pHolder->m_oPos);
+            else
+                this->m_pRenderer->render_card(pHolder->m_pCard, pHolder->m_oPos, vCardExposed);
         }
     }
 
     void card_table::render_safe() const
     {
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        if (this->m_pRenderer != nullptr)
+            this->m_pRenderer->update_size();
+        this->render();
+    }
+
+    bool card_table::refresh() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        if (this->m_pRenderer == nullptr || !this->m_pRenderer->update_size())
+            return false;
         this->render();
+        return true;
     }
 
     bool card_table::get_render_on_change() const
@@ -66,6 +203,18 @@ namespace ac
         this->m_bRenderOnChange = bRenderOnChange;
     }
 
+    bool card_table::get_parallel_composition() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return this->m_bParallelComposition;
+    }
+
+    void card_table::set_parallel_composition(bool bParallelComposition)
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        this->m_bParallelComposition = bParallelComposition;
+    }
+
     const card_renderer *card_table::get_renderer_unlocked() const
     {
         return this->m_pRenderer;
@@ -81,6 +230,9 @@ namespace ac
     {
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
         this->m_pRenderer = pRenderer;
+
+        // The size of the cards may have changed
+        this->m_pGrid = nullptr;
     }
 
     std::list<card_holder> card_table::get_holders_unlocked() const
@@ -94,8 +246,363 @@ namespace ac
         return this->m_lCards;
     }
 
+    void card_table::set_holders(std::list<card_holder> lHolders)
+    {
+        change_notifier oNotifier(this);
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        // Replace cards, keeping the previous ones to undo or roll back
+        this->m_lPrevious = std::exchange(this->m_lCards, std::move(lHolders));
+        this->m_vChanges.push_back(card_change::reset());
+
+        // Notify and render
+        this->commit_unlocked();
+    }
+
+    card_journal *card_table::get_journal() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return this->m_pJournal;
+    }
+
+    void card_table::set_journal(card_journal *pJournal)
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        // The journal starts from the current state
+        if (pJournal != nullptr)
+            pJournal->record_keyframe(this->m_lCards);
+        this->m_pJournal = pJournal;
+    }
+
+    void card_table::apply_changes(std::span<const card_change> vChanges)
+    {
+        change_notifier oNotifier(this);
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        // Apply all or nothing
+        std::size_t nApplied = 0;
+        try
+        {
+            for (; nApplied < vChanges.size(); ++nApplied)
+                vChanges[nApplied].apply(this->m_lCards);
+        }
+        catch (...)
+        {
+            while (nApplied > 0)
+                vChanges[--nApplied].get_inverse().apply(this->m_lCards);
+            throw;
+        }
+        this->m_vChanges.assign(vChanges.begin(), vChanges.end());
+
+        // Notify and render
+        this->commit_unlocked();
+    }
+
+    std::size_t card_table::get_history_limit() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return this->m_nHistoryLimit;
+    }
+
+    void card_table::set_history_limit(std::size_t nLimit)
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        this->m_nHistoryLimit = nLimit;
+        this->m_dUndo.clear();
+        this->m_dRedo.clear();
+    }
+
+    bool card_table::can_undo() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return !this->m_dUndo.empty();
+    }
+
+    bool card_table::can_redo() const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return !this->m_dRedo.empty();
+    }
+
+    bool card_table::undo()
+    {
+        change_notifier oNotifier(this);
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        // Return if there is nothing to undo
+        if (this->m_dUndo.empty())
+            return false;
+
+        // Apply the inverse changes, from the last one
+        history_step &oStep = this->m_dUndo.back();
+        if (oStep.m_vChanges.front().m_nType == card_change_type::RESET)
+        {
+            this->m_lPrevious = std::exchange(this->m_lCards, oStep.m_lBefore);
+            this->m_vChanges.push_back(card_change::reset());
+        }
+        else
+        {
+            for (auto pIt = oStep.m_vChanges.rbegin(); pIt != oStep.m_vChanges.rend(); ++pIt)
+            {
+                card_change oInverse = pIt->get_inverse();
+                oInverse.apply(this->m_lCards);
+                this->m_vChanges.push_back(oInverse);
+            }
+        }
+
+        // Notify and render, then move the step once it is committed
+        this->commit_unlocked(false);
+        this->m_dRedo.push_back(std::move(oStep));
+        this->m_dUndo.pop_back();
+        return true;
+    }
+
+    bool card_table::redo()
+    {
+        change_notifier oNotifier(this);
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        // Return if there is nothing to redo
+        if (this->m_dRedo.empty())
+            return false;
+
+        // Apply the changes again
+        history_step &oStep = this->m_dRedo.back();
+        if (oStep.m_vChanges.front().m_nType == card_change_type::RESET)
+            this->m_lPrevious = std::exchange(this->m_lCards, oStep.m_lAfter);
+        else
+        {
+            for (const auto &oChange : oStep.m_vChanges)
+                oChange.apply(this->m_lCards);
+        }
+        this->m_vChanges = oStep.m_vChanges;
+
+        // Notify and render, then move the step once it is committed
+        this->commit_unlocked(false);
+        this->m_dUndo.push_back(std::move(oStep));
+        this->m_dRedo.pop_back();
+        return true;
+    }
+
+    void card_table::clear_history()
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        this->m_dUndo.clear();
+        this->m_dRedo.clear();
+    }
+
+    std::size_t card_table::subscribe(observer fnObserver)
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        if (!fnObserver)
+            throw std::invalid_argument("The observer can not be empty.");
+
+        // Copy the list, so that batches being delivered keep the previous one
+        auto pObservers = this->m_pObservers != nullptr ? std::make_shared<observer_list>(*this->m_pObservers) : std::make_shared<observer_list>();
+        pObservers->emplace_back(this->m_nNextObserver, std::move(fnObserver));
+        this->m_pObservers = std::move(pObservers);
+        return this->m_nNextObserver++;
+    }
+
+    void card_table::unsubscribe(std::size_t nId)
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        if (this->m_pObservers == nullptr)
+            return;
+
+        // Copy the list without the observer
+        auto pObservers = std::make_shared<observer_list>();
+        for (const auto &oObserver : *this->m_pObservers)
+        {
+            if (oObserver.first != nId)
+                pObservers->push_back(oObserver);
+        }
+        if (pObservers->empty())
+            this->m_pObservers = nullptr;
+        else
+            this->m_pObservers = std::move(pObservers);
+    }
+
+    void card_table::notify()
+    {
+        // Batches caused by an observer are delivered by the loop running it
+        if (this->m_oDeliveryThread.load() == std::this_thread::get_id())
+            return;
+
+        while (true)
+        {
+            // Only one thread delivers at a time, the others leave their batches to it
+            if (!this->m_oDeliveryMutex.try_lock())
+                return;
+            this->m_oDeliveryThread.store(std::this_thread::get_id());
+
+            while (true)
+            {
+                std::vector<card_change> vBatch;
+                std::shared_ptr<const observer_list> pObservers;
+                {
+                    std::lock_guard<std::mutex> oLock(this->m_oMutex);
+                    if (this->m_dPending.empty())
+                        break;
+                    vBatch = std::move(this->m_dPending.front());
+                    this->m_dPending.pop_front();
+                    pObservers = this->m_pObservers;
+                }
+
+                // Deliver without holding the mutex
+                if (pObservers != nullptr)
+                {
+                    for (const auto &oObserver : *pObservers)
+                        oObserver.second(vBatch);
+                }
+            }
+
+            this->m_oDeliveryThread.store(std::thread::id());
+            this->m_oDeliveryMutex.unlock();
+
+            // A batch may have been queued after the last check, while the delivery mutex was still held
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            if (this->m_dPending.empty())
+                return;
+        }
+    }
+
+    void card_table::commit_unlocked(bool bRecordHistory)
+    {
+        if (this->m_vChanges.empty())
+            return;
+
+        // Journal first, so that changes it can not record are rolled back before anything sees them
+        if (this->m_pJournal != nullptr)
+        {
+            try
+            {
+                this->m_pJournal->record(this->m_vChanges, this->m_lCards);
+            }
+            catch (...)
+            {
+                this->rollback_unlocked();
+                throw;
+            }
+        }
+
+        // History, a new step forgets the undone ones
+        if (bRecordHistory && this->m_nHistoryLimit > 0)
+        {
+            history_step oStep;
+            oStep.m_vChanges = this->m_vChanges;
+            if (oStep.m_vChanges.front().m_nType == card_change_type::RESET)
+            {
+                oStep.m_lBefore = std::move(this->m_lPrevious);
+                oStep.m_lAfter = this->m_lCards;
+            }
+            this->m_dUndo.push_back(std::move(oStep));
+            if (this->m_dUndo.size() > this->m_nHistoryLimit)
+                this->m_dUndo.pop_front();
+            this->m_dRedo.clear();
+        }
+
+        // Spatial index
+        if (this->m_pGrid != nullptr && !this->m_bGridDirty)
+        {
+            for (const auto &oChange : this->m_vChanges)
+            {
+                if (!this->m_pGrid->update(oChange))
+                {
+                    this->m_bGridDirty = true;
+                    break;
+                }
+            }
+        }
+
+        // Render, only the damaged regions when possible; a resized output is redrawn whole
+        if (this->m_bRenderOnChange)
+        {
+            std::vector<rect> vDamaged;
+            bool bResized = this->m_pRenderer != nullptr && this->m_pRenderer->update_size();
+            if (!bResized && this->get_damage_unlocked(vDamaged))
+                this->render_regions(vDamaged);
+            else
+                this->render();
+        }
+
+        // Queue for the observers
+        if (this->m_pObservers != nullptr)
+            this->m_dPending.push_back(std::move(this->m_vChanges));
+        this->m_vChanges.clear();
+        this->m_lPrevious.clear();
+    }
+
+    void card_table::rollback_unlocked()
+    {
+        // A RESET is alone in its call, the other changes are inverted from the last one
+        if (this->m_vChanges.front().m_nType == card_change_type::RESET)
+            this->m_lCards = std::move(this->m_lPrevious);
+        else
+        {
+            for (auto pIt = this->m_vChanges.rbegin(); pIt != this->m_vChanges.rend(); ++pIt)
+                pIt->get_inverse().apply(this->m_lCards);
+        }
+        this->m_vChanges.clear();
+        this->m_lPrevious.clear();
+    }
+
+    bool card_table::get_damage_unlocked(std::vector<rect> &vDamaged) const
+    {
+        if (this->m_pRenderer == nullptr || !this->m_pRenderer->can_render_regions() || this->m_vChanges.size() > MAX_DAMAGED_CHANGES)
+            return false;
+
+        std::size_t nCardWidth = std::max<std::size_t>(this->m_pRenderer->get_card_width(), 1);
+        std::size_t nCardHeight = std::max<std::size_t>(this->m_pRenderer->get_card_height(), 1);
+        std::unordered_set<const number *> sInPlace;
+        for (const auto &oChange : this->m_vChanges)
+        {
+            switch (oChange.m_nType)
+            {
+            case card_change_type::INSERT:
+            case card_change_type::ERASE:
+                vDamaged.emplace_back(oChange.m_oPos, nCardWidth, nCardHeight);
+                break;
+            case card_change_type::MOVE:
+                vDamaged.emplace_back(oChange.m_oPreviousPos, nCardWidth, nCardHeight);
+                vDamaged.emplace_back(oChange.m_oPos, nCardWidth, nCardHeight);
+                break;
+            case card_change_type::REPLACE:
+                sInPlace.insert(oChange.m_pPreviousCard);
+                sInPlace.insert(oChange.m_pCard);
+                break;
+            case card_change_type::RESTACK:
+            case card_change_type::VISIBILITY:
+                sInPlace.insert(oChange.m_pCard);
+                break;
+            default:
+                return false;
+            }
+        }
+
+        // Changes in place damage the card where it is now, the moves cover where it was before
+        if (!sInPlace.empty())
+        {
+            for (const auto &oHolder : this->m_lCards)
+            {
+                if (sInPlace.contains(oHolder.m_pCard))
+                    vDamaged.emplace_back(oHolder.m_oPos, nCardWidth, nCardHeight);
+            }
+        }
+
+        // Drop duplicates, as cards moving around damage the same places
+        std::sort(vDamaged.begin(), vDamaged.end(), [](const rect &oRect1, const rect &oRect2)
+                  { return std::make_pair(oRect1.get_y(), oRect1.get_x()) < std::make_pair(oRect2.get_y(), oRect2.get_x()); });
+        vDamaged.erase(std::unique(vDamaged.begin(), vDamaged.end()), vDamaged.end());
+        return true;
+    }
+
     void card_table::stack_card(const number *pCard, const point &oPos)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
         // Return if the card is nullptr
@@ -103,70 +610,168 @@ namespace ac
             return;
 
         // Remove card if already present (all ocurrences)
-        this->m_lCards.remove_if([pCard](const card_holder &oHolder)
-                                 { return oHolder.m_pCard == pCard; });
+        this->erase_unlocked(pCard);
 
         // Add card
         this->m_lCards.emplace_back(pCard, oPos, true);
+        this->m_vChanges.push_back(card_change::insert(pCard, this->m_lCards.size() - 1, oPos, true));
 
-        // Render
-        if (this->m_bRenderOnChange)
-            this->render();
+        // Notify and render
+        this->commit_unlocked();
     }
 
     void card_table::repace_card(const number *pOriginalCard, const number *pNewCard)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
         // Return if any card is nullptr
-        if (pOriginalCard == nullptr || pNewCard == nullptr)
+        if (pOriginalCard == nullptr || pNewCard == nullptr || pOriginalCard == pNewCard)
             return;
 
         // Replace card (all ocurrences)
-        bool bRender = false;
+        std::size_t nLayer = 0;
         for (auto &oHolder : this->m_lCards)
         {
             if (oHolder.m_pCard == pOriginalCard)
             {
                 oHolder.m_pCard = pNewCard;
-                bRender = true;
+                this->m_vChanges.push_back(card_change::replace(nLayer, pOriginalCard, pNewCard));
             }
+            ++nLayer;
         }
 
-        // Render
-        if (bRender && this->m_bRenderOnChange)
-            this->render();
+        // Notify and render
+        this->commit_unlocked();
     }
 
     void card_table::remove_card(const number *pCard)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
         // Return if the card is nullptr
         if (pCard == nullptr)
             return;
-        std::size_t nSize = this->m_lCards.size();
 
         // Remove card (all ocurrences)
-        this->m_lCards.remove_if([pCard](const card_holder &oHolder)
-                                 { return oHolder.m_pCard == pCard; });
+        this->erase_unlocked(pCard);
 
-        // Render
-        if (nSize != this->m_lCards.size() && this->m_bRenderOnChange)
-            this->render();
+        // Notify and render
+        this->commit_unlocked();
+    }
+
+    void card_table::erase_unlocked(const number *pCard)
+    {
+        std::size_t nLayer = 0;
+        for (auto pIt = this->m_lCards.begin(); pIt != this->m_lCards.end();)
+        {
+            if (pIt->m_pCard != pCard)
+            {
+                ++pIt;
+                ++nLayer;
+                continue;
+            }
+
+            // Later layers shift down, so nLayer stays
+            this->m_vChanges.push_back(card_change::erase(pCard, nLayer, pIt->m_oPos, pIt->m_bVisible));
+            pIt = this->m_lCards.erase(pIt);
+        }
     }
 
     void card_table::remove_all_cards()
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
-        bool bEmpty = this->m_lCards.empty();
 
-        // Clear cards
-        this->m_lCards.clear();
+        // Clear cards, from the top so that every change stays valid
+        while (!this->m_lCards.empty())
+        {
+            const card_holder &oHolder = this->m_lCards.back();
+            this->m_vChanges.push_back(card_change::erase(oHolder.m_pCard, this->m_lCards.size() - 1, oHolder.m_oPos, oHolder.m_bVisible));
+            this->m_lCards.pop_back();
+        }
 
-        // Render
-        if (!bEmpty && this->m_bRenderOnChange)
-            this->render();
+        // Notify and render
+        this->commit_unlocked();
+    }
+
+    void card_table::stack_cards(std::span<const number *const> vCards, std::span<const point> vPositions)
+    {
+        change_notifier oNotifier(this);
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        if (vCards.size() != vPositions.size())
+            throw std::invalid_argument("There must be one position per card.");
+
+        // A card listed twice ends where it is last listed
+        std::unordered_map<const number *, std::size_t> mLast;
+        for (std::size_t nCard = 0; nCard < vCards.size(); ++nCard)
+        {
+            if (vCards[nCard] != nullptr)
+                mLast[vCards[nCard]] = nCard;
+        }
+
+        // Remove the cards already present (all ocurrences), in a single scan
+        std::size_t nLayer = 0;
+        for (auto pIt = this->m_lCards.begin(); pIt != this->m_lCards.end();)
+        {
+            if (!mLast.contains(pIt->m_pCard))
+            {
+                ++pIt;
+                ++nLayer;
+                continue;
+            }
+
+            // Later layers shift down, so nLayer stays
+            this->m_vChanges.push_back(card_change::erase(pIt->m_pCard, nLayer, pIt->m_oPos, pIt->m_bVisible));
+            pIt = this->m_lCards.erase(pIt);
+        }
+
+        // Add the cards
+        for (std::size_t nCard = 0; nCard < vCards.size(); ++nCard)
+        {
+            if (vCards[nCard] == nullptr || mLast[vCards[nCard]] != nCard)
+                continue;
+            this->m_lCards.emplace_back(vCards[nCard], vPositions[nCard], true);
+            this->m_vChanges.push_back(card_change::insert(vCards[nCard], this->m_lCards.size() - 1, vPositions[nCard], true));
+        }
+
+        // Notify and render
+        this->commit_unlocked();
+    }
+
+    void card_table::move_cards(std::span<const number *const> vCards, std::span<const point> vPositions)
+    {
+        change_notifier oNotifier(this);
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        if (vCards.size() != vPositions.size())
+            throw std::invalid_argument("There must be one position per card.");
+
+        // A card listed twice ends where it is last listed
+        std::unordered_map<const number *, point> mPositions;
+        for (std::size_t nCard = 0; nCard < vCards.size(); ++nCard)
+        {
+            if (vCards[nCard] != nullptr)
+                mPositions.insert_or_assign(vCards[nCard], vPositions[nCard]);
+        }
+
+        // Update horizontal positions (all ocurrences), in a single scan
+        std::size_t nLayer = 0;
+        for (auto &oHolder : this->m_lCards)
+        {
+            auto pIt = mPositions.find(oHolder.m_pCard);
+            if (pIt != mPositions.end() && oHolder.m_oPos != pIt->second)
+            {
+                this->m_vChanges.push_back(card_change::move(oHolder.m_pCard, nLayer, oHolder.m_oPos, pIt->second));
+                oHolder.m_oPos = pIt->second;
+            }
+            ++nLayer;
+        }
+
+        // Notify and render
+        this->commit_unlocked();
     }
 
     bool card_table::has_card(const number *pCard) const
@@ -234,8 +839,44 @@ namespace ac
         return this->m_lCards.size();
     }
 
+    const number *card_table::get_card_at(const point &oPoint) const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        return this->get_grid_unlocked().get_card_at(oPoint);
+    }
+
+    std::vector<const number *> card_table::get_cards_in(const rect &oRect) const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        std::vector<const number *> vCards;
+        this->get_grid_unlocked().get_cards_in(oRect, vCards);
+        return vCards;
+    }
+
+    const card_grid &card_table::get_grid_unlocked() const
+    {
+        // Build the index with the size of the rendered cards, again if the renderer resized them
+        std::size_t nCardWidth = this->m_pRenderer != nullptr ? std::max<std::size_t>(this->m_pRenderer->get_card_width(), 1) : 1;
+        std::size_t nCardHeight = this->m_pRenderer != nullptr ? std::max<std::size_t>(this->m_pRenderer->get_card_height(), 1) : 1;
+        if (this->m_pGrid == nullptr || this->m_pGrid->get_card_width() != nCardWidth || this->m_pGrid->get_card_height() != nCardHeight)
+        {
+            this->m_pGrid = std::make_unique<card_grid>(nCardWidth, nCardHeight);
+            this->m_bGridDirty = true;
+        }
+
+        // Rebuild after changes that could not be followed
+        if (this->m_bGridDirty)
+        {
+            this->m_pGrid->rebuild(this->m_lCards);
+            this->m_bGridDirty = false;
+        }
+
+        return *this->m_pGrid;
+    }
+
     void card_table::shift_horizontal_card(const number *pCard, const point &oPos)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
         // Return if the card is nullptr
@@ -243,158 +884,99 @@ namespace ac
             return;
 
         // Update horizontal position (all ocurrences)
-        bool bShifted = false;
+        std::size_t nLayer = 0;
         for (auto &oHolder : this->m_lCards)
         {
-            if (oHolder.m_pCard == pCard)
+            if (oHolder.m_pCard == pCard && oHolder.m_oPos != oPos)
             {
+                this->m_vChanges.push_back(card_change::move(pCard, nLayer, oHolder.m_oPos, oPos));
                 oHolder.m_oPos = oPos;
-                bShifted = true;
             }
+            ++nLayer;
         }
 
-        // Render
-        if (bShifted && this->m_bRenderOnChange)
-            this->render();
+        // Notify and render
+        this->commit_unlocked();
     }
 
     void card_table::shift_vertical_card(const number *pCard, std::size_t nPosition)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
         // Return if the card is nullptr
         if (pCard == nullptr)
             return;
 
-        // Find the card in the list
-        auto pIt = std::find_if(m_lCards.begin(), m_lCards.end(),
-                                [pCard](const card_holder &oHolder)
-                                {
-                                    return oHolder.m_pCard == pCard;
-                                });
-
-        // If the card is not found, return
-        if (pIt == m_lCards.cend())
-            return;
-
-        // Store the oHolder to reinsert later
-        card_holder oHolder = *pIt;
+        // Move the card, the new position is clamped to the top
+        this->restack_unlocked(pCard, [nPosition](std::size_t)
+                               { return nPosition; });
 
-        // Remove the card from its current position
-        m_lCards.erase(pIt);
-
-        // Adjust the new position if pIt is out of bounds
-        if (nPosition >= m_lCards.size())
-        {
-            // If the new position is greater than the current size, place pIt at the end
-            nPosition = m_lCards.size();
-        }
-
-        // Insert the card at the new position
-        auto pInsertPosition = m_lCards.begin();
-        std::advance(pInsertPosition, nPosition);
-        m_lCards.insert(pInsertPosition, oHolder);
-
-        // Render
-        if (this->m_bRenderOnChange)
-            this->render();
+        // Notify and render
+        this->commit_unlocked();
     }
 
     void card_table::move_card_up(const number *pCard, std::size_t nLayers)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
         // Return if the card is nullptr
         if (pCard == nullptr)
             return;
 
-        // Find the card in the list
-        auto pIt = std::find_if(m_lCards.begin(), m_lCards.end(),
-                                [pCard](const card_holder &oHolder)
-                                {
-                                    return oHolder.m_pCard == pCard;
-                                });
+        // Move the card, the new position is clamped to the top
+        this->restack_unlocked(pCard, [nLayers](std::size_t nCurrentIndex)
+                               { return nCurrentIndex + nLayers < nCurrentIndex ? BEYOND_REACH : nCurrentIndex + nLayers; });
 
-        // If the card is not found, return
-        if (pIt == m_lCards.end())
-            return;
-
-        // Get the current position of the card
-        std::size_t nCurrentIndex = std::distance(m_lCards.begin(), pIt);
-
-        // Store the holder to reinsert later
-        card_holder oHolder = *pIt;
-
-        // Remove the card from its current position
-        m_lCards.erase(pIt);
-
-        // Calculate the new position
-        std::size_t nNewIndex = nCurrentIndex + nLayers;
-        if (nNewIndex >= m_lCards.size())
-        {
-            // If the new position is greater than the current size, place pIt at the end
-            nNewIndex = m_lCards.size();
-        }
-
-        // Insert the card at the new position
-        auto pInsertPosition = m_lCards.begin();
-        std::advance(pInsertPosition, nNewIndex);
-        m_lCards.insert(pInsertPosition, oHolder);
-
-        // Render
-        if (this->m_bRenderOnChange)
-            this->render();
+        // Notify and render
+        this->commit_unlocked();
     }
 
     void card_table::move_card_down(const number *pCard, std::size_t nLayers)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
         if (pCard == nullptr)
             return; // Return if the card is nullptr
 
+        // Move the card, the new position is clamped to the bottom
+        this->restack_unlocked(pCard, [nLayers](std::size_t nCurrentIndex)
+                               { return nCurrentIndex > nLayers ? nCurrentIndex - nLayers : 0; });
+
+        // Notify and render
+        this->commit_unlocked();
+    }
+
+    void card_table::restack_unlocked(const number *pCard, const std::function<std::size_t(std::size_t)> &fnNewIndex)
+    {
         // Find the card in the list
         auto pIt = std::find_if(m_lCards.begin(), m_lCards.end(),
-                                [pCard](const card_holder &holder)
+                                [pCard](const card_holder &oHolder)
                                 {
-                                    return holder.m_pCard == pCard;
+                                    return oHolder.m_pCard == pCard;
                                 });
 
         // If the card is not found, return
         if (pIt == m_lCards.end())
             return;
 
-        // Get the current position of the card
+        // Get the current and new positions of the card, without counting itself
         std::size_t nCurrentIndex = std::distance(m_lCards.begin(), pIt);
+        std::size_t nNewIndex = std::min(fnNewIndex(nCurrentIndex), m_lCards.size() - 1);
+        if (nNewIndex == nCurrentIndex)
+            return;
 
-        // Store the holder to reinsert later
-        card_holder oHolder = *pIt;
-
-        // Remove the card from its current position
-        m_lCards.erase(pIt);
-
-        // Ensure the new index does not exceed the bounds of the list
-        if (nCurrentIndex > nLayers)
-        {
-            // Insert the card at the new position
-            std::size_t nNewIndex = nCurrentIndex - nLayers;
-            auto insertPosition = m_lCards.begin();
-            std::advance(insertPosition, nNewIndex);
-            m_lCards.insert(insertPosition, oHolder);
-        }
-        else
-        {
-            // Insert the card at the new front
-            m_lCards.push_front(oHolder);
-        }
-
-        // Render
-        if (this->m_bRenderOnChange)
-            this->render();
+        // Relink the card at the new position
+        card_change oChange = card_change::restack(pCard, nCurrentIndex, nNewIndex);
+        oChange.apply(this->m_lCards);
+        this->m_vChanges.push_back(oChange);
     }
 
     void card_table::horizontal_swap_card(const number *pCard1, const number *pCard2)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
         // Return if any card is nullptr
@@ -403,46 +985,69 @@ namespace ac
 
         card_holder *pHolder1 = nullptr;
         card_holder *pHolder2 = nullptr;
+        std::size_t nLayer1 = 0;
+        std::size_t nLayer2 = 0;
 
         // Locate the holders
+        std::size_t nLayer = 0;
         for (auto &oHolder : this->m_lCards)
         {
-            if (oHolder.m_pCard == pCard1)
+            if (oHolder.m_pCard == pCard1 && pHolder1 == nullptr)
+            {
                 pHolder1 = &oHolder;
-            else if (oHolder.m_pCard == pCard2)
+                nLayer1 = nLayer;
+            }
+            else if (oHolder.m_pCard == pCard2 && pHolder2 == nullptr)
+            {
                 pHolder2 = &oHolder;
+                nLayer2 = nLayer;
+            }
+            ++nLayer;
 
             if (pHolder1 != nullptr && pHolder2 != nullptr)
                 break;
         }
 
         // Swap horizontal positions
-        if (pHolder1 != nullptr && pHolder2 != nullptr)
+        if (pHolder1 != nullptr && pHolder2 != nullptr && pHolder1->m_oPos != pHolder2->m_oPos)
         {
+            this->m_vChanges.push_back(card_change::move(pCard1, nLayer1, pHolder1->m_oPos, pHolder2->m_oPos));
+            this->m_vChanges.push_back(card_change::move(pCard2, nLayer2, pHolder2->m_oPos, pHolder1->m_oPos));
             std::swap(pHolder1->m_oPos, pHolder2->m_oPos);
-            // Render
-            if (this->m_bRenderOnChange)
-                this->render();
         }
+
+        // Notify and render
+        this->commit_unlocked();
     }
 
     void card_table::vertical_swap_card(const number *pCard1, const number *pCard2)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
-        if (pCard1 == nullptr || pCard2 == nullptr)
+        if (pCard1 == nullptr || pCard2 == nullptr || pCard1 == pCard2)
             return; // Return if any card is nullptr
 
         card_holder *pHolder1 = nullptr;
         card_holder *pHolder2 = nullptr;
+        std::size_t nLayer1 = 0;
+        std::size_t nLayer2 = 0;
 
         // Locate the holders
+        std::size_t nLayer = 0;
         for (auto &oHolder : this->m_lCards)
         {
-            if (oHolder.m_pCard == pCard1)
+            if (oHolder.m_pCard == pCard1 && pHolder1 == nullptr)
+            {
                 pHolder1 = &oHolder;
-            else if (oHolder.m_pCard == pCard2)
+                nLayer1 = nLayer;
+            }
+            else if (oHolder.m_pCard == pCard2 && pHolder2 == nullptr)
+            {
                 pHolder2 = &oHolder;
+                nLayer2 = nLayer;
+            }
+            ++nLayer;
 
             if (pHolder1 != nullptr && pHolder2 != nullptr)
                 break;
@@ -451,45 +1056,76 @@ namespace ac
         // Swap vertical positions
         if (pHolder1 && pHolder2)
         {
+            this->m_vChanges.push_back(card_change::replace(nLayer1, pCard1, pCard2));
+            this->m_vChanges.push_back(card_change::replace(nLayer2, pCard2, pCard1));
             std::swap(pHolder1->m_pCard, pHolder2->m_pCard);
-            // Render
-            if (this->m_bRenderOnChange)
-                this->render();
         }
+
+        // Notify and render
+        this->commit_unlocked();
     }
 
     void card_table::full_swap_card(const number *pCard1, const number *pCard2)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
         // Return if any card is nullptr
-        if (pCard1 == nullptr || pCard2 == nullptr)
+        if (pCard1 == nullptr || pCard2 == nullptr || pCard1 == pCard2)
             return;
 
         card_holder *pHolder1 = nullptr;
         card_holder *pHolder2 = nullptr;
+        std::size_t nLayer1 = 0;
+        std::size_t nLayer2 = 0;
 
         // Locate the holders
+        std::size_t nLayer = 0;
         for (auto &oHolder : this->m_lCards)
         {
-            if (oHolder.m_pCard == pCard1)
+            if (oHolder.m_pCard == pCard1 && pHolder1 == nullptr)
+            {
                 pHolder1 = &oHolder;
-            else if (oHolder.m_pCard == pCard2)
+                nLayer1 = nLayer;
+            }
+            else if (oHolder.m_pCard == pCard2 && pHolder2 == nullptr)
+            {
                 pHolder2 = &oHolder;
+                nLayer2 = nLayer;
+            }
+            ++nLayer;
 
             if (pHolder1 != nullptr && pHolder2 != nullptr)
                 break;
         }
+        if (pHolder1 == nullptr || pHolder2 == nullptr)
+            return;
 
         // Swap horizontal positions
-        if (pHolder1 != nullptr && pHolder2 != nullptr)
+        if (pHolder1->m_oPos != pHolder2->m_oPos)
         {
+            this->m_vChanges.push_back(card_change::move(pCard1, nLayer1, pHolder1->m_oPos, pHolder2->m_oPos));
+            this->m_vChanges.push_back(card_change::move(pCard2, nLayer2, pHolder2->m_oPos, pHolder1->m_oPos));
             std::swap(pHolder1->m_oPos, pHolder2->m_oPos);
-            std::swap(pHolder1->m_oPos, pHolder2->m_oPos);
-            // Render
-            if (this->m_bRenderOnChange)
-                this->render();
         }
+
+        // Swap layers: the lower card goes up to the other one, which then goes down to its place
+        const number *pLower = nLayer1 < nLayer2 ? pCard1 : pCard2;
+        const number *pUpper = nLayer1 < nLayer2 ? pCard2 : pCard1;
+        std::size_t nLower = std::min(nLayer1, nLayer2);
+        std::size_t nUpper = std::max(nLayer1, nLayer2);
+        card_change oUp = card_change::restack(pLower, nLower, nUpper);
+        oUp.apply(this->m_lCards);
+        this->m_vChanges.push_back(oUp);
+        if (nUpper - 1 != nLower)
+        {
+            card_change oDown = card_change::restack(pUpper, nUpper - 1, nLower);
+            oDown.apply(this->m_lCards);
+            this->m_vChanges.push_back(oDown);
+        }
+
+        // Notify and render
+        this->commit_unlocked();
     }
 
     bool card_table::is_above(const number *pCardAbove, const number *pCardBelow) const
@@ -575,6 +1211,7 @@ namespace ac
 
     void card_table::set_card_visible(const number *pCard, bool bVisible)
     {
+        change_notifier oNotifier(this);
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
         // Find the card in the list
@@ -584,16 +1221,310 @@ namespace ac
                                     return oHolder.m_pCard == pCard;
                                 });
 
-        // If the card is not found, return
-        if (pIt == m_lCards.cend())
+        // If the card is not found or already in that state, return
+        if (pIt == m_lCards.cend() || (*pIt).m_bVisible == bVisible)
             return;
 
-        // Return state
+        // Set state
         (*pIt).m_bVisible = bVisible;
+        this->m_vChanges.push_back(card_change::visibility(pCard, std::distance(m_lCards.begin(), pIt), bVisible));
 
-        // Render
-        if (this->m_bRenderOnChange)
-            this->render();
+        // Notify and render
+        this->commit_unlocked();
+    }
+
+    void card_table::to_json(std::ostream &oOstream) const
+    {
+        std::string sBuffer;
+        this->to_json(sBuffer);
+        oOstream.write(sBuffer.data(), sBuffer.size());
+    }
+
+    void card_table::to_json(std::string &sBuffer) const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+
+        sBuffer.append("{\"cards\":[");
+
+        bool bFirst = true;
+        for (const auto &oHolder : this->m_lCards)
+        {
+            if (!bFirst)
+                sBuffer.push_back(',');
+            sBuffer.append("{\"suit\":");
+            write_json_string(sBuffer, oHolder.m_pCard->get_suit()->get_name());
+            sBuffer.append(",\"number\":");
+            write_json_string(sBuffer, oHolder.m_pCard->get_name());
+            sBuffer.append(",\"x\":");
+            sBuffer.append(std::to_string(oHolder.m_oPos.get_x()));
+            sBuffer.append(",\"y\":");
+            sBuffer.append(std::to_string(oHolder.m_oPos.get_y()));
+            sBuffer.append(oHolder.m_bVisible ? ",\"visible\":true}" : ",\"visible\":false}");
+            bFirst = false;
+        }
+
+        sBuffer.append("]}");
+    }
+
+    std::string card_table::to_json() const
+    {
+        std::string sBuffer;
+        this->to_json(sBuffer);
+        return sBuffer;
+    }
+
+    /// Magic of the binary snapshots.
+    static constexpr std::string_view SNAPSHOT_MAGIC = "ACTS";
+
+    /// Version of the binary snapshots.
+    static constexpr std::uint64_t SNAPSHOT_VERSION = 1;
+
+    void card_table::save_snapshot(std::string &sBuffer, const card_index &oIndex) const
+    {
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        write_snapshot(sBuffer, this->m_lCards, oIndex);
+    }
+
+    void card_table::write_snapshot(std::string &sBuffer, const std::list<card_holder> &lHolders, const card_index &oIndex)
+    {
+        std::size_t nStart = sBuffer.size();
+
+        // Header
+        sBuffer.append(SNAPSHOT_MAGIC);
+        write_varint(sBuffer, SNAPSHOT_VERSION);
+        write_fixed64(sBuffer, oIndex.get_fingerprint());
+        write_varint(sBuffer, lHolders.size());
+
+        // Cards
+        for (const auto &oHolder : lHolders)
+        {
+            std::uint32_t nId = oIndex.get_id(oHolder.m_pCard);
+            if (nId == card_index::INVALID_ID)
+            {
+                sBuffer.resize(nStart);
+                throw std::invalid_argument("Card \'" + oHolder.m_pCard->get_name() + "\' is not part of the indexed deck.");
+            }
+            write_varint(sBuffer, nId);
+            write_varint(sBuffer, oHolder.m_oPos.get_x());
+            write_varint(sBuffer, oHolder.m_oPos.get_y());
+        }
+
+        // Visibility bitmap
+        std::size_t nBitmap = sBuffer.size();
+        sBuffer.append((lHolders.size() + 7) / 8, '\0');
+        std::size_t nCard = 0;
+        for (const auto &oHolder : lHolders)
+        {
+            if (oHolder.m_bVisible)
+                sBuffer[nBitmap + nCard / 8] |= static_cast<char>(1 << (nCard % 8));
+            ++nCard;
+        }
+    }
+
+    std::string card_table::save_snapshot(const card_index &oIndex) const
+    {
+        std::string sBuffer;
+        this->save_snapshot(sBuffer, oIndex);
+        return sBuffer;
+    }
+
+    std::size_t card_table::load_snapshot(std::string_view sData, const card_index &oIndex)
+    {
+        std::list<card_holder> lHolders;
+        std::size_t nSize = read_snapshot(sData, oIndex, lHolders);
+        this->set_holders(std::move(lHolders));
+        return nSize;
+    }
+
+    std::size_t card_table::read_snapshot(std::string_view sData, const card_index &oIndex, std::list<card_holder> &lHolders)
+    {
+        const char *pData = sData.data();
+        const char *pEnd = pData + sData.size();
+        auto fail = [](const char *sMessage)
+        {
+            throw std::runtime_error(std::string("Invalid table snapshot: ") + sMessage + ".");
+        };
+
+        // Header
+        std::uint64_t nVersion = 0;
+        if (sData.substr(0, SNAPSHOT_MAGIC.size()) != SNAPSHOT_MAGIC)
+            fail("bad magic");
+        pData += SNAPSHOT_MAGIC.size();
+        if (!read_varint(pData, pEnd, nVersion) || nVersion != SNAPSHOT_VERSION)
+            fail("unsupported version");
+        if (pEnd - pData < 8)
+            fail("truncated data");
+        if (read_fixed64(pData) != oIndex.get_fingerprint())
+            fail("written against a different deck");
+        pData += 8;
+        std::uint64_t nCount = 0;
+        if (!read_varint(pData, pEnd, nCount) || nCount > static_cast<std::uint64_t>(pEnd - pData))
+            fail("truncated data");
+
+        // Cards, each at most once
+        lHolders.clear();
+        std::vector<bool> vLoaded(oIndex.get_card_count(), false);
+        for (std::uint64_t nCard = 0; nCard < nCount; ++nCard)
+        {
+            std::uint64_t nId = 0, nX = 0, nY = 0;
+            if (!read_varint(pData, pEnd, nId) || !read_varint(pData, pEnd, nX) || !read_varint(pData, pEnd, nY))
+                fail("truncated data");
+            const number *pCard = nId < card_index::INVALID_ID ? oIndex.get_card(static_cast<std::uint32_t>(nId)) : nullptr;
+            if (pCard == nullptr)
+                fail("unknown card identifier");
+            if (vLoaded[nId])
+                fail("duplicated card identifier");
+            vLoaded[nId] = true;
+            lHolders.emplace_back(pCard, point(nX, nY), false);
+        }
+
+        // Visibility bitmap
+        std::size_t nBitmapSize = (nCount + 7) / 8;
+        if (static_cast<std::size_t>(pEnd - pData) < nBitmapSize)
+            fail("truncated data");
+        std::size_t nCard = 0;
+        for (auto &oHolder : lHolders)
+        {
+            oHolder.m_bVisible = (static_cast<unsigned char>(pData[nCard / 8]) >> (nCard % 8)) & 1;
+            ++nCard;
+        }
+        pData += nBitmapSize;
+
+        return pData - sData.data();
+    }
+
+    bool intersects_any(std::span<const rect> vRegions, const rect &oArea)
+    {
+        return std::any_of(vRegions.begin(), vRegions.end(), [&oArea](const rect &oRegion)
+                           { return oRegion.intersects(oArea); });
+    }
+
+    void merge_exposed(std::vector<rect> &vExposed, std::size_t nStart, const rect &oRun)
+    {
+        // A run continues the rectangle of the card above it when they match
+        auto pAbove = std::find_if(vExposed.begin() + nStart, vExposed.end(), [&oRun](const rect &oRect)
+                                   { return oRect.get_x() == oRun.get_x() && oRect.get_width() == oRun.get_width() &&
+                                            oRect.get_y() + oRect.get_height() == oRun.get_y(); });
+        if (pAbove != vExposed.end())
+            *pAbove = rect(pAbove->get_x(), pAbove->get_y(), pAbove->get_width(), pAbove->get_height() + oRun.get_height());
+        else
+            vExposed.push_back(oRun);
+    }
+
+    void cover_row(std::vector<row_span> &vCovered, const row_span &oSpan, std::vector<row_span> &vUncovered)
+    {
+        // The covered spans are sorted and apart; the ones touching the new span are merged with it
+        auto pFirst = std::lower_bound(vCovered.begin(), vCovered.end(), oSpan.first, [](const row_span &oCovered, std::size_t nX)
+                                       { return oCovered.second < nX; });
+        auto pLast = pFirst;
+        std::size_t nX = oSpan.first;
+        row_span oMerged = oSpan;
+        for (; pLast != vCovered.end() && pLast->first <= oSpan.second; ++pLast)
+        {
+            if (pLast->first > nX)
+                vUncovered.emplace_back(nX, pLast->first);
+            nX = std::max(nX, pLast->second);
+            oMerged.first = std::min(oMerged.first, pLast->first);
+            oMerged.second = std::max(oMerged.second, pLast->second);
+        }
+        if (nX < oSpan.second)
+            vUncovered.emplace_back(nX, oSpan.second);
+        vCovered.insert(vCovered.erase(pFirst, pLast), oMerged);
+    }
+
+    void compose_tile(const card_renderer *pRenderer, std::span<const card_holder *const> vCards, std::span<const rect> vRegions, bool bClip, composed_tile &oTile)
+    {
+        // From the top, find the spans of every card not covered by the cards above it,
+        // tracked as sorted spans of columns per row of the band
+        std::size_t nCardWidth = std::max<std::size_t>(pRenderer->get_card_width(), 1);
+        std::size_t nCardHeight = std::max<std::size_t>(pRenderer->get_card_height(), 1);
+        std::vector<std::vector<row_span>> vCovered(oTile.m_nBottom - oTile.m_nTop);
+        std::vector<row_span> vUncovered;
+        std::vector<row_span> vDrawn;
+        std::vector<rect> vGlyphs;
+        oTile.m_vStart.reserve(vCards.size() + 1);
+        for (const card_holder *pHolder : vCards)
+        {
+            std::size_t nStart = oTile.m_vExposed.size();
+            oTile.m_vStart.push_back(nStart);
+            bool bGlyphs = false;
+            vGlyphs.clear();
+
+            // Exposed runs of every row of the band. When clipping, cells outside the
+            // regions are not drawn, but still hide the cards below
+            std::size_t nX = pHolder->m_oPos.get_x();
+            std::size_t nY = pHolder->m_oPos.get_y();
+            std::size_t nFirstRow = std::max(nY, oTile.m_nTop) - nY;
+            std::size_t nEndRow = std::min(nY + nCardHeight, oTile.m_nBottom);
+            for (std::size_t nRow = nFirstRow; nY + nRow < nEndRow; ++nRow)
+            {
+                std::size_t nCellY = nY + nRow;
+                vUncovered.clear();
+                cover_row(vCovered[nCellY - oTile.m_nTop], row_span(nX, nX + nCardWidth), vUncovered);
+                if (!bClip)
+                {
+                    for (const row_span &oRun : vUncovered)
+                        merge_exposed(oTile.m_vExposed, nStart, rect(oRun.first, nCellY, oRun.second - oRun.first, 1));
+                    continue;
+                }
+                if (vUncovered.empty())
+                    continue;
+
+                // Drawn spans: the regions, and the wide glyphs cut by their edges, drawn whole
+                vDrawn.clear();
+                bool bCut = false;
+                for (const rect &oRegion : vRegions)
+                {
+                    if (nCellY < oRegion.get_y() || nCellY >= oRegion.get_y() + oRegion.get_height() || oRegion.get_width() == 0)
+                        continue;
+                    std::size_t nLeft = oRegion.get_x();
+                    std::size_t nRight = nLeft + oRegion.get_width();
+                    vDrawn.emplace_back(nLeft, nRight);
+                    bCut = bCut || (nLeft > nX && nLeft < nX + nCardWidth) || (nRight > nX && nRight < nX + nCardWidth);
+                }
+                if (bCut)
+                {
+                    if (!bGlyphs)
+                    {
+                        pRenderer->get_wide_glyphs(pHolder->m_pCard, vGlyphs);
+                        bGlyphs = true;
+                    }
+                    for (const rect &oGlyph : vGlyphs)
+                    {
+                        rect oCells(nX + oGlyph.get_x(), nY + oGlyph.get_y(), oGlyph.get_width(), oGlyph.get_height());
+                        if (oGlyph.get_y() <= nRow && nRow < oGlyph.get_y() + oGlyph.get_height() && intersects_any(vRegions, oCells))
+                            vDrawn.emplace_back(oCells.get_x(), oCells.get_x() + oCells.get_width());
+                    }
+                }
+                if (vDrawn.empty())
+                    continue;
+
+                // Merge the drawn spans, then keep their uncovered parts
+                std::sort(vDrawn.begin(), vDrawn.end());
+                std::size_t nMerged = 0;
+                for (std::size_t nDrawn = 1; nDrawn < vDrawn.size(); ++nDrawn)
+                {
+                    if (vDrawn[nDrawn].first <= vDrawn[nMerged].second)
+                        vDrawn[nMerged].second = std::max(vDrawn[nMerged].second, vDrawn[nDrawn].second);
+                    else
+                        vDrawn[++nMerged] = vDrawn[nDrawn];
+                }
+                vDrawn.resize(nMerged + 1);
+                auto pDrawn = vDrawn.cbegin();
+                for (const row_span &oRun : vUncovered)
+                {
+                    while (pDrawn != vDrawn.cend() && pDrawn->second <= oRun.first)
+                        ++pDrawn;
+                    for (auto pIt = pDrawn; pIt != vDrawn.cend() && pIt->first < oRun.second; ++pIt)
+                    {
+                        std::size_t nLeft = std::max(oRun.first, pIt->first);
+                        std::size_t nRight = std::min(oRun.second, pIt->second);
+                        merge_exposed(oTile.m_vExposed, nStart, rect(nLeft, nCellY, nRight - nLeft, 1));
+                    }
+                }
+            }
+        }
+        oTile.m_vStart.push_back(oTile.m_vExposed.size());
     }
 
 }
@@ -19,61 +19,57 @@
 
 #include "deck.h"
 
-#include <sstream>
-#include <iostream>
-#include <array>
+#include "json.h"
+
+#include <stdexcept>
 
 namespace ac
 {
 
-    static std::array<std::string, 4> aPokerNames = {
-        "heart", "diamond", "club", "spade"};
-
-    static std::array<std::string, 4> aPokerDisplays = {
-        "\u2665", "\u2666", "\u2663", "\u2660"};
-
-    static std::array<std::string, 4> aSpanishNames = {
-        "gold", "cup", "club", "sword"};
+    deck *deck::generate_poker_deck(std::size_t nJokers)
+    {
+        return deck::generate_deck(POKER_DECK, nJokers);
+    }
 
-    static std::array<std::string, 4> aSpanishDisplays = {
-        "\U0001F3C5", "\U0001F3C6", "\U0001F3CF", "\U00002694"};
+    deck *deck::generate_spanish_deck(std::size_t nJokers)
+    {
+        return deck::generate_deck(SPANISH_DECK, nJokers);
+    }
 
-    deck *deck::generate_poker_deck(std::size_t nJokers)
+    deck *deck::generate_deck(const deck_definition &oDefinition, std::size_t nJokers)
     {
-        deck *pDeck = new deck("poker_deck", "Poker deck");
-        for (std::size_t nPos = 0; nPos < 4; ++nPos)
+        deck *pDeck = new deck(std::string(oDefinition.get_name()), std::string(oDefinition.get_display_name()));
+
+        // The deck is not shared yet: fill it without locking
+        for (const suit_definition &oSuitDefinition : oDefinition.get_suits())
         {
-            suit *pSuit = pDeck->create_suit(aPokerNames[nPos], aPokerDisplays[nPos]);
-            pSuit->create_numer("1", "A");
-            for (std::size_t nNumber = 2; nNumber < 11; ++nNumber)
-                pSuit->create_numer(std::to_string(nNumber));
-            pSuit->create_numer("11", "J");
-            pSuit->create_numer("12", "Q");
-            pSuit->create_numer("13", "K");
+            suit *pSuit = pDeck->emplace_suit_unlocked(std::string(oSuitDefinition.get_name()), std::string(oSuitDefinition.get_display_name()));
+            for (const number_definition &oNumberDefinition : oSuitDefinition.get_numbers())
+                pSuit->emplace_number_unlocked(std::string(oNumberDefinition.get_name()), std::string(oNumberDefinition.get_display_name()));
         }
-        suit *pJokers = pDeck->create_suit("joker", "Joker");
+
+        // Jokers are generated on demand
+        const suit_definition &oJokers = oDefinition.get_jokers();
+        suit *pJokers = pDeck->emplace_suit_unlocked(std::string(oJokers.get_name()), std::string(oJokers.get_display_name()));
         for (std::size_t nCount = 0; nCount < nJokers; ++nCount)
-            pJokers->create_numer(std::to_string(nCount), "J");
+            pJokers->emplace_number_unlocked(std::to_string(nCount), "J");
+
         return pDeck;
     }
 
-    deck *deck::generate_spanish_deck(std::size_t nJokers)
+    deck *deck::from_json(const json_item *pItem)
     {
-        deck *pDeck = new deck("spanish_deck", "Spanish Deck");
-        for (std::size_t nPos = 0; nPos < 4; ++nPos)
+        if (pItem == nullptr)
+            throw std::invalid_argument("Json deck item is null.");
+
+        deck_builder oBuilder(pItem->get_string("name"), pItem->get_string("display_name"));
+        for (const json_item *pSuitItem : pItem->get_array("suits"))
         {
-            suit *pSuit = pDeck->create_suit(aSpanishNames[nPos], aSpanishDisplays[nPos]);
-            pSuit->create_numer("1", "A");
-            for (std::size_t nNumber = 2; nNumber < 8; ++nNumber)
-                pSuit->create_numer(std::to_string(nNumber));
-            pSuit->create_numer("8", "S");
-            pSuit->create_numer("9", "C");
-            pSuit->create_numer("10", "R");
+            oBuilder.add_suit(pSuitItem->get_string("name"), pSuitItem->get_string("display_name"));
+            for (const json_item *pNumberItem : pSuitItem->get_array("numbers"))
+                oBuilder.add_number(pNumberItem->get_string("name"), pNumberItem->get_string("display_name"));
         }
-        suit *pJokers = pDeck->create_suit("joker", "Joker");
-        for (std::size_t nCount = 0; nCount < nJokers; ++nCount)
-            pJokers->create_numer(std::to_string(nCount), "J");
-        return pDeck;
+        return oBuilder.release();
     }
 
     deck::deck(const std::string &sName)
@@ -174,6 +170,18 @@ namespace ac
         return pSuit;
     }
 
+    suit *deck::emplace_suit_unlocked(const std::string &sName, const std::string &sDisplayName)
+    {
+        suit *pSuit = new suit(this, sName, sDisplayName);
+        auto [pIter, bInserted] = this->m_mSuits.try_emplace(sName, pSuit);
+        if (!bInserted)
+        {
+            delete pIter->second;
+            pIter->second = pSuit;
+        }
+        return pSuit;
+    }
+
     const suit *deck::get_suit(const std::string &sName) const
     {
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
@@ -254,34 +262,77 @@ namespace ac
     }
 
     void deck::to_json(std::ostream &oOstream) const
+    {
+        std::string sBuffer;
+        this->to_json(sBuffer);
+        oOstream.write(sBuffer.data(), sBuffer.size());
+    }
+
+    void deck::to_json(std::string &sBuffer) const
     {
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
-        oOstream << "deck: { name: ";
-        oOstream << this->m_sName;
-        oOstream << ", display_name: ";
-        oOstream << this->m_sDisplayName;
-        oOstream << ", suits: ";
+        sBuffer.append("{\"name\":");
+        write_json_string(sBuffer, this->m_sName);
+        sBuffer.append(",\"display_name\":");
+        write_json_string(sBuffer, this->m_sDisplayName);
+        sBuffer.append(",\"suits\":[");
 
-        auto pIter = this->m_mSuits.cbegin();
-        while (pIter != this->m_mSuits.cend())
+        bool bFirst = true;
+        for (const auto &oIter : this->m_mSuits)
         {
-            pIter->second->to_json(oOstream);
-
-            if (std::next(pIter) != this->m_mSuits.cend())
-                oOstream.write(", ", 2);
-
-            pIter = std::next(pIter);
+            if (!bFirst)
+                sBuffer.push_back(',');
+            oIter.second->to_json(sBuffer);
+            bFirst = false;
         }
 
-        oOstream << " ] }";
+        sBuffer.append("]}");
     }
 
     std::string deck::to_json() const
     {
-        std::ostringstream oStream;
-        this->to_json(oStream);
-        return oStream.str();
+        std::string sBuffer;
+        this->to_json(sBuffer);
+        return sBuffer;
+    }
+
+    deck_builder::deck_builder(const std::string &sName, const std::string &sDisplayName)
+        : m_pSuit(nullptr)
+    {
+        if (sName.empty())
+            throw std::runtime_error("Json deck has an empty name.");
+        this->m_pDeck.reset(new deck(sName, sDisplayName));
+    }
+
+    void deck_builder::add_suit(const std::string &sName, const std::string &sDisplayName)
+    {
+        const std::string &sDeckName = this->m_pDeck->m_sName;
+        if (sName.empty())
+            throw std::runtime_error("Json deck \'" + sDeckName + "\' has a suit with an empty name.");
+        if (this->m_pDeck->m_mSuits.find(sName) != this->m_pDeck->m_mSuits.cend())
+            throw std::runtime_error("Json deck \'" + sDeckName + "\' has a duplicated suit \'" + sName + "\'.");
+
+        this->m_pSuit = this->m_pDeck->emplace_suit_unlocked(sName, sDisplayName);
+    }
+
+    void deck_builder::add_number(const std::string &sName, const std::string &sDisplayName)
+    {
+        if (this->m_pSuit == nullptr)
+            throw std::runtime_error("Json number \'" + sName + "\' is not in a suit.");
+        const std::string &sSuitName = this->m_pSuit->m_sName;
+        if (sName.empty())
+            throw std::runtime_error("Json suit \'" + sSuitName + "\' has a number with an empty name.");
+        if (this->m_pSuit->m_mNumbers.find(sName) != this->m_pSuit->m_mNumbers.cend())
+            throw std::runtime_error("Json suit \'" + sSuitName + "\' has a duplicated number \'" + sName + "\'.");
+
+        this->m_pSuit->emplace_number_unlocked(sName, sDisplayName);
+    }
+
+    deck *deck_builder::release()
+    {
+        this->m_pSuit = nullptr;
+        return this->m_pDeck.release();
     }
 
 } // namespace ac
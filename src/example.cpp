@@ -20,8 +20,10 @@
 #include "deck.h"
 #include "ansi_card_renderer.h"
 #include "ansi_card_table.h"
+#include "card_layout.h"
 
 #include <iostream>
+#include <sstream>
 
 namespace ac
 {
@@ -32,6 +34,49 @@ namespace ac
         static void display_suit(ansi_card_table *pTable, suit *pSuit, std::size_t x, std::size_t y);
         static void display_deck(ansi_card_table *pTable, deck *pDeck, std::size_t x, std::size_t y);
         static void display_suit_joker(ansi_card_table *pTable, suit *pSuit, std::size_t x, std::size_t y);
+        static std::string record_composition(deck *pDeck, bool bParallelComposition);
+
+        /**
+         * @class recording_renderer
+         * @brief Renderer writing a line per call instead of drawing, with large cards holding wide glyphs.
+         */
+        class recording_renderer : public card_renderer
+        {
+        public:
+            virtual void render_card(const number *pCard, point nPos) const override
+            {
+                this->m_oRecord << "card " << pCard->get_name() << " " << nPos.get_x() << "," << nPos.get_y() << "\n";
+            }
+
+            virtual void render_card(const number *pCard, point nPos, std::span<const rect> vExposed) const override
+            {
+                this->m_oRecord << "card " << pCard->get_name() << " " << nPos.get_x() << "," << nPos.get_y();
+                for (const rect &oRect : vExposed)
+                    this->m_oRecord << " " << oRect.get_x() << "," << oRect.get_y() << "," << oRect.get_width() << "," << oRect.get_height();
+                this->m_oRecord << "\n";
+            }
+
+            virtual void render_table() const override { this->m_oRecord << "table\n"; }
+
+            virtual void render_table(std::span<const rect>) const override { this->m_oRecord << "regions\n"; }
+
+            virtual bool can_render_regions() const override { return true; }
+
+            virtual void get_wide_glyphs(const number *, std::vector<rect> &vGlyphs) const override
+            {
+                vGlyphs.emplace_back(2, 1, 2, 1);
+                vGlyphs.emplace_back(45, 28, 2, 1);
+            }
+
+            virtual std::size_t get_card_width() const override { return 48; }
+
+            virtual std::size_t get_card_height() const override { return 30; }
+
+            std::string get_record() const { return this->m_oRecord.str(); }
+
+        private:
+            mutable std::ostringstream m_oRecord; ///< One line per call.
+        };
 
         void display_poker_deck()
         {
@@ -97,45 +142,75 @@ namespace ac
             ansi::clear_screen();
         }
 
+        bool check_parallel_composition()
+        {
+            deck *pDeck = deck::generate_poker_deck(4);
+            bool bSame = record_composition(pDeck, true) == record_composition(pDeck, false);
+            delete pDeck;
+            return bSame;
+        }
+
+        std::string record_composition(deck *pDeck, bool bParallelComposition)
+        {
+            recording_renderer oRenderer;
+            card_table oTable(&oRenderer, false);
+            oTable.set_parallel_composition(bParallelComposition);
+
+            // Overlapping cards at fixed pseudo-random positions
+            std::vector<const number *> vCards;
+            for (suit *pSuit : pDeck->get_suits())
+                for (number *pNumber : pSuit->get_numbers())
+                    vCards.push_back(pNumber);
+            std::vector<point> vPositions;
+            std::uint32_t nSeed = 12345;
+            auto next = [&nSeed](std::size_t nBound)
+            {
+                nSeed = nSeed * 1103515245u + 12345u;
+                return static_cast<std::size_t>(nSeed >> 16) % nBound;
+            };
+            for (std::size_t nCard = 0; nCard < vCards.size(); ++nCard)
+                vPositions.emplace_back(next(200), next(120));
+            oTable.stack_cards(vCards, vPositions);
+            oTable.render_safe();
+
+            // Moves repaint damaged regions
+            oTable.set_render_on_change(true);
+            for (std::size_t nMove = 0; nMove < 16; ++nMove)
+                oTable.shift_horizontal_card(vCards[next(vCards.size())], point(next(200), next(120)));
+
+            return oRenderer.get_record();
+        }
+
         void display_suit(ansi_card_table *pTable, suit *pSuit, std::size_t x, std::size_t y)
         {
             // Get the number count
             std::size_t nCount = pSuit->get_number_count();
 
-            // Get the renderer from the table
-            const ansi_card_renderer *pRenderer = static_cast<const ansi_card_renderer *>(pTable->get_renderer());
-
-            // Calculate the distance between cards (horzontal)
-            std::size_t nStep = pRenderer->get_card_width() + 1;
-
-            // Iterate all numbers in the suit
+            // Get the cards by number
+            std::vector<const number *> vCards;
             for (std::size_t nPos = 0; nPos < nCount; ++nPos)
-            {
-                // Get the card by number
-                number *pCard = pSuit->get_number(std::to_string(nPos + 1));
+                vCards.push_back(pSuit->get_number(std::to_string(nPos + 1)));
 
-                // Display the card
-                pTable->stack_card(pCard, point(x + nPos * nStep, y));
-            }
+            // Lay the cards out in a row, with the size of the cards of the table renderer
+            std::vector<point> vPositions;
+            card_layout(pTable->get_renderer()).row(vPositions, point(x, y), nCount);
+
+            // Display the cards
+            pTable->stack_cards(vCards, vPositions);
         }
 
         void display_suit_joker(ansi_card_table *pTable, suit *pSuit, std::size_t x, std::size_t y)
         {
             // Get the jokers
             std::vector<number *> vNums = pSuit->get_numbers();
+            std::vector<const number *> vCards(vNums.begin(), vNums.end());
 
-            // Get the renderer from the table
-            const ansi_card_renderer *pRenderer = static_cast<const ansi_card_renderer *>(pTable->get_renderer());
-
-            // Calculate the distance between cards (horzontal)
-            std::size_t nStep = pRenderer->get_card_width() + 1;
+            // Lay the cards out in a row, with the size of the cards of the table renderer
+            std::vector<point> vPositions;
+            card_layout(pTable->get_renderer()).row(vPositions, point(x, y), vCards.size());
 
-            // Iterate all numbers in the suit
-            for (std::size_t nPos = 0; nPos < vNums.size(); ++nPos)
-            {
-                // Display the card
-                pTable->stack_card(vNums[nPos], point(x + nPos * nStep, y));
-            }
+            // Display the cards
+            pTable->stack_cards(vCards, vPositions);
         }
 
         void display_deck(ansi_card_table *pTable, deck *pDeck, std::size_t x, std::size_t y)
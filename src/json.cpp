@@ -19,60 +19,71 @@
 
 #include "json.h"
 
-#include <iomanip>
+#include <array>
 
 namespace ac
 {
 
-    void write_json_string(std::ostream &oOstream, const std::string &sString)
+    /// Escape sequence for every byte: empty if the byte is copied as-is.
+    static constexpr std::array<std::string_view, 256> aJsonEscapes = []()
+    {
+        std::array<std::string_view, 256> aEscapes{};
+        constexpr std::string_view aControls[32] = {
+            "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006", "\\u0007",
+            "\\b", "\\t", "\\n", "\\u000b", "\\f", "\\r", "\\u000e", "\\u000f",
+            "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+            "\\u0018", "\\u0019", "\\u001a", "\\u001b", "\\u001c", "\\u001d", "\\u001e", "\\u001f"};
+        for (std::size_t nChar = 0; nChar < 32; ++nChar)
+            aEscapes[nChar] = aControls[nChar];
+        aEscapes['\"'] = "\\\"";
+        aEscapes['\\'] = "\\\\";
+        return aEscapes;
+    }();
+
+    void write_json_string(std::string &sBuffer, std::string_view sString)
     {
+        // Worst case is every byte escaped as \u00HH, usual case is no escapes at all
+        sBuffer.reserve(sBuffer.size() + sString.size() + 2);
+
         // Start the JSON string with a quote
-        oOstream.write("\"", 1);
+        sBuffer.push_back('\"');
 
-        for (char c : sString)
+        const char *pData = sString.data();
+        const char *pEnd = pData + sString.size();
+        const char *pRun = pData;
+        for (; pData != pEnd; ++pData)
         {
-            switch (c)
-            {
-            case '\"': // Escape double quotes
-                oOstream.write("\\\"", 2);
-                break;
-            case '\\': // Escape backslashes
-                oOstream.write("\\\\", 2);
-                break;
-            case '\b': // Escape backspace
-                oOstream.write("\\b", 2);
-                break;
-            case '\f': // Escape form feed
-                oOstream.write("\\f", 2);
-                break;
-            case '\n': // Escape newline
-                oOstream.write("\\n", 2);
-                break;
-            case '\r': // Escape carriage return
-                oOstream.write("\\r", 2);
-                break;
-            case '\t': // Escape tab
-                oOstream.write("\\t", 2);
-                break;
-            default:
-                if (c < 32 || c > 126)
-                {
-                    // Non-printable characters
-                    oOstream.write("\\x", 2);
-                    int nChar = static_cast<int32_t>(c) & 0x000000FF;
-                    oOstream << std::setw(2) << std::setfill('0') << std::hex << nChar;
-                }
-                else
-                {
-                    // Print printable characters as-is
-                    oOstream.write(&c, 1);
-                }
-                break;
-            }
+            std::string_view sEscape = aJsonEscapes[static_cast<unsigned char>(*pData)];
+            if (sEscape.empty())
+                continue;
+
+            // Copy the clean run in bulk, then the escape sequence
+            sBuffer.append(pRun, pData - pRun);
+            sBuffer.append(sEscape);
+            pRun = pData + 1;
         }
+        sBuffer.append(pRun, pEnd - pRun);
 
         // End the JSON string with a quote
-        oOstream.write("\"", 1);
+        sBuffer.push_back('\"');
+    }
+
+    void write_json_string(std::ostream &oOstream, const std::string &sString)
+    {
+        std::string sBuffer;
+        write_json_string(sBuffer, sString);
+        oOstream.write(sBuffer.data(), sBuffer.size());
+    }
+
+    int get_json_hex_digit(int c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
     }
 
 } // namespace ac
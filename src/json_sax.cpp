@@ -0,0 +1,629 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+#include "json_sax.h"
+
+#include "deck.h"
+#include "card_table.h"
+#include "unicode.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace ac
+{
+
+    static inline std::size_t parse_size(std::string_view sValue, const std::string &sKey);
+
+    json_sax_reader::json_sax_reader(std::istream &oIstream, std::size_t nBufferSize)
+        : m_oIstream(oIstream),
+          m_vBuffer(nBufferSize > 0 ? nBufferSize : DEFAULT_BUFFER_SIZE),
+          m_nPos(0),
+          m_nEnd(0),
+          m_nConsumed(0) {}
+
+    bool json_sax_reader::refill()
+    {
+        this->m_nConsumed += this->m_nEnd;
+        this->m_nPos = 0;
+        this->m_nEnd = 0;
+        if (!this->m_oIstream)
+            return false;
+        this->m_oIstream.read(this->m_vBuffer.data(), this->m_vBuffer.size());
+        this->m_nEnd = static_cast<std::size_t>(this->m_oIstream.gcount());
+        return this->m_nEnd > 0;
+    }
+
+    inline int json_sax_reader::peek()
+    {
+        if (this->m_nPos == this->m_nEnd && !this->refill())
+            return -1;
+        return static_cast<unsigned char>(this->m_vBuffer[this->m_nPos]);
+    }
+
+    inline int json_sax_reader::get()
+    {
+        if (this->m_nPos == this->m_nEnd && !this->refill())
+            return -1;
+        return static_cast<unsigned char>(this->m_vBuffer[this->m_nPos++]);
+    }
+
+    std::size_t json_sax_reader::get_offset() const noexcept
+    {
+        return this->m_nConsumed + this->m_nPos;
+    }
+
+    void json_sax_reader::skip_whitespace()
+    {
+        for (int c = this->peek(); c == ' ' || c == '\n' || c == '\r' || c == '\t'; c = this->peek())
+            ++this->m_nPos;
+    }
+
+    bool json_sax_reader::parse_next(json_sax_handler *pHandler)
+    {
+        this->skip_whitespace();
+        if (this->peek() < 0)
+            return false;
+        this->parse_value(pHandler, 0);
+        return true;
+    }
+
+    std::size_t json_sax_reader::parse(json_sax_handler *pHandler)
+    {
+        std::size_t nValues = 0;
+        while (this->parse_next(pHandler))
+            ++nValues;
+        return nValues;
+    }
+
+    void json_sax_reader::parse_value(json_sax_handler *pHandler, std::size_t nDepth)
+    {
+        if (nDepth > MAX_DEPTH)
+            this->fail("nesting too deep");
+
+        int c = this->peek();
+        switch (c)
+        {
+        case '{':
+        {
+            ++this->m_nPos;
+            pHandler->on_start_object();
+            this->skip_whitespace();
+            if (this->peek() == '}')
+            {
+                ++this->m_nPos;
+                pHandler->on_end_object();
+                return;
+            }
+            while (true)
+            {
+                if (this->get() != '\"')
+                    this->fail("expected a key");
+                this->parse_string();
+                pHandler->on_key(this->m_sToken);
+                this->skip_whitespace();
+                if (this->get() != ':')
+                    this->fail("expected \':\'");
+                this->skip_whitespace();
+                this->parse_value(pHandler, nDepth + 1);
+                this->skip_whitespace();
+                c = this->get();
+                if (c == '}')
+                    break;
+                if (c != ',')
+                    this->fail("expected \',\' or \'}\'");
+                this->skip_whitespace();
+            }
+            pHandler->on_end_object();
+            return;
+        }
+        case '[':
+        {
+            ++this->m_nPos;
+            pHandler->on_start_array();
+            this->skip_whitespace();
+            if (this->peek() == ']')
+            {
+                ++this->m_nPos;
+                pHandler->on_end_array();
+                return;
+            }
+            while (true)
+            {
+                this->parse_value(pHandler, nDepth + 1);
+                this->skip_whitespace();
+                c = this->get();
+                if (c == ']')
+                    break;
+                if (c != ',')
+                    this->fail("expected \',\' or \']\'");
+                this->skip_whitespace();
+            }
+            pHandler->on_end_array();
+            return;
+        }
+        case '\"':
+            ++this->m_nPos;
+            this->parse_string();
+            pHandler->on_value(json_type::STRING, this->m_sToken);
+            return;
+        case 't':
+            this->expect("true");
+            pHandler->on_value(json_type::BOOLEAN, "true");
+            return;
+        case 'f':
+            this->expect("false");
+            pHandler->on_value(json_type::BOOLEAN, "false");
+            return;
+        case 'n':
+            this->expect("null");
+            pHandler->on_value(json_type::NUL, "null");
+            return;
+        default:
+            this->parse_number();
+            pHandler->on_value(json_type::NUMBER, this->m_sToken);
+            return;
+        }
+    }
+
+    void json_sax_reader::parse_string()
+    {
+        this->m_sToken.clear();
+        while (true)
+        {
+            // Copy clean runs of the buffer in bulk
+            std::size_t nStart = this->m_nPos;
+            while (this->m_nPos != this->m_nEnd)
+            {
+                unsigned char c = static_cast<unsigned char>(this->m_vBuffer[this->m_nPos]);
+                if (c == '\"' || c == '\\' || c < 0x20)
+                    break;
+                ++this->m_nPos;
+            }
+            this->m_sToken.append(this->m_vBuffer.data() + nStart, this->m_nPos - nStart);
+
+            int c = this->get();
+            if (c < 0)
+                this->fail("unterminated string");
+            if (c == '\"')
+                return;
+            if (c < 0x20)
+                this->fail("control character in string");
+            if (c != '\\')
+            {
+                // The buffer ended in the middle of a clean run
+                this->m_sToken.push_back(static_cast<char>(c));
+                continue;
+            }
+
+            c = this->get();
+            switch (c)
+            {
+            case '\"':
+            case '\\':
+            case '/':
+                this->m_sToken.push_back(static_cast<char>(c));
+                break;
+            case 'b':
+                this->m_sToken.push_back('\b');
+                break;
+            case 'f':
+                this->m_sToken.push_back('\f');
+                break;
+            case 'n':
+                this->m_sToken.push_back('\n');
+                break;
+            case 'r':
+                this->m_sToken.push_back('\r');
+                break;
+            case 't':
+                this->m_sToken.push_back('\t');
+                break;
+            case 'u':
+            {
+                auto read_hex4 = [this]()
+                {
+                    std::uint32_t nValue = 0;
+                    for (std::size_t nPos = 0; nPos < 4; ++nPos)
+                    {
+                        int nDigit = get_json_hex_digit(this->get());
+                        if (nDigit < 0)
+                            this->fail("invalid unicode escape");
+                        nValue = (nValue << 4) | static_cast<std::uint32_t>(nDigit);
+                    }
+                    return nValue;
+                };
+
+                std::uint32_t nCodePoint = read_hex4();
+                if (nCodePoint >= 0xD800 && nCodePoint <= 0xDBFF)
+                {
+                    if (this->get() != '\\' || this->get() != 'u')
+                        this->fail("unpaired surrogate");
+                    std::uint32_t nLow = read_hex4();
+                    if (nLow < 0xDC00 || nLow > 0xDFFF)
+                        this->fail("unpaired surrogate");
+                    nCodePoint = 0x10000 + ((nCodePoint - 0xD800) << 10) + (nLow - 0xDC00);
+                }
+                else if (nCodePoint >= 0xDC00 && nCodePoint <= 0xDFFF)
+                {
+                    this->fail("unpaired surrogate");
+                }
+                char aUtf8[4];
+                this->m_sToken.append(aUtf8, unicode::encode_utf8(nCodePoint, aUtf8));
+                break;
+            }
+            default:
+                this->fail("invalid escape");
+            }
+        }
+    }
+
+    void json_sax_reader::parse_number()
+    {
+        // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+        this->m_sToken.clear();
+        auto is_digit = [](int c)
+        { return c >= '0' && c <= '9'; };
+        auto take_digits = [this, &is_digit]()
+        {
+            if (!is_digit(this->peek()))
+                this->fail("invalid number");
+            while (is_digit(this->peek()))
+                this->m_sToken.push_back(static_cast<char>(this->get()));
+        };
+
+        if (this->peek() == '-')
+            this->m_sToken.push_back(static_cast<char>(this->get()));
+        if (this->peek() == '0')
+        {
+            this->m_sToken.push_back(static_cast<char>(this->get()));
+            if (is_digit(this->peek()))
+                this->fail("invalid number");
+        }
+        else if (is_digit(this->peek()))
+            take_digits();
+        else
+            this->fail("invalid value");
+
+        if (this->peek() == '.')
+        {
+            this->m_sToken.push_back(static_cast<char>(this->get()));
+            take_digits();
+        }
+        if (this->peek() == 'e' || this->peek() == 'E')
+        {
+            this->m_sToken.push_back(static_cast<char>(this->get()));
+            if (this->peek() == '+' || this->peek() == '-')
+                this->m_sToken.push_back(static_cast<char>(this->get()));
+            take_digits();
+        }
+    }
+
+    void json_sax_reader::expect(std::string_view sLiteral)
+    {
+        for (char c : sLiteral)
+        {
+            if (this->get() != c)
+                this->fail("invalid literal");
+        }
+    }
+
+    void json_sax_reader::fail(const char *sMessage) const
+    {
+        throw std::runtime_error("Invalid json at offset " + std::to_string(this->get_offset()) + ": " + sMessage + ".");
+    }
+
+    deck_sax_builder::deck_sax_builder(std::function<void(deck *)> fnOnDeck)
+        : m_fnOnDeck(std::move(fnOnDeck)),
+          m_nDepth(0),
+          m_nRootDepth(0),
+          m_bInDeck(false),
+          m_bInSuits(false),
+          m_bInSuit(false),
+          m_bInNumbers(false),
+          m_bInNumber(false),
+          m_oDeck(),
+          m_nSuits(0) {}
+
+    void deck_sax_builder::on_start_object()
+    {
+        std::size_t nLevel = this->m_nDepth++;
+
+        if (!this->m_bInDeck)
+        {
+            if (nLevel != this->m_nRootDepth)
+                return;
+
+            // Deck: reuse the storage of the previous one
+            this->m_bInDeck = true;
+            this->m_oDeck = number_data();
+            this->m_nSuits = 0;
+        }
+        else if (this->m_bInSuits && !this->m_bInSuit && nLevel == this->m_nRootDepth + 2)
+        {
+            // Suit
+            this->m_bInSuit = true;
+            if (this->m_nSuits == this->m_vSuits.size())
+                this->m_vSuits.emplace_back();
+            suit_data &oSuit = this->m_vSuits[this->m_nSuits++];
+            oSuit.m_oData = number_data();
+            oSuit.m_vNumbers.clear();
+        }
+        else if (this->m_bInNumbers && !this->m_bInNumber && nLevel == this->m_nRootDepth + 4)
+        {
+            // Number
+            this->m_bInNumber = true;
+            this->m_vSuits[this->m_nSuits - 1].m_vNumbers.emplace_back();
+        }
+    }
+
+    void deck_sax_builder::on_end_object()
+    {
+        std::size_t nLevel = --this->m_nDepth;
+
+        if (!this->m_bInDeck)
+            return;
+
+        if (nLevel == this->m_nRootDepth)
+        {
+            this->m_bInDeck = false;
+            this->finish_deck();
+        }
+        else if (this->m_bInSuit && nLevel == this->m_nRootDepth + 2)
+        {
+            this->m_bInSuit = false;
+        }
+        else if (this->m_bInNumber && nLevel == this->m_nRootDepth + 4)
+        {
+            this->m_bInNumber = false;
+        }
+    }
+
+    void deck_sax_builder::on_start_array()
+    {
+        std::size_t nLevel = this->m_nDepth++;
+
+        if (!this->m_bInDeck)
+        {
+            // A top-level array contains decks
+            if (nLevel == 0)
+                this->m_nRootDepth = 1;
+            return;
+        }
+
+        if (!this->m_bInSuits && nLevel == this->m_nRootDepth + 1 && this->m_sKey == "suits")
+            this->m_bInSuits = true;
+        else if (this->m_bInSuit && !this->m_bInNumbers && nLevel == this->m_nRootDepth + 3 && this->m_sKey == "numbers")
+            this->m_bInNumbers = true;
+    }
+
+    void deck_sax_builder::on_end_array()
+    {
+        std::size_t nLevel = --this->m_nDepth;
+
+        if (!this->m_bInDeck)
+        {
+            if (nLevel == 0)
+                this->m_nRootDepth = 0;
+            return;
+        }
+
+        if (this->m_bInSuits && nLevel == this->m_nRootDepth + 1)
+            this->m_bInSuits = false;
+        else if (this->m_bInNumbers && nLevel == this->m_nRootDepth + 3)
+            this->m_bInNumbers = false;
+    }
+
+    void deck_sax_builder::on_key(std::string_view sKey)
+    {
+        this->m_sKey.assign(sKey);
+    }
+
+    void deck_sax_builder::on_value(json_type nType, std::string_view sValue)
+    {
+        if (!this->m_bInDeck || nType != json_type::STRING)
+            return;
+
+        std::size_t nLevel = this->m_nDepth - 1;
+        if (nLevel == this->m_nRootDepth)
+            this->store(this->m_oDeck, sValue);
+        else if (this->m_bInSuit && !this->m_bInNumbers && nLevel == this->m_nRootDepth + 2)
+            this->store(this->m_vSuits[this->m_nSuits - 1].m_oData, sValue);
+        else if (this->m_bInNumber && nLevel == this->m_nRootDepth + 4)
+            this->store(this->m_vSuits[this->m_nSuits - 1].m_vNumbers.back(), sValue);
+    }
+
+    void deck_sax_builder::store(number_data &oData, std::string_view sValue)
+    {
+        if (this->m_sKey == "name")
+        {
+            oData.m_sName.assign(sValue);
+            oData.m_bHasName = true;
+        }
+        else if (this->m_sKey == "display_name")
+        {
+            oData.m_sDisplayName.assign(sValue);
+            oData.m_bHasDisplayName = true;
+        }
+    }
+
+    void deck_sax_builder::finish_deck()
+    {
+        // Only the keys are checked here: the elements are validated by the builder
+        auto validate = [](const number_data &oData, const std::string &sWhat)
+        {
+            if (!oData.m_bHasName)
+                throw std::runtime_error("String with key \'name\' not found in json " + sWhat + ".");
+            if (!oData.m_bHasDisplayName)
+                throw std::runtime_error("String with key \'display_name\' not found in json " + sWhat + ".");
+        };
+
+        validate(this->m_oDeck, "deck");
+        deck_builder oBuilder(this->m_oDeck.m_sName, this->m_oDeck.m_sDisplayName);
+        for (std::size_t nSuit = 0; nSuit < this->m_nSuits; ++nSuit)
+        {
+            const suit_data &oSuitData = this->m_vSuits[nSuit];
+            validate(oSuitData.m_oData, "suit");
+            oBuilder.add_suit(oSuitData.m_oData.m_sName, oSuitData.m_oData.m_sDisplayName);
+            for (const number_data &oNumberData : oSuitData.m_vNumbers)
+            {
+                validate(oNumberData, "number");
+                oBuilder.add_number(oNumberData.m_sName, oNumberData.m_sDisplayName);
+            }
+        }
+
+        this->m_fnOnDeck(oBuilder.release());
+    }
+
+    card_table_sax_builder::card_table_sax_builder(const deck *pDeck, card_table *pTable, std::function<void(card_table *)> fnOnTable)
+        : m_pDeck(pDeck),
+          m_pTable(pTable),
+          m_fnOnTable(std::move(fnOnTable)),
+          m_nDepth(0),
+          m_nRootDepth(0),
+          m_bInTable(false),
+          m_bInCards(false),
+          m_bInCard(false),
+          m_nX(0),
+          m_nY(0),
+          m_bVisible(true)
+    {
+        if (pDeck == nullptr || pTable == nullptr)
+            throw std::invalid_argument("The deck and the table of a card_table_sax_builder can not be null.");
+    }
+
+    void card_table_sax_builder::on_start_object()
+    {
+        std::size_t nLevel = this->m_nDepth++;
+
+        if (!this->m_bInTable)
+        {
+            if (nLevel != this->m_nRootDepth)
+                return;
+
+            // Table
+            this->m_bInTable = true;
+            this->m_lHolders.clear();
+        }
+        else if (this->m_bInCards && !this->m_bInCard && nLevel == this->m_nRootDepth + 2)
+        {
+            // Card
+            this->m_bInCard = true;
+            this->m_sSuit.clear();
+            this->m_sNumber.clear();
+            this->m_nX = BEYOND_REACH;
+            this->m_nY = BEYOND_REACH;
+            this->m_bVisible = true;
+        }
+    }
+
+    void card_table_sax_builder::on_end_object()
+    {
+        std::size_t nLevel = --this->m_nDepth;
+
+        if (!this->m_bInTable)
+            return;
+
+        if (nLevel == this->m_nRootDepth)
+        {
+            // Load the whole table in one update
+            this->m_bInTable = false;
+            this->m_pTable->set_holders(std::move(this->m_lHolders));
+            this->m_lHolders.clear();
+            this->m_fnOnTable(this->m_pTable);
+        }
+        else if (this->m_bInCard && nLevel == this->m_nRootDepth + 2)
+        {
+            this->m_bInCard = false;
+
+            if (this->m_nX == BEYOND_REACH || this->m_nY == BEYOND_REACH)
+                throw std::runtime_error("Json card has no position.");
+
+            const suit *pSuit = this->m_pDeck->get_suit(this->m_sSuit);
+            const number *pNumber = pSuit != nullptr ? pSuit->get_number(this->m_sNumber) : nullptr;
+            if (pNumber == nullptr)
+                throw std::runtime_error("Json card \'" + this->m_sSuit + "/" + this->m_sNumber + "\' not found in deck.");
+
+            this->m_lHolders.emplace_back(pNumber, point(this->m_nX, this->m_nY), this->m_bVisible);
+        }
+    }
+
+    void card_table_sax_builder::on_start_array()
+    {
+        std::size_t nLevel = this->m_nDepth++;
+
+        if (!this->m_bInTable)
+        {
+            // A top-level array contains tables
+            if (nLevel == 0)
+                this->m_nRootDepth = 1;
+            return;
+        }
+
+        if (!this->m_bInCards && nLevel == this->m_nRootDepth + 1 && this->m_sKey == "cards")
+            this->m_bInCards = true;
+    }
+
+    void card_table_sax_builder::on_end_array()
+    {
+        std::size_t nLevel = --this->m_nDepth;
+
+        if (!this->m_bInTable)
+        {
+            if (nLevel == 0)
+                this->m_nRootDepth = 0;
+            return;
+        }
+
+        if (this->m_bInCards && nLevel == this->m_nRootDepth + 1)
+            this->m_bInCards = false;
+    }
+
+    void card_table_sax_builder::on_key(std::string_view sKey)
+    {
+        this->m_sKey.assign(sKey);
+    }
+
+    void card_table_sax_builder::on_value(json_type nType, std::string_view sValue)
+    {
+        if (!this->m_bInCard || this->m_nDepth - 1 != this->m_nRootDepth + 2)
+            return;
+
+        if (this->m_sKey == "suit" && nType == json_type::STRING)
+            this->m_sSuit.assign(sValue);
+        else if (this->m_sKey == "number" && nType == json_type::STRING)
+            this->m_sNumber.assign(sValue);
+        else if (this->m_sKey == "x" && nType == json_type::NUMBER)
+            this->m_nX = parse_size(sValue, this->m_sKey);
+        else if (this->m_sKey == "y" && nType == json_type::NUMBER)
+            this->m_nY = parse_size(sValue, this->m_sKey);
+        else if (this->m_sKey == "visible" && nType == json_type::BOOLEAN)
+            this->m_bVisible = sValue == "true";
+    }
+
+    std::size_t parse_size(std::string_view sValue, const std::string &sKey)
+    {
+        std::size_t nValue = 0;
+        auto oResult = std::from_chars(sValue.data(), sValue.data() + sValue.size(), nValue);
+        if (oResult.ec != std::errc() || oResult.ptr != sValue.data() + sValue.size())
+            throw std::runtime_error("Json number with key \'" + sKey + "\' is not a valid position.");
+        return nValue;
+    }
+
+} // namespace ac
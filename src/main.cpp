@@ -19,10 +19,19 @@
 
 #include "example.h"
 
+#include <iostream>
+
 using namespace ac;
 
 int main(int, char**)
 {
+    // Parallel composition must draw the same as serial composition
+    if (!example::check_parallel_composition())
+    {
+        std::cerr << "Parallel composition differs from serial composition." << std::endl;
+        return 1;
+    }
+
     example::display_poker_deck();
 
     example::display_spanish_deck();
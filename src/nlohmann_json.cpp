@@ -30,31 +30,35 @@ namespace ac
 {
 
     nlohmann_json_item::nlohmann_json_item(std::istream &oIstream)
-        : m_pJsonData(nullptr)
+        : m_pJsonData(nullptr),
+          m_bOwnsData(true)
     {
-        nlohmann::json *pJson = new nlohmann::json();
+        // Owned only once parsed, so that a parse error does not leak it
+        auto pJson = std::make_unique<nlohmann::json>();
         oIstream >> *pJson;
-        this->m_pJsonData = pJson;
+        this->m_pJsonData = pJson.release();
     }
 
-    static inline nlohmann::json *json(void *pJson) { return static_cast<nlohmann::json *>(pJson); }
-
     static inline const nlohmann::json *cjson(const void *pJson) { return static_cast<const nlohmann::json *>(pJson); }
 
     nlohmann_json_item::nlohmann_json_item(const void *pJsonData)
-        : m_pJsonData(pJsonData) {}
+        : m_pJsonData(pJsonData),
+          m_bOwnsData(false) {}
 
     nlohmann_json_item::~nlohmann_json_item()
     {
         for (auto &oIter : this->m_mReadItems)
-            delete json(oIter.second);
+            delete oIter.second;
 
         for (auto &oIter1 : this->m_mArrayItems)
             for (auto &oIter2 : oIter1.second)
-                delete json(oIter2);
+                delete oIter2;
 
         this->m_mReadItems.clear();
         this->m_mArrayItems.clear();
+
+        if (this->m_bOwnsData)
+            delete cjson(this->m_pJsonData);
     }
 
     const json_item *nlohmann_json_item::get_item(const std::string &sKey) const
@@ -97,15 +101,7 @@ namespace ac
         // Search in map
         auto pIter = this->m_mArrayItems.find(sKey);
         if (pIter != this->m_mArrayItems.cend())
-        {
-            std::vector<const json_item *> vItems;
-            vItems.reserve(pIter->second.size());
-
-            for (const auto &pChild : pIter->second)
-                vItems.push_back(pChild);
-
-            return vItems;
-        }
+            return pIter->second;
 
         // Search in object
         if (cjson(this->m_pJsonData)->contains(sKey))
@@ -113,19 +109,12 @@ namespace ac
             const nlohmann::json *pJson = &cjson(this->m_pJsonData)->at(sKey);
             if (pJson->is_array())
             {
-                std::vector<json_item *> vItems;
-                std::vector<const json_item *> vConstItems;
-
+                std::vector<const json_item *> vItems;
                 vItems.reserve(pJson->size());
                 for (const auto &oChild : *pJson)
-                {
-                    nlohmann_json_item *pItem = new nlohmann_json_item(&oChild);
-                    vItems.push_back(pItem);
-                    vConstItems.push_back(pItem);
-                }
-
-                this->m_mArrayItems.insert({sKey, vItems});
-                return vConstItems;
+                    vItems.push_back(new nlohmann_json_item(&oChild));
+
+                return this->m_mArrayItems.emplace(sKey, std::move(vItems)).first->second;
             }
         }
 
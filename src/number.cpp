@@ -23,8 +23,6 @@
 #include "deck.h"
 #include "json.h"
 
-#include <sstream>
-
 namespace ac
 {
 
@@ -97,21 +95,28 @@ namespace ac
     }
 
     void number::to_json(std::ostream &oOstream) const
+    {
+        std::string sBuffer;
+        this->to_json(sBuffer);
+        oOstream.write(sBuffer.data(), sBuffer.size());
+    }
+
+    void number::to_json(std::string &sBuffer) const
     {
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
-        oOstream << "{ name: ";
-        write_json_string(oOstream, this->m_sName);
-        oOstream << ", display_name: ";
-        write_json_string(oOstream, this->m_sDisplayName);
-        oOstream << " }";
+        sBuffer.append("{\"name\":");
+        write_json_string(sBuffer, this->m_sName);
+        sBuffer.append(",\"display_name\":");
+        write_json_string(sBuffer, this->m_sDisplayName);
+        sBuffer.push_back('}');
     }
 
     std::string number::to_json() const
     {
-        std::ostringstream oStream;
-        this->to_json(oStream);
-        return oStream.str();
+        std::string sBuffer;
+        this->to_json(sBuffer);
+        return sBuffer;
     }
 
 } // namespace ac
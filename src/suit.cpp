@@ -20,8 +20,6 @@
 #include "suit.h"
 
 #include "json.h"
-#include <iterator>
-#include <sstream>
 
 namespace ac
 {
@@ -165,35 +163,52 @@ namespace ac
         return pSuit;
     }
 
+    number *suit::emplace_number_unlocked(const std::string &sName, const std::string &sDisplayName)
+    {
+        number *pNumber = new number(this, sName, sDisplayName);
+        auto [pIter, bInserted] = this->m_mNumbers.try_emplace(sName, pNumber);
+        if (!bInserted)
+        {
+            delete pIter->second;
+            pIter->second = pNumber;
+        }
+        return pNumber;
+    }
+
     void suit::to_json(std::ostream &oOstream) const
+    {
+        std::string sBuffer;
+        this->to_json(sBuffer);
+        oOstream.write(sBuffer.data(), sBuffer.size());
+    }
+
+    void suit::to_json(std::string &sBuffer) const
     {
         std::lock_guard<std::mutex> oLock(this->m_oMutex);
 
-        oOstream << "{ name: ";
-        write_json_string(oOstream, this->m_sName);
-        oOstream << ", display_name: ";
-        write_json_string(oOstream, this->m_sDisplayName);
-        oOstream << ", numbers: [ ";
+        sBuffer.append("{\"name\":");
+        write_json_string(sBuffer, this->m_sName);
+        sBuffer.append(",\"display_name\":");
+        write_json_string(sBuffer, this->m_sDisplayName);
+        sBuffer.append(",\"numbers\":[");
 
-        auto pIter = this->m_mNumbers.cbegin();
-        while (pIter != this->m_mNumbers.cend())
+        bool bFirst = true;
+        for (const auto &oIter : this->m_mNumbers)
         {
-            pIter->second->to_json(oOstream);
-
-            if (std::next(pIter) != this->m_mNumbers.cend())
-                oOstream.write(", ", 2);
-
-            pIter = std::next(pIter);
+            if (!bFirst)
+                sBuffer.push_back(',');
+            oIter.second->to_json(sBuffer);
+            bFirst = false;
         }
 
-        oOstream << " ] }";
+        sBuffer.append("]}");
     }
 
     std::string suit::to_json() const
     {
-        std::ostringstream oStream;
-        this->to_json(oStream);
-        return oStream.str();
+        std::string sBuffer;
+        this->to_json(sBuffer);
+        return sBuffer;
     }
 
 } // namespace ac
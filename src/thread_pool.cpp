@@ -0,0 +1,154 @@
+/*
+ * This file is part of AnsiCards.
+ *
+ * AnsiCards is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * AnsiCards is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with AnsiCards.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Dante Doménech Martínez
+ */
+
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace ac
+{
+
+    thread_pool::thread_pool(std::size_t nWorkers)
+        : m_pTask(nullptr),
+          m_nTasks(0),
+          m_nNext(0),
+          m_nCompleted(0),
+          m_nJob(0),
+          m_bOpen(false),
+          m_nActive(0),
+          m_bStop(false)
+    {
+        for (std::size_t nWorker = 0; nWorker < nWorkers; ++nWorker)
+            this->m_vWorkers.emplace_back(&thread_pool::work, this);
+    }
+
+    thread_pool::~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            this->m_bStop = true;
+        }
+        this->m_oStarted.notify_all();
+        for (std::thread &oWorker : this->m_vWorkers)
+            oWorker.join();
+    }
+
+    thread_pool &thread_pool::get_shared()
+    {
+        static thread_pool s_oShared(std::max<unsigned>(std::thread::hardware_concurrency(), 1) - 1);
+        return s_oShared;
+    }
+
+    std::size_t thread_pool::get_thread_count() const
+    {
+        return this->m_vWorkers.size() + 1;
+    }
+
+    void thread_pool::run(std::size_t nTasks, const std::function<void(std::size_t)> &fnTask)
+    {
+        // Busy pools do not make the caller wait
+        std::unique_lock<std::mutex> oRun(this->m_oRunMutex, std::try_to_lock);
+        if (!oRun.owns_lock() || this->m_vWorkers.empty() || nTasks < 2)
+        {
+            for (std::size_t nTask = 0; nTask < nTasks; ++nTask)
+                fnTask(nTask);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            this->m_pTask = &fnTask;
+            this->m_nTasks = nTasks;
+            this->m_nNext = 0;
+            this->m_nCompleted = 0;
+            this->m_pException = nullptr;
+            this->m_bOpen = true;
+            ++this->m_nJob;
+        }
+        this->m_oStarted.notify_all();
+        this->run_tasks();
+
+        // Once every task ended, no worker may join, and the ones in the job leave it
+        std::exception_ptr pException;
+        {
+            std::unique_lock<std::mutex> oLock(this->m_oMutex);
+            this->m_oEnded.wait(oLock, [this]()
+                                { return this->m_nCompleted == this->m_nTasks; });
+            this->m_bOpen = false;
+            this->m_oEnded.wait(oLock, [this]()
+                                { return this->m_nActive == 0; });
+            this->m_pTask = nullptr;
+            pException = std::exchange(this->m_pException, nullptr);
+        }
+        if (pException != nullptr)
+            std::rethrow_exception(pException);
+    }
+
+    void thread_pool::run_tasks()
+    {
+        std::size_t nCompleted = 0;
+        std::exception_ptr pException;
+        for (std::size_t nTask = this->m_nNext++; nTask < this->m_nTasks; nTask = this->m_nNext++)
+        {
+            try
+            {
+                (*this->m_pTask)(nTask);
+            }
+            catch (...)
+            {
+                if (pException == nullptr)
+                    pException = std::current_exception();
+            }
+            ++nCompleted;
+        }
+
+        std::lock_guard<std::mutex> oLock(this->m_oMutex);
+        this->m_nCompleted += nCompleted;
+        if (pException != nullptr && this->m_pException == nullptr)
+            this->m_pException = pException;
+        if (this->m_nCompleted == this->m_nTasks)
+            this->m_oEnded.notify_all();
+    }
+
+    void thread_pool::work()
+    {
+        std::size_t nJob = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> oLock(this->m_oMutex);
+                this->m_oStarted.wait(oLock, [this, &nJob]()
+                                      { return this->m_bStop || (this->m_bOpen && this->m_nJob != nJob); });
+                if (this->m_bStop)
+                    return;
+                nJob = this->m_nJob;
+                ++this->m_nActive;
+            }
+
+            this->run_tasks();
+
+            std::lock_guard<std::mutex> oLock(this->m_oMutex);
+            if (--this->m_nActive == 0)
+                this->m_oEnded.notify_all();
+        }
+    }
+
+} // namespace ac